@@ -0,0 +1,125 @@
+#pragma once
+
+// ==========================================
+// ALERT DIGEST (PORTABLE CORE)
+// ==========================================
+// Folds alert notifications into one Telegram digest per window. Humidity
+// hovering around its threshold then costs one message per window, not one
+// per crossing. Urgent rules (ALARM_NOTIFY_URGENT: gas) always go out at
+// once.
+//
+// The first notification after a quiet window goes out at once and opens
+// a window. Notifications during the window are counted per alert, along
+// with the range of the rule's measured value. When the window ends with
+// something counted, one digest goes out and the next window starts.
+// A window that ends empty closes, so the next alert is immediate again.
+// While muted (/mute), nothing but urgent alerts goes out at once; the
+// digest then covers the whole mute.
+
+#include <Arduino.h>
+#include "silo_logic.h"
+
+#define ALERT_DIGEST_WINDOW_MS 600000   // 10 min
+#define ALERT_MUTE_MAX_MS 86400000      // /mute is capped at 24 h
+
+class AlertDigest {
+ public:
+  // True when the event should be sent now; otherwise it was folded in
+  bool add(const AlarmEvent& e, const SiloReadings& r, uint32_t now) {
+    const AlarmRule& rule = *e.rule;
+    if (rule.notify & ALARM_NOTIFY_URGENT) return true;
+    bool muted = this->muted(now);
+    if (!open_ && !muted) {
+      open_ = true;
+      startMs_ = now;
+      return true;
+    }
+    if (!open_) {
+      open_ = true;
+      startMs_ = now;
+    }
+    Entry& d = entries_[rule.code];
+    if (e.kind == ALARM_CLEARED) d.cleared++;
+    else d.alerts++;
+    if (rule.measure) {
+      float v = rule.measure(r);
+      if (d.alerts + d.cleared == 1 || v < d.min) d.min = v;
+      if (d.alerts + d.cleared == 1 || v > d.max) d.max = v;
+      d.unit = rule.unit;
+      d.measured = true;
+    }
+    folded++;
+    return false;
+  }
+
+  // At most one digest per call, written to buf when a window closes with
+  // something in it. Returns its length, 0 if there is nothing to send.
+  int poll(uint32_t now, const char* status, char* buf, size_t cap) {
+    if (muted(now)) return 0;
+    if (!open_) {
+      muteUntilMs_ = 0;
+      return 0;
+    }
+    // A mute that just ended is reported at once
+    bool unmuted = muteUntilMs_ != 0;
+    if (!unmuted && now - startMs_ < ALERT_DIGEST_WINDOW_MS) return 0;
+    uint32_t minutes = (now - startMs_ + 30000) / 60000;
+    muteUntilMs_ = 0;
+
+    bool any = false;
+    for (const Entry& d : entries_) any |= d.alerts || d.cleared;
+    if (!any) {
+      open_ = false;
+      return 0;
+    }
+
+    int n = snprintf(buf, cap, "🧾 Last %u min:", (unsigned)minutes);
+    const char* sep = " ";
+    for (uint8_t code = 1; code < SILO_ALERT_COUNT && n < (int)cap; code++) {
+      Entry& d = entries_[code];
+      if (!d.alerts && !d.cleared) continue;
+      n += snprintf(buf + n, cap - n, "%s%s %u×", sep, ALERT_NAME[code], (unsigned)d.alerts);
+      if (d.measured && n < (int)cap) n += snprintf(buf + n, cap - n, " (%.1f-%.1f%s)", d.min, d.max, d.unit);
+      if (d.cleared && n < (int)cap) n += snprintf(buf + n, cap - n, ", %u cleared", (unsigned)d.cleared);
+      sep = "; ";
+      d = Entry();
+    }
+    if (n < (int)cap) n += snprintf(buf + n, cap - n, ". Now: %s", status);
+    startMs_ = now;
+    digests++;
+    return n < (int)cap ? n : (int)cap - 1;
+  }
+
+  // Hold back all but urgent alerts for ms (0 = unmute now)
+  void mute(uint32_t ms, uint32_t now) {
+    if (ms > ALERT_MUTE_MAX_MS) ms = ALERT_MUTE_MAX_MS;
+    // Non-zero from here until the digest after the mute is out
+    muteUntilMs_ = now + ms ? now + ms : 1;
+    if (ms && !open_) {
+      open_ = true;
+      startMs_ = now;
+    }
+  }
+
+  bool muted(uint32_t now) const { return muteUntilMs_ && (int32_t)(now - muteUntilMs_) < 0; }
+  uint32_t muteLeftMs(uint32_t now) const { return muted(now) ? muteUntilMs_ - now : 0; }
+
+  // Stats
+  uint32_t folded = 0;   // Notifications that went into a digest instead
+  uint32_t digests = 0;  // Digest messages produced
+
+ private:
+  struct Entry {
+    uint16_t alerts = 0;   // Raises, reminders and escalations
+    uint16_t cleared = 0;
+    float min = 0;
+    float max = 0;
+    const char* unit = "";
+    bool measured = false;
+  };
+
+  Entry entries_[SILO_ALERT_COUNT];
+  bool open_ = false;
+  uint32_t startMs_ = 0;
+  uint32_t muteUntilMs_ = 0;
+};
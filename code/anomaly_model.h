@@ -0,0 +1,36 @@
+#pragma once
+
+// ==========================================
+// ISOLATION FOREST MODEL (GENERATED)
+// ==========================================
+// Placeholder: no model has been exported yet, so on-device anomaly
+// scoring is disabled. Run `python export_anomaly_model.py` in ml/ to
+// train a forest on your silo's data and overwrite this file.
+// Nodes are in pre-order: the left child of node i is i + 1, the right
+// child is kIForestRight[i]. kIForestFeature[i] < 0 marks a leaf, whose
+// kIForestValue[i] is its path length; otherwise kIForestValue[i] is the
+// split threshold in raw sensor units (x <= threshold goes left).
+
+#include <Arduino.h>
+
+constexpr uint16_t kIForestTrees = 0;
+constexpr uint8_t kIForestFeatures = 14;
+constexpr uint16_t kIForestWindow = 30;  // Rolling window (samples)
+constexpr float kIForestPathNorm = 1.0f;  // c(max_samples)
+constexpr float kIForestOffset = -0.5f;  // sklearn offset_
+
+constexpr uint16_t kIForestRoot[] PROGMEM = {
+  0,
+};
+
+constexpr int8_t kIForestFeature[] PROGMEM = {
+  -1,
+};
+
+constexpr float kIForestValue[] PROGMEM = {
+  0.0f,
+};
+
+constexpr uint16_t kIForestRight[] PROGMEM = {
+  0,
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+// ==========================================
+// ON-DEVICE ISOLATION FOREST SCORER
+// ==========================================
+// Scores every new history sample with the forest exported by
+// ml/export_anomaly_model.py (anomaly_model.h). The features match
+// engineer_features() in ml/anomaly_detection.py:
+//   temperature, humidity, gas_value,
+//   <col>_rolling_mean, <col>_rolling_std, <col>_rate  (for each of the three)
+//   gas_temp_ratio, temp_hum_diff
+//
+// Rolling mean/std are O(1) per sample: integer running sums over the
+// fixed-point history values, adding the new sample and subtracting the one
+// that just left the window (it's still in the ring buffer). Sums are exact,
+// so they never drift. The exporter folds the StandardScaler into the tree
+// thresholds, so raw units go straight into the trees.
+
+#include <Arduino.h>
+#include "sample_history.h"
+#include "anomaly_model.h"
+
+#define ANOMALY_CONFIRM_SAMPLES 3    // Consecutive anomalous samples before alerting
+
+static_assert(kIForestFeatures == 14, "anomaly_model.h does not match the scorer's features");
+static_assert(kIForestWindow > 0 && kIForestWindow < HISTORY_CAPACITY, "rolling window must fit the history");
+
+class AnomalyScorer {
+ public:
+  explicit AnomalyScorer(const SampleHistory& history) : history_(history) {}
+
+  static constexpr bool enabled() { return kIForestTrees > 0; }
+
+  // Feed the newest history sample. Returns true if it was scored.
+  bool update() {
+    if (!enabled() || history_.empty()) return false;
+    uint32_t seq = history_.nextSeq() - 1;
+    int32_t t = history_.tempCentiAt(seq);
+    int32_t h = history_.humHalfAt(seq);
+    int32_t g = history_.gasAt(seq);
+
+    // Training rows with missing climate data were dropped, so a gap
+    // restarts the window rather than averaging across it.
+    if (t == HISTORY_TEMP_NONE || h == HISTORY_HUM_NONE) {
+      reset();
+      return false;
+    }
+
+    uint32_t start = micros();
+    if (count_ == kIForestWindow) {
+      uint32_t old = seq - kIForestWindow;
+      temp_.remove(history_.tempCentiAt(old));
+      hum_.remove(history_.humHalfAt(old));
+      gas_.remove(history_.gasAt(old));
+      count_--;
+    }
+    float rateT = count_ ? (t - lastT_) / 100.0f : 0;
+    float rateH = count_ ? (h - lastH_) / 2.0f : 0;
+    float rateG = count_ ? (float)(g - lastG_) : 0;
+    temp_.add(t);
+    hum_.add(h);
+    gas_.add(g);
+    count_++;
+    lastT_ = t;
+    lastH_ = h;
+    lastG_ = g;
+
+    float x[kIForestFeatures];
+    x[0] = t / 100.0f;
+    x[1] = h / 2.0f;
+    x[2] = g;
+    x[3] = temp_.mean(count_) / 100.0f;
+    x[4] = temp_.stddev(count_) / 100.0f;
+    x[5] = rateT;
+    x[6] = hum_.mean(count_) / 2.0f;
+    x[7] = hum_.stddev(count_) / 2.0f;
+    x[8] = rateH;
+    x[9] = gas_.mean(count_);
+    x[10] = gas_.stddev(count_);
+    x[11] = rateG;
+    x[12] = x[2] / (x[0] + 1e-6f);
+    x[13] = x[0] - x[1];
+
+    decision_ = score(x);
+    anomalous_ = decision_ < 0;
+    streak_ = anomalous_ ? (streak_ < 255 ? streak_ + 1 : 255) : 0;
+    lastScoreUs = micros() - start;
+    scored++;
+    if (anomalous_) anomalies++;
+    return true;
+  }
+
+  void reset() {
+    temp_ = Sums();
+    hum_ = Sums();
+    gas_ = Sums();
+    count_ = 0;
+    streak_ = 0;
+    anomalous_ = false;
+  }
+
+  // Same convention as sklearn's decision_function(): negative = anomaly
+  float decision() const { return decision_; }
+  bool anomalous() const { return anomalous_; }
+  // Anomalous for long enough to be worth an alert
+  bool confirmed() const { return streak_ >= ANOMALY_CONFIRM_SAMPLES; }
+
+  uint32_t scored = 0;
+  uint32_t anomalies = 0;
+  uint32_t lastScoreUs = 0;
+
+ private:
+  struct Sums {
+    int64_t sum = 0;
+    int64_t sumSq = 0;
+    void add(int32_t v) { sum += v; sumSq += (int64_t)v * v; }
+    void remove(int32_t v) { sum -= v; sumSq -= (int64_t)v * v; }
+    float mean(uint16_t n) const { return (float)sum / n; }
+    // Sample standard deviation (ddof = 1, like pandas); 0 for a single value
+    float stddev(uint16_t n) const {
+      if (n < 2) return 0;
+      float var = ((float)sumSq - (float)sum * sum / n) / (n - 1);
+      return var > 0 ? sqrtf(var) : 0;
+    }
+  };
+
+  // Average path length over all trees -> sklearn's score_samples() -> offset
+  static float score(const float* x) {
+    float depth = 0;
+    for (uint16_t t = 0; t < kIForestTrees; t++) {
+      uint16_t i = pgm_read_word(&kIForestRoot[t]);
+      int8_t f;
+      while ((f = (int8_t)pgm_read_byte(&kIForestFeature[i])) >= 0) {
+        i = x[f] <= pgm_read_float(&kIForestValue[i]) ? i + 1 : pgm_read_word(&kIForestRight[i]);
+      }
+      depth += pgm_read_float(&kIForestValue[i]);
+    }
+    float trees = kIForestTrees; // Never 0 here, see enabled()
+    float s = exp2f(-(depth / trees) / kIForestPathNorm);
+    return -s - kIForestOffset;
+  }
+
+  const SampleHistory& history_;
+  Sums temp_, hum_, gas_;
+  uint16_t count_ = 0;
+  int32_t lastT_ = 0, lastH_ = 0, lastG_ = 0;
+  float decision_ = 0;
+  bool anomalous_ = false;
+  uint8_t streak_ = 0;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+// ==========================================
+// FAST BOOT STATE + RESET LOG
+// ==========================================
+// A watchdog reset or a crash used to bring the silo back knowing
+// nothing: fan off, gas filter warming up, every alert re-announced. Now
+// the control state is written to RTC memory after every fan decision
+// (BootState, CRC-checked). setup() restores it and makes the first relay
+// and alarm decision before anything slow starts (LittleFS, the probe
+// search, WiFi); /tasks shows how many ms after reset that happened.
+// RTC memory survives resets but not power loss. After a power-up the CRC
+// fails, and the silo starts from defaults as before.
+//
+// Restored: the fan state, how long it has been held and any remote
+// override; the gas filter, its baseline and alarm latch; the last climate
+// reading, trusted for DHT_STALE_MS like a fresh one; the active alerts,
+// what was announced, and each rule's cooldown. Not restored: the history
+// (the journal has it), the fan duty window, the forecast and anomaly
+// models, and MQTT thresholds (retain them on the broker).
+//
+// ResetLog keeps the last RESET_LOG_MAX resets in LittleFS: the reason,
+// the exception cause and address, and how long the run before it lasted
+// (BootState's uptime, so only known after a reset, not a power-up).
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "rtc_store.h"
+#include "silo_logic.h"
+
+#define RTC_SLOT_BOOT 118            // BootState, 10 blocks
+#define BOOT_STATE_LAYOUT 1          // Raise when BootState changes meaning
+// Mixed into the slot CRC: a state saved with another layout or alarm
+// table (by the firmware before an update) is not restored
+#define BOOT_STATE_TAG (BOOT_STATE_LAYOUT << 8 | ALARM_RULE_COUNT)
+#define RESET_LOG_FILE "/resets.log"
+#define RESET_LOG_MAX 8
+
+enum BootFlags : uint8_t {
+  BOOT_FAN_ON = 1 << 0,
+  BOOT_GAS_ALARM = 1 << 1,
+  BOOT_GAS_WARM = 1 << 2,
+  BOOT_CLIMATE_OK = 1 << 3,
+  BOOT_OVERRIDE_SHIFT = 4,           // Two bits: FanController::Override
+};
+
+struct BootState {
+  uint32_t uptimeS;                  // When saved: how long that run had lasted
+  uint16_t gasEmaQ4;                 // GasChannel filter state (ADC counts, Q4)
+  uint16_t gasBaselineQ4;
+  uint16_t fanHeldS;                 // Since the last relay switch
+  uint16_t fanOverrideMin;           // Remote override left
+  int16_t tempCenti;                 // Last good climate reading
+  uint8_t humHalf;                   // Humidity, 0.5 % steps
+  uint8_t flags;                     // BootFlags
+  AlarmEngine::Memory alarms;
+};
+static_assert(RTC_SLOT_BOOT + sizeof(RtcSlot<BootState>) / 4 <= RTC_USER_BLOCKS,
+              "BootState doesn't fit in RTC memory");
+
+struct ResetEntry {
+  uint32_t boot;                     // Boot number, counted in the log
+  uint32_t ranS;                     // Uptime of the run that ended, 0 = unknown
+  uint32_t epc1;                     // Exception address
+  uint8_t reason;                    // REASON_* (user_interface.h, platform.h)
+  uint8_t exccause;
+  uint16_t reserved;
+};
+
+class ResetLog {
+ public:
+  // Add this boot, newest first. Needs LittleFS mounted.
+  void record(uint32_t ranS) {
+    load();
+    PlatformReset info = platformReset();
+    memmove(&log_.entries[1], &log_.entries[0], sizeof(ResetEntry) * (RESET_LOG_MAX - 1));
+    ResetEntry& e = log_.entries[0];
+    e = ResetEntry();
+    e.boot = ++log_.boots;
+    e.ranS = ranS;
+    e.reason = info.reason;
+    if (info.reason == REASON_EXCEPTION_RST) {
+      e.exccause = info.exccause;
+      e.epc1 = info.epc1;
+    }
+    if (log_.count < RESET_LOG_MAX) log_.count++;
+    save();
+  }
+
+  uint8_t count() const { return log_.count; }
+  const ResetEntry& entry(uint8_t i) const { return log_.entries[i]; }  // 0 = this boot
+
+  static const char* reasonName(uint8_t reason) {
+    static const char* const names[] = { "power-on", "hw-watchdog", "exception", "soft-watchdog",
+                                         "restart", "deep-sleep", "reset-pin" };
+    return reason < sizeof(names) / sizeof(names[0]) ? names[reason] : "unknown";
+  }
+
+ private:
+  struct Log {
+    uint32_t boots = 0;
+    uint32_t count = 0;
+    ResetEntry entries[RESET_LOG_MAX] = {};
+  };
+
+  // Same CRC framing as the RTC slots; a bad file starts a new log
+  void load() {
+    File f = LittleFS.open(RESET_LOG_FILE, "r");
+    if (!f) return;
+    RtcSlot<Log> slot;
+    bool ok = f.read((uint8_t*)&slot, sizeof(slot)) == sizeof(slot) &&
+              slot.crc == rtcCrc(&slot.value, sizeof(slot.value), sizeof(slot.value));
+    f.close();
+    if (ok) log_ = slot.value;
+  }
+
+  void save() {
+    File f = LittleFS.open(RESET_LOG_FILE, "w");
+    if (!f) return;
+    RtcSlot<Log> slot = { rtcCrc(&log_, sizeof(log_), sizeof(log_)), log_ };
+    f.write((const uint8_t*)&slot, sizeof(slot));
+    f.close();
+  }
+
+  Log log_;
+};
@@ -1,8 +1,37 @@
-#include <ESP8266WiFi.h>
-#include <ESP8266WebServer.h>
+#include "platform.h"           // ESP8266, or ESP32 with one core per side (SILO_DUAL_CORE)
 #include <DHT.h>
-#include <ESP8266HTTPClient.h>  // ---> NEW: For Telegram
 #include <WiFiClientSecure.h>   // ---> NEW: For Secure Telegram connection
+#include "telegram_notifier.h"  // Queued, non-blocking Telegram sender
+#include "sample_history.h"     // Compact in-RAM trend buffer
+#include "sample_journal.h"     // Flash-backed sample journal (LittleFS)
+#include "thingspeak_uploader.h" // Batched bulk_update uploads
+#include "window_stats.h"       // Per-window upload summaries (UPLOAD_WINDOW_S)
+#include "scheduler.h"          // Cooperative task scheduler
+#include "motion_sensor.h"      // Interrupt-driven, debounced PIR
+#include "dht_sampler.h"        // Rate-limited, cached DHT readings
+#include "probe_set.h"          // Grain probes at depth, read in parallel (GRAIN_PROBES)
+#if GRAIN_PROBES
+#include "probe_drivers.h"      // DHT, SHT3x (I2C) and DS18B20 (OneWire) probe buses
+#endif
+#include "gas_channel.h"        // Oversampled, filtered MQ-2 with hysteresis
+#include "anomaly_scorer.h"     // On-device Isolation Forest
+#include "mold_forecaster.h"    // On-device humidity forecast (fixed point)
+#include "fan_controller.h"     // Table-driven fan policy with hysteresis
+#include "wifi_manager.h"       // Background connect with cached AP
+#include "power_manager.h"      // Modem/deep sleep, RTC sample accumulator
+#include "boot_state.h"         // Control state in RTC memory, reset log
+#include "core_link.h"          // Control <-> network handoff (lock-free rings on the ESP32)
+#include "espnow_link.h"        // Multi-silo: node -> gateway frames
+#include "silo_gateway.h"       // Multi-silo: gateway aggregation + uploads
+#include "mqtt_client.h"        // Persistent MQTT link (telemetry + commands)
+#include "ota_updater.h"        // Background firmware updates with rollback (OTA_ENABLED)
+#include "live_events.h"        // Push updates to open dashboards (/events)
+#include "dashboard_assets.h"   // Gzipped dashboard page, CSS, JS (generated)
+#include "perf_metrics.h"       // Cycle-counter probes, Prometheus /metrics
+#include "silo_logic.h"         // Alarm decision (portable, see host/)
+#include "alert_digest.h"       // Alert digests and /mute (portable)
+#include "dashboard_render.h"   // /lite page and /events JSON (portable)
+#include "trace_replay.h"       // TRACE_REPLAY: recorded frames in, decisions out
 
 // ---> WI-FI CREDENTIALS <---
 const char* ssid = "Prakash-thinkpad";      
@@ -10,130 +39,1454 @@ const char* password = "12345678";
 
 // ---> THINGSPEAK DETAILS <---
 const char* apiKey = "RM25QSPWM80IK75K"; 
-const char* serverName = "api.thingspeak.com";
+const char* channelId = "YOUR_CHANNEL_ID"; // Same as THINGSPEAK_CHANNEL_ID in ml/.env
+#ifndef UPLOAD_WINDOW_S
+#define UPLOAD_WINDOW_S 300 // One summary per window to ThingSpeak (UPLOAD_WINDOW_S in ml/config.py); 0 = every sample
+#endif
+// Deep-sleep silos upload their RTC batch sample by sample; nodes upload nothing
+#define UPLOAD_WINDOWS (UPLOAD_WINDOW_S && SILO_ROLE != SILO_NODE && POWER_MODE != POWER_DEEP_SLEEP)
 
 // ---> TELEGRAM DETAILS <---
-String botToken = "8602575235:AAGDqaayoe70_Ju1QBZaEZfeaYlMZfmfzqk";
-String chatId = "2142292504"; 
-unsigned long lastTelegramMsg = 0; // Cooldown timer
+const char* botToken = "8602575235:AAGDqaayoe70_Ju1QBZaEZfeaYlMZfmfzqk";
+const char* chatId = "2142292504"; 
+// api.telegram.org pin from ml/tls_pin.py: PEM public key or SHA-1 fingerprint. Empty = not verified
+const char* telegramPin = "";
+#define TELEGRAM_COMMANDS 1     // 1 = /status, /fan and /mute from the chat (standalone, always-on)
 
+// ---> MULTI-SILO SITE (SILO_ROLE in espnow_link.h) <---
+#define SILO_NODE_ID 1 // Node: unique per silo, 1..255
+const uint8_t gatewayMac[6] = { 0, 0, 0, 0, 0, 0 }; // Node: printed by the gateway at boot (zeros = broadcast)
+const char* siteChannelId = "YOUR_SITE_CHANNEL_ID"; // Gateway: one ThingSpeak channel for all nodes
+const char* siteApiKey = "YOUR_SITE_WRITE_KEY";
+
+#if SILO_ROLE != SILO_STANDALONE && POWER_MODE != POWER_ALWAYS_ON
+#error "ESP-NOW nodes and gateways need POWER_ALWAYS_ON"
+#endif
+
+// ---> MQTT (optional, your own broker) <---
+#ifndef MQTT_ENABLED
+#define MQTT_ENABLED 0  // 1 = live samples, alerts and commands over MQTT
+#endif
+const char* mqttHost = "192.168.1.10";
+const uint16_t mqttPort = 1883;
+const char* mqttUser = "";      // Empty = anonymous
+const char* mqttPassword = "";
+#define MQTT_TOPIC "silo/1"     // Base topic: /sample, /alert, /cmd, /ack, /status
+#define MQTT_FAN_OVERRIDE_MS 3600000 // Remote fan override lasts this long by default
+#define MQTT_ARCHIVE_FLUSH_MS 300000 // ThingSpeak batches while MQTT carries the live view
+
+#if MQTT_ENABLED && SILO_ROLE == SILO_NODE
+#error "ESP-NOW nodes have no IP link; enable MQTT on the gateway"
+#endif
+
+// ---> FIRMWARE UPDATES (optional, your own HTTP server) <---
+#ifndef OTA_ENABLED
+#define OTA_ENABLED 0   // 1 = fetch new releases in the background (ota_updater.h)
+#endif
+#define FIRMWARE_VERSION 1 // Raise for every release; code/ota/build_release.py reads it from here
+const char* otaHost = "192.168.1.10";
+const uint16_t otaPort = 8080;
+const char* otaManifest = "/silo/releases.txt"; // Release index on that server
+
+#if OTA_ENABLED && (SILO_ROLE == SILO_NODE || POWER_MODE != POWER_ALWAYS_ON)
+#error "OTA updates need WiFi all the time: an always-on standalone silo or gateway"
+#endif
+
+#if TRACE_REPLAY && (SILO_ROLE != SILO_STANDALONE || POWER_MODE != POWER_ALWAYS_ON)
+#error "TRACE_REPLAY replays a standalone, always-on silo"
+#endif
+
+#if SILO_DUAL_CORE && (SILO_ROLE != SILO_STANDALONE || POWER_MODE != POWER_ALWAYS_ON || OTA_ENABLED || TRACE_REPLAY)
+#error "The ESP32 build is a standalone, always-on silo, without OTA updates or trace replay"
+#endif
+
+#if SILO_DUAL_CORE
+// ESP32 DevKit. The MQ-2 needs an ADC1 pin (ADC2 belongs to the radio) and
+// a divider to 3.3 V; setup() reads it at 10 bits, like the ESP8266's A0.
+#define DHTPIN 4
+#define PIR_PIN 27
+#define BUZZER_PIN 25
+#define GAS_PIN 34
+#define RELAY_PIN 26    // Exhaust Fan Relay
+#define PROBE_ONEWIRE_PIN 13 // Grain probes: DS18B20 string (4.7k pull-up)
+// Grain probes: SHT3x on I2C, SDA 21 / SCL 22 (the Wire defaults)
+#else
 #define DHTPIN D4       
-#define DHTTYPE DHT11  
 #define PIR_PIN D5      
 #define BUZZER_PIN D7  
 #define GAS_PIN A0      
 #define RELAY_PIN D6    // Exhaust Fan Relay
+// D0 (GPIO16) -> RST for POWER_DEEP_SLEEP timer wakes
+#define PROBE_ONEWIRE_PIN D3 // Grain probes: DS18B20 string (4.7k pull-up, keeps GPIO0 high at boot)
+// Grain probes: SHT3x on I2C, SDA D2 / SCL D1 (the Wire defaults)
+#endif
+#define DHTTYPE DHT11  
+
+#define HUM_ALARM_PCT 60.0 // Mold risk above this (default; MQTT can change it)
 
 // ---> HARDWARE CHEAT CODE <---
 #define RELAY_ON LOW    // For Active-LOW relays
 #define RELAY_OFF HIGH  
 
 DHT dht(DHTPIN, DHTTYPE);
+DhtSampler climate(dht, DHTTYPE);
 ESP8266WebServer server(80);
-WiFiClient client;
+TelegramNotifier telegram(botToken, chatId, telegramPin);
+MotionSensor pir;
+GasChannel gas(GAS_PIN);
+SampleHistory history;
+#if SILO_DUAL_CORE
+SampleHistory controlHistory;  // The control core's copy, for the models
+#else
+SampleHistory& controlHistory = history;
+#endif
+SampleJournal journal;
+ThingSpeakUploader thingspeak(history, channelId, apiKey);
+WindowAggregator windowStats;  // Control side: the open window
+WindowLog windowLog;           // Network side: closed windows for ThingSpeak
+AnomalyScorer anomaly(controlHistory);
+MoldForecaster forecast;
+FanController fan;
+WifiManager wifi;
+PowerManager power;
+MqttClient mqtt;
+LiveEvents live;
+AlarmEngine alarms(ALARM_RULES, ALARM_RULE_COUNT);
+AlertDigest digest;
+#if OTA_ENABLED
+OtaUpdater ota(otaHost, otaPort, otaManifest, FIRMWARE_VERSION);
+#endif
+#if GRAIN_PROBES
+// ---> GRAIN PROBES (GRAIN_PROBES in probe_set.h) <---
+// One row per probe, GRAIN_PROBES rows. DS18B20 indices follow the ROM
+// search order, printed at boot.
+OneWire probeWire(PROBE_ONEWIRE_PIN);
+Ds18b20ProbeBus grainString(probeWire);
+Sht3xProbeBus grainSht(Wire);
+const Probe grainProbes[] = {
+  // name       depth cm  bus           index
+  { "top",      30,       &grainSht,    0 },   // SHT3x at 0x44: humidity too
+  { "middle",   150,      &grainString, 0 },
+  { "bottom",   300,      &grainString, 1 },
+};
+static_assert(sizeof(grainProbes) / sizeof(grainProbes[0]) == GRAIN_PROBES, "the probe table needs GRAIN_PROBES rows");
+ProbeSet probes(grainProbes, GRAIN_PROBES);
+#endif
+
+// Hot-path timing for /metrics
+PerfHistogram perfLoop;       // loop() passes that ran a task
+PerfHistogram perfDht;        // climate.poll()
+PerfHistogram perfPage;       // Dashboard page and assets
+PerfHistogram perfAlert;      // sendTelegram() (queueing only)
+PerfHistogram perfTelegram;   // telegram.poll() steps (TLS connect included)
+PerfHistogram perfThingSpeak; // thingspeak.poll() steps
+uint32_t minFreeHeap = UINT32_MAX;
+#if SILO_ROLE == SILO_NODE
+SiloNodeLink siloLink;
+#elif SILO_ROLE == SILO_GATEWAY
+SiloGateway gateway(telegram, ALERT_TEXT, siteChannelId, siteApiKey);
+#endif
 
-unsigned long lastCloudUpload = 0; 
 unsigned long lastBuzzerToggle = 0;  // Non-blocking buzzer timer
 bool buzzerState = false;            // Current buzzer on/off state
 
+BuzzerPattern buzzerPattern = BUZZ_OFF;
+
+uint8_t traceQueued = 0;  // TRACE_REPLAY: Telegrams queued during the current frame
+
 float temp = 0.0;
 float hum = 0.0;
-int gasValue = 0;
+bool dhtStale = true;   // No trustworthy DHT reading (dead/unplugged sensor)
+int gasValue = 0;       // Raw MQ-2 reading (burst median)
+int gasFiltered = 0;    // Filtered MQ-2 reading
+float gasSlope = 0.0;   // Filtered change, counts per minute
+bool gasAlarm = false;  // Filtered value above threshold (with hysteresis)
 int motion = 0;
-String alertStatus = "SAFE";
+bool fermentationRisk = false; // Anomaly model flagged several samples in a row
+bool moldForecast = false; // Humidity forecast to reach the mold range
+const char* alertStatus = "SAFE"; // Always points at a string literal
+SiloAlert alertCode = SILO_ALERT_NONE; // Same condition, as a code for the gateway
 bool isFanRunning = false; 
+float humAlarmPct = HUM_ALARM_PCT;
+
+ResetLog resetLog;
+bool bootRestored = false;  // Control state came back from RTC memory
+uint32_t bootRanS = 0;      // ...and the run before this boot lasted this long
+uint32_t bootDecisionMs = 0; // Reset to the first relay decision
+
+#if SILO_DUAL_CORE
+CoreLink coreLink;          // The rings between the two cores (core_link.h)
+SiloState netView;          // Network core: the newest control snapshot
+#endif
 
 // ==========================================
 // TELEGRAM SEND FUNCTION
 // ==========================================
-void sendTelegram(String message) {
-  if (WiFi.status() == WL_CONNECTED) {
-    WiFiClientSecure clientSecure;
-    clientSecure.setInsecure(); // Connect securely without certificate
-
-    HTTPClient http;
-    message.replace(" ", "%20"); // Format spaces for URL
-    String url = "https://api.telegram.org/bot" + botToken + "/sendMessage?chat_id=" + chatId + "&text=" + message;
-    
-    http.begin(clientSecure, url);
-    int httpCode = http.GET();
-    
-    if (httpCode == 200) {
-      Serial.println("✅ Telegram Alert Sent Successfully!");
+// Queues the alert and returns immediately; telegram.poll() in loop()
+// does the actual network work a step at a time. A node hands the alert
+// (alertCode) to the gateway instead, which owns the Telegram bot.
+// On the ESP32 the network core picks it up from coreLink.alerts.
+void sendNodeFrame(uint8_t flags);
+void publishFrame(const char* topic, uint8_t flags, uint8_t qos, const SiloState& s);
+SiloState captureState(uint32_t now);
+
+// Network side
+void deliverAlert(const char* message, const SiloState& s) {
+  telegram.enqueue(message);
+#if MQTT_ENABLED
+  publishFrame(MQTT_TOPIC "/alert", SILO_FLAG_ALERT, 1, s);
+#else
+  (void)s;
+#endif
+}
+
+void sendTelegram(const char* message) {
+  PerfScope probe(perfAlert);
+#if TRACE_REPLAY
+  // Reported with the frame instead (see replayFrame)
+  (void)message;
+  traceQueued++;
+#elif SILO_ROLE == SILO_NODE
+  (void)message;
+  sendNodeFrame(SILO_FLAG_ALERT);
+#elif SILO_DUAL_CORE
+  SiloAlertText a;
+  a.state = captureState(millis());
+  strncpy(a.text, message, sizeof(a.text) - 1);
+  a.text[sizeof(a.text) - 1] = '\0';
+  coreLink.alerts.push(a);
+#else
+  deliverAlert(message, captureState(millis()));
+#endif
+}
+
+// ==========================================
+// UPGRADED PROFESSIONAL UI DASHBOARD
+// ==========================================
+// The dashboard at / is a static, gzipped page (code/web/, see
+// static_assets.h) that fills itself from /events. /lite is the fallback
+// for browsers without JavaScript (dashboard_render.h).
+
+// The live values as one snapshot, for the decision and rendering core
+SiloReadings readingsNow() {
+#if GRAIN_PROBES
+  float grainTemp = probes.hottest(millis());
+  float grainHum = probes.wettest(millis());
+#else
+  float grainTemp = NAN, grainHum = NAN;
+#endif
+  return { temp, hum, !dhtStale, (uint16_t)gasValue, (uint16_t)gasFiltered, gasSlope,
+           gasAlarm, motion == HIGH, fermentationRisk, moldForecast, grainTemp, grainHum };
+}
+
+// ==========================================
+// CONTROL <-> NETWORK (core_link.h)
+// ==========================================
+// The network side (pages, /events, MQTT, Telegram commands, uploads) sees
+// the silo through netState() and changes it through sendCommand(). On the
+// ESP8266 those are the control globals, directly. On the ESP32 the control
+// core sends a snapshot every CORE_LINK_STATE_MS and applies the commands
+// it finds (taskLinkOut); the network core keeps the newest snapshot and
+// takes the alerts and samples (taskLinkIn).
+static_assert(CORE_LINK_TEXT_MAX == TELEGRAM_MSG_MAX, "alert texts cross the link whole");
+
+// Control side
+SiloState captureState(uint32_t now) {
+  return { readingsNow(), alertStatus, alertCode, isFanRunning, (uint8_t)fan.override(now),
+           humAlarmPct, gas.alarmEnter(), gas.alarmExit(), digest.muteLeftMs(now) };
+}
+
+void applyCommand(const SiloCommand& c, uint32_t now) {
+  if (c.what & CMD_FAN) fan.setOverride((FanController::Override)c.fanMode, now, c.fanMs);
+  if (c.what & CMD_THRESHOLDS) {
+    humAlarmPct = c.humAlarmPct;
+    gas.setThresholds(c.gasAlarmEnter, c.gasAlarmExit);
+  }
+  if (c.what & CMD_MUTE) digest.mute(c.muteMs, now);
+}
+
+void publishSample();
+
+#if SILO_DUAL_CORE
+SiloState netState() { return netView; }
+
+// False while the control core still has CORE_LINK_COMMANDS to take
+bool sendCommand(const SiloCommand& c) { return coreLink.commands.push(c); }
+
+void taskLinkOut() {
+  uint32_t now = millis();
+  SiloCommand c;
+  while (coreLink.commands.pop(c)) applyCommand(c, now);
+  // A network core that fell behind gets a fresh snapshot once it catches up
+  if (!coreLink.states.full()) coreLink.states.push(captureState(now));
+}
+
+void taskLinkIn() {
+  SiloState s;
+  while (coreLink.states.pop(s)) netView = s;
+  SiloAlertText a;
+  while (coreLink.alerts.pop(a)) deliverAlert(a.text, a.state);
+  SiloSample sample;
+  while (coreLink.samples.pop(sample)) {
+    addSample(history, sample);
+    publishSample();
+  }
+  WindowSummary w;
+  while (coreLink.windows.pop(w)) windowLog.push(w, history.nextSeq());
+}
+#else
+SiloState netState() { return captureState(millis()); }
+
+bool sendCommand(const SiloCommand& c) {
+  applyCommand(c, millis());
+  return true;
+}
+#endif
+
+void handleLite() {
+  PerfScope probe(perfPage);
+  SiloState s = netState();
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+  renderLite(server, s.readings, s.fan, s.status);
+  server.sendContent(""); // Terminating chunk
+}
+
+// ==========================================
+// LIVE DASHBOARD PUSH (/events)
+// ==========================================
+// taskLive compares what the open dashboards show with the current values
+// and pushes only the difference, as soon as it appears. Alarm, fan and
+// motion changes go out on the next tick. Sensor values wait for
+// LIVE_MIN_INTERVAL_MS, and raw gas and slope have a small deadband
+// (dashboard_render.h), so ADC noise doesn't stream at 20 events a second.
+#define LIVE_MIN_INTERVAL_MS 500     // Fastest push of sensor-value changes
+
+LiveView liveShown;
+uint32_t lastLivePushMs = 0;
+
+LiveView liveNow() {
+  SiloState s = netState();
+  return liveView(s.readings, s.fan, s.status);
+}
+
+// Current state as one JSON object, for scripts; the page uses /events
+void handleState() {
+  char full[LIVE_EVENT_MAX];
+  formatLive(full, sizeof(full), liveNow(), nullptr);
+  server.sendHeader("Cache-Control", "no-store");
+  server.send(200, "application/json", full);
+}
+
+void handleEvents() {
+  char full[LIVE_EVENT_MAX];
+  LiveView v = liveNow();
+  formatLive(full, sizeof(full), v, nullptr);
+  if (live.attach(server.client(), full) && live.viewers() == 1) liveShown = v;
+}
+
+void taskLive() {
+  live.poll();
+  if (!live.viewers()) return;
+  LiveView v = liveNow();
+  bool urgent = v.status != liveShown.status || v.fan != liveShown.fan || v.motion != liveShown.motion;
+  if (!urgent && millis() - lastLivePushMs < LIVE_MIN_INTERVAL_MS) return;
+  char delta[LIVE_EVENT_MAX], full[LIVE_EVENT_MAX];
+  if (formatLive(delta, sizeof(delta), v, &liveShown) <= 2) return; // "{}": nothing changed
+  formatLive(full, sizeof(full), v, nullptr);
+  live.broadcast(delta, full);
+  lastLivePushMs = millis();
+}
+
+// ==========================================
+// TREND HISTORY ENDPOINT (/history)
+// ==========================================
+// Default: compact little-endian binary, chunked.
+//   Header (16 bytes):
+//     "SGH1" magic, uint16 sample count, uint16 period (s),
+//     uint32 age of newest sample (ms), uint32 seq of first sample
+//   Then one 8-byte record per sample, oldest first:
+//     int16 temp (centi-C), uint8 humidity (half-%), uint16 gas,
+//     uint16 filtered gas, uint8 motion events
+//   Missing readings are temp = -32768 and humidity = 255 (blank in CSV).
+// /history?format=csv returns the same data as text.
+// /history?n=120 limits the reply to the newest 120 samples.
+static void putLE16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void putLE32(uint8_t* p, uint32_t v) { putLE16(p, v); putLE16(p + 2, v >> 16); }
+
+void handleHistory() {
+  uint32_t count = history.size();
+  if (server.hasArg("n")) {
+    uint32_t n = server.arg("n").toInt();
+    if (n < count) count = n;
+  }
+  uint32_t first = history.nextSeq() - count;
+  bool csv = server.arg("format") == "csv";
+  uint8_t buf[512];
+  size_t len = 0;
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, csv ? "text/csv" : "application/octet-stream", "");
+
+  if (csv) {
+    len = snprintf((char*)buf, sizeof(buf), "age_s,temperature,humidity,gas_value,gas_filtered,motion");
+#if GRAIN_PROBES
+    for (uint8_t i = 0; i < probes.count(); i++) {
+      len += snprintf((char*)buf + len, sizeof(buf) - len, ",%s_temp,%s_hum", probes.probe(i).name, probes.probe(i).name);
+    }
+#endif
+    buf[len++] = '\n';
+  } else {
+    memcpy(buf, "SGH1", 4);
+    putLE16(buf + 4, count);
+    putLE16(buf + 6, SAMPLE_PERIOD_MS / 1000);
+    putLE32(buf + 8, count ? millis() - history.msAt(history.nextSeq() - 1) : 0);
+    putLE32(buf + 12, first);
+    len = 16;
+  }
+
+  for (uint32_t seq = first; seq < first + count; seq++) {
+    if (len > sizeof(buf) - 64 - GRAIN_PROBES * 16) {
+      server.sendContent((const char*)buf, len);
+      len = 0;
+    }
+    if (csv) {
+      HistorySample s;
+      history.get(seq, s);
+      char* p = (char*)buf;
+      size_t cap = sizeof(buf);
+      len += snprintf(p + len, cap - len, "%u,", (unsigned)((millis() - s.ms) / 1000));
+      if (!isnan(s.temp)) len += snprintf(p + len, cap - len, "%.2f", s.temp);
+      p[len++] = ',';
+      if (!isnan(s.hum)) len += snprintf(p + len, cap - len, "%.1f", s.hum);
+      len += snprintf(p + len, cap - len, ",%u,%u,%u", s.gas, s.gasFiltered, s.motion);
+      for (int i = 0; i < GRAIN_PROBES; i++) {
+        int16_t t = history.probeTempCentiAt(seq, i);
+        uint8_t h = history.probeHumHalfAt(seq, i);
+        p[len++] = ',';
+        if (t != HISTORY_TEMP_NONE) len += snprintf(p + len, cap - len, "%.2f", t / 100.0f);
+        p[len++] = ',';
+        if (h != HISTORY_HUM_NONE) len += snprintf(p + len, cap - len, "%.1f", h / 2.0f);
+      }
+      p[len++] = '\n';
     } else {
-      Serial.println("❌ Telegram Error: " + String(httpCode));
+      putLE16(buf + len, history.tempCentiAt(seq));
+      buf[len + 2] = history.humHalfAt(seq);
+      putLE16(buf + len + 3, history.gasAt(seq));
+      putLE16(buf + len + 5, history.gasFilteredAt(seq));
+      buf[len + 7] = history.motionAt(seq);
+      len += 8;
     }
-    http.end();
   }
+  if (len) server.sendContent((const char*)buf, len);
+  server.sendContent(""); // Terminating chunk
 }
 
 // ==========================================
-// UPGRADED PROFESSIONAL UI DASHBOARD
+// SCHEDULED TASKS
 // ==========================================
-void handleRoot() {
-  String html = "<!DOCTYPE html><html><head><title>Smart Silo Dashboard</title>";
-  html += "<meta charset='UTF-8'>"; 
-  html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-  html += "<meta http-equiv='refresh' content='2'>";
-  
-  html += "<style>";
-  html += "body { font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif; background-color: #e8f5e9; color: #1b5e20; margin: 0; padding: 20px; text-align: center; }";
-  html += "h1 { margin-bottom: 5px; font-size: 2.2em; color: #2e7d32; }";
-  html += "p.subtitle { color: #4caf50; font-size: 1.1em; margin-top: 0; margin-bottom: 30px; font-weight: bold; }";
-  html += ".grid { display: flex; flex-wrap: wrap; justify-content: center; gap: 20px; max-width: 900px; margin: 0 auto; }";
-  html += ".card { background: white; border-radius: 15px; padding: 25px; width: 200px; box-shadow: 0 6px 12px rgba(0,0,0,0.1); border-top: 6px solid #4caf50; transition: transform 0.2s; }";
-  html += ".card:hover { transform: translateY(-5px); }";
-  html += ".card h3 { margin: 0; font-size: 1.2em; color: #757575; text-transform: uppercase; letter-spacing: 1px; }";
-  html += ".card .value { font-size: 2.5em; font-weight: bold; margin: 15px 0 0 0; color: #2e7d32; }";
-  html += ".status-banner { margin: 10px auto 30px auto; padding: 20px; border-radius: 10px; max-width: 860px; font-size: 1.8em; font-weight: bold; box-shadow: 0 4px 8px rgba(0,0,0,0.2); }";
-  html += ".safe { background-color: #4caf50; color: white; }";
-  html += ".danger { background-color: #d32f2f; color: white; animation: blink 1s linear infinite; }";
-  html += "@keyframes blink { 50% { opacity: 0.8; } }";
-  html += ".motion-card { background: white; border-radius: 15px; padding: 20px; width: 80%; max-width: 640px; margin: 30px auto; box-shadow: 0 6px 12px rgba(0,0,0,0.15); border-top: 6px solid #2196f3; }";
-  html += ".motion-card h3 { margin: 0; font-size: 1.4em; color: #555; text-transform: uppercase; letter-spacing: 1px; }";
-  html += "</style></head><body>";
-
-  html += "<h1>🌾 Smart Grain Silo</h1>";
-  html += "<p class='subtitle'>Real-Time Agricultural Monitoring System</p>";
-
-  // Main Status Banner
-  if (alertStatus == "SAFE") {
-    html += "<div class='status-banner safe'>✅ SYSTEM STATUS: " + alertStatus + "</div>";
-  } else {
-    html += "<div class='status-banner danger'>🚨 SYSTEM STATUS: " + alertStatus + "</div>";
+// Each task does one short, non-blocking piece of work. Periods match what
+// the hardware can actually deliver: the DHT11 only produces a new reading
+// once a second, while gas and motion are checked every 50 ms.
+
+void taskWeb() {
+  server.handleClient();
+}
+
+void taskDht() {
+  bool fresh;
+  {
+    PerfScope probe(perfDht);
+    fresh = climate.poll();
+  }
+  if (fresh) {
+    temp = climate.temperature();
+    hum = climate.humidity();
+    windowStats.addClimate(temp, hum);
   }
+  dhtStale = climate.stale();
+}
 
-  html += "<div class='grid'>";
+#if GRAIN_PROBES
+// Starts all probe buses together, then reads one probe per run as its
+// conversion finishes
+void taskProbes() {
+  probes.poll(millis());
+}
+#endif
 
-  html += "<div class='card'><h3>Temperature</h3><div class='value'>" + String(temp, 1) + " &deg;C</div></div>";
-  html += "<div class='card'><h3>Humidity</h3><div class='value'>" + String(hum, 1) + " %</div></div>";
-  html += "<div class='card' style='border-top-color: #ff9800;'><h3>Gas/Smoke</h3><div class='value' style='color:#f57c00;'>" + String(gasValue) + "</div></div>";
-  
-  // Exhaust Fan UI Card
-  if (isFanRunning) {
-    html += "<div class='card' style='border-top-color: #9c27b0;'><h3>Exhaust Fan</h3><div class='value' style='color:#9c27b0; font-size: 1.8em; margin-top:25px;'>⚙️ PURGING AIR</div></div>";
+void takeGas() {
+  gasValue = gas.raw();
+  gasFiltered = gas.filtered();
+  gasSlope = gas.slopePerMin();
+  gasAlarm = gas.alarm();
+}
+
+void applyAlarm(uint32_t now);
+
+// A gas alarm edge is decided in the same tick, not on the next alarm pass
+void taskGas() {
+  bool wasAlarm = gasAlarm;
+  gas.sample();
+  takeGas();
+  if (gasAlarm != wasAlarm) applyAlarm(millis());
+}
+
+// Edges are captured by the PIR interrupt; this just turns them into
+// debounced events and the held motion state.
+void taskPir() {
+  pir.poll();
+  motion = pir.active() ? HIGH : LOW;
+}
+
+// ---> AUTOMATED EXHAUST FAN LOGIC <---
+void applyFan(uint32_t now) {
+  // A stale humidity value says nothing about the silo; only gas counts then
+  bool wantFan = fan.update(now, temp, hum, !dhtStale, gasFiltered, gasAlarm);
+  if (wantFan != isFanRunning) {
+    if (!TRACE_REPLAY) digitalWrite(RELAY_PIN, wantFan ? RELAY_ON : RELAY_OFF);
+    isFanRunning = wantFan;
+  }
+}
+
+// The control state for a fast boot after a reset (boot_state.h)
+void saveBootState(uint32_t now) {
+  BootState s = {};
+  s.uptimeS = now / 1000;
+  s.gasEmaQ4 = gas.emaQ4();
+  s.gasBaselineQ4 = gas.baselineQ4();
+  uint32_t held = fan.heldMs(now) / 1000;
+  s.fanHeldS = held < UINT16_MAX ? held : UINT16_MAX;
+  s.fanOverrideMin = (fan.overrideLeftMs(now) + 59999) / 60000;
+  s.flags = (isFanRunning ? BOOT_FAN_ON : 0) | (gas.alarm() ? BOOT_GAS_ALARM : 0) |
+            (gas.warmingUp() ? 0 : BOOT_GAS_WARM) | fan.override(now) << BOOT_OVERRIDE_SHIFT;
+  if (!dhtStale) {
+    s.tempCenti = (int16_t)lroundf(temp * 100);
+    s.humHalf = (uint8_t)lroundf(hum * 2);
+    s.flags |= BOOT_CLIMATE_OK;
+  }
+  alarms.save(now, s.alarms);
+#if OTA_ENABLED
+  // A rollback boot sends nothing (its Telegram queue dies with the
+  // restart): leave the alarms for the good version to raise afresh
+  if (ota.rescue()) s.alarms = AlarmEngine::Memory();
+#endif
+  rtcSave(RTC_SLOT_BOOT, s, BOOT_STATE_TAG);
+}
+
+void taskFan() {
+  applyFan(millis());
+  saveBootState(millis());
+}
+
+// ---> MULTI-STAGE ALARM LOGIC (WITH TELEGRAM) <---
+// Rules, priorities and cooldowns live in ALARM_RULES (silo_logic.h)
+void notifyAlarm(const AlarmEvent& e, const SiloReadings& r, uint32_t now) {
+#if SILO_ROLE == SILO_NODE
+  // The gateway repeats and deduplicates node alerts itself
+  (void)r;
+  (void)now;
+  if (e.kind != ALARM_RAISED && e.kind != ALARM_ESCALATED) return;
+#else
+  if (!digest.add(e, r, now)) return;  // Folded into the next digest
+#endif
+  char msg[TELEGRAM_MSG_MAX];
+  unsigned minutes = e.activeMs / 60000;
+  switch (e.kind) {
+    case ALARM_RAISED:
+      sendTelegram(e.rule->message);
+      return;
+    case ALARM_REMINDER:
+      snprintf(msg, sizeof(msg), "🔁 STILL ACTIVE (%u min): %s", minutes, e.rule->message);
+      break;
+    case ALARM_ESCALATED:
+      snprintf(msg, sizeof(msg), "⏫ %u MIN AND COUNTING: %s", minutes, e.rule->message);
+      break;
+    case ALARM_CLEARED:
+      snprintf(msg, sizeof(msg), "✅ CLEARED: %s alert is over after %u min.", ALERT_NAME[e.rule->code],
+               minutes);
+      break;
+  }
+  sendTelegram(msg);
+}
+
+void applyAlarm(uint32_t now) {
+  SiloReadings r = readingsNow();
+  AlarmDecision d = alarms.evaluate(r, { humAlarmPct }, now);
+  alertStatus = d.status;
+  alertCode = d.code;
+  buzzerPattern = d.buzzer;
+  for (uint8_t i = 0; i < alarms.eventCount(); i++) notifyAlarm(alarms.event(i), r, now);
+#if SILO_ROLE != SILO_NODE
+  char msg[TELEGRAM_MSG_MAX];
+  if (digest.poll(now, alertStatus, msg, sizeof(msg))) sendTelegram(msg);
+#endif
+}
+
+void taskAlarm() {
+  applyAlarm(millis());
+}
+
+// Solid tone, slow pulse (300ms on / 300ms off) or fast pulse (150ms / 150ms)
+void taskBuzzer() {
+  uint32_t halfPeriod = 0;
+  switch (buzzerPattern) {
+    case BUZZ_OFF:   buzzerState = false; break;
+    case BUZZ_SOLID: buzzerState = true; break;
+    case BUZZ_SLOW:  halfPeriod = 300; break;
+    case BUZZ_FAST:  halfPeriod = 150; break;
+  }
+  if (halfPeriod && millis() - lastBuzzerToggle >= halfPeriod) {
+    buzzerState = !buzzerState;
+    lastBuzzerToggle = millis();
+  }
+  digitalWrite(BUZZER_PIN, buzzerState ? HIGH : LOW);
+}
+
+// Back to protecting the silo a few ms after a reset: restore the control
+// state saved by taskFan, take a gas reading, then decide the alarm, the
+// buzzer and the relay before anything slow runs.
+void fastBoot() {
+  uint32_t now = millis();
+  BootState s;
+  bootRestored = platformReset().reason != REASON_DEEP_SLEEP_AWAKE && rtcLoad(RTC_SLOT_BOOT, s, BOOT_STATE_TAG);
+  if (bootRestored) {
+    gas.restore(s.gasEmaQ4, s.gasBaselineQ4, s.flags & BOOT_GAS_ALARM, s.flags & BOOT_GAS_WARM);
+    fan.restore(s.flags & BOOT_FAN_ON, s.fanHeldS * 1000UL,
+                (FanController::Override)(s.flags >> BOOT_OVERRIDE_SHIFT & 3), s.fanOverrideMin * 60000UL, now);
+    if (s.flags & BOOT_CLIMATE_OK) {
+      temp = s.tempCenti / 100.0f;
+      hum = s.humHalf / 2.0f;
+      climate.restore(temp, hum);
+      dhtStale = false;
+    }
+    alarms.restore(s.alarms, now);
+    bootRanS = s.uptimeS;
+  }
+  gas.sample();
+  takeGas();
+  applyAlarm(millis());
+  taskBuzzer();
+  applyFan(millis());
+  bootDecisionMs = millis();
+}
+
+// ---> LOW-POWER POLICY (see power_manager.h) <---
+uint32_t radioOnMs = 0;   // Modem sleep: when the current radio window opened
+uint32_t radioOffMs = 0;  // ...and when the last one closed
+uint32_t wakeSeq = 0;     // Deep sleep: history seq after the replayed samples
+
+#if POWER_MODE == POWER_DEEP_SLEEP
+// Timer (or PIR) wake: one sample with the radio off, then straight back to
+// sleep, unless the sample needs the full firmware. Never returns.
+void quickWake() {
+  power.restoreGas(gas);
+  gas.sample();
+  climate.poll();
+  bool climateOk = !climate.stale();
+  float t = climateOk ? climate.temperature() : NAN;
+  float h = climateOk ? climate.humidity() : NAN;
+  // The PIR output that pulsed RST is still high
+  uint8_t motionSeen = digitalRead(PIR_PIN) == HIGH ? 1 : 0;
+  power.saveGas(gas);
+
+  bool attention = gas.filtered() > GAS_ALARM_EXIT || motionSeen ||
+                   (climateOk && (h > humAlarmPct || FanController::wouldStart(t, h, gas.filtered())));
+  if (attention) {
+    // Full boot in a second (the DHT11 needs the gap); it records the sample
+    power.sleep(1000, false, true);
+  }
+  power.addSample(t, h, gas.raw(), gas.filtered(), motionSeen);
+  power.sleep(SAMPLE_PERIOD_MS - millis(), false, power.flushDue());
+}
+
+// Full wake is over: keep what wasn't uploaded and sleep until the next sample
+void sleepUntilNextSample(bool flushed) {
+  power.stash(history, history.nextSeq() - thingspeak.pending(), flushed);
+  power.saveGas(gas);
+  digitalWrite(RELAY_PIN, RELAY_OFF);
+  digitalWrite(BUZZER_PIN, LOW);
+  Serial.printf("Sleeping: %u samples kept, est. %.2f mA average\n",
+                (unsigned)power.samples(), power.averageMa());
+  uint32_t sinceSample = millis() - history.msAt(history.nextSeq() - 1);
+  uint32_t ms = sinceSample + 1000 < SAMPLE_PERIOD_MS ? SAMPLE_PERIOD_MS - sinceSample : 1000;
+  power.sleep(ms, true, false);
+}
+#endif
+
+void taskPower() {
+  power.account(wifi.radioOn());
+  uint32_t now = millis();
+#if POWER_MODE == POWER_MODEM_SLEEP
+  if (!wifi.radioOn()) {
+    // Alerts go out at once; samples wait for the next window
+    if (telegram.busy() || mqtt.busy() ||
+        (thingspeak.pending() && now - radioOffMs >= POWER_FLUSH_PERIOD_MS)) {
+      wifi.wake();
+      radioOnMs = now;
+    }
+    return;
+  }
+  uint32_t up = now - radioOnMs;
+  bool drained = !telegram.busy() && !mqtt.busy() && !thingspeak.busy() && thingspeak.pending() == 0;
+  if ((drained && up >= POWER_RADIO_MIN_MS) || up >= POWER_RADIO_MAX_MS) {
+    wifi.sleep();
+    radioOffMs = now;
+  }
+#elif POWER_MODE == POWER_DEEP_SLEEP
+  // Local action needs the CPU: stay up while anything sounds or runs
+  if (gasAlarm || isFanRunning || buzzerPattern != BUZZ_OFF) return;
+  // Samples taken during this wake may ride along in RTC memory
+  bool flushed = history.nextSeq() - thingspeak.pending() >= wakeSeq;
+  bool done = flushed && !telegram.busy() && !mqtt.busy() && !thingspeak.busy();
+  if ((done && now >= POWER_RADIO_MIN_MS) || now >= POWER_RADIO_MAX_MS) sleepUntilNextSample(flushed);
+#else
+  (void)now;
+#endif
+}
+
+void taskWifi() {
+  wifi.poll();       // Connects and reconnects in the background
+}
+
+// The newest history sample plus a state snapshot, as a SiloFrame
+SiloFrame currentFrame(uint8_t flags, const SiloState& s) {
+  flags |= (s.fan ? SILO_FLAG_FAN : 0) | (s.readings.gasAlarm ? SILO_FLAG_GAS_ALARM : 0) |
+           (s.readings.climateOk ? 0 : SILO_FLAG_DHT_STALE) |
+           (s.fanOverride != FanController::AUTO ? SILO_FLAG_OVERRIDE : 0);
+  return frameFromHistory(history, history.nextSeq() - 1, flags, s.alert);
+}
+
+// Node: the frame goes to the gateway
+void sendNodeFrame(uint8_t flags) {
+#if SILO_ROLE == SILO_NODE
+  if (history.empty()) return;
+  siloLink.send(currentFrame(flags, netState()));
+#else
+  (void)flags;
+#endif
+}
+
+// ==========================================
+// MQTT TELEMETRY & COMMANDS (MQTT_ENABLED)
+// ==========================================
+// Samples (QoS 0) and alerts (QoS 1) are published as the same 16-byte
+// SiloFrame that ESP-NOW nodes send, so one decoder reads both. Commands
+// arrive as text on MQTT_TOPIC/cmd, whitespace-separated key=value pairs:
+//   fan=on | fan=off | fan=auto   remote override (a gas alarm still wins)
+//   fan_min=30                    override length in minutes (default 60)
+//   hum_alarm=65                  humidity alarm threshold, %
+//   gas_alarm=120                 filtered gas alarm threshold (exit keeps the gap)
+// A command is applied as a whole or not at all; the result is published
+// on MQTT_TOPIC/ack. Thresholds live in RAM: publish them retained and the
+// broker hands them back after every reboot.
+uint16_t mqttSeq = 0;
+char mqttClientId[20];
+
+void publishFrame(const char* topic, uint8_t flags, uint8_t qos, const SiloState& s) {
+  if (history.empty()) return;
+  SiloFrame f = currentFrame(flags, s);
+  f.magic = SILO_FRAME_MAGIC;
+  f.version = SILO_FRAME_VERSION;
+  f.node = SILO_NODE_ID;
+  f.seq = mqttSeq++;
+  mqtt.publish(topic, (const uint8_t*)&f, sizeof(f), qos);
+}
+
+void handleMqttCommand(const char* topic, const uint8_t* payload, uint16_t len) {
+  (void)topic; // Only MQTT_TOPIC/cmd is subscribed
+  char cmd[MQTT_RX_MAX + 1];
+  memcpy(cmd, payload, len);
+  cmd[len] = '\0';
+
+  SiloState view = netState();
+  int fanMode = -1;
+  uint32_t fanMs = MQTT_FAN_OVERRIDE_MS;
+  float newHum = view.humAlarmPct;
+  long newGas = view.gasAlarmEnter;
+  bool otaCheck = false;
+  const char* bad = nullptr;
+  for (char* tok = strtok(cmd, " ,;\r\n"); tok && !bad; tok = strtok(nullptr, " ,;\r\n")) {
+    char* val = strchr(tok, '=');
+    if (!val) {
+      bad = tok;
+      break;
+    }
+    *val++ = '\0';
+    if (!strcmp(tok, "fan")) {
+      if (!strcmp(val, "on")) fanMode = FanController::FORCE_ON;
+      else if (!strcmp(val, "off")) fanMode = FanController::FORCE_OFF;
+      else if (!strcmp(val, "auto")) fanMode = FanController::AUTO;
+      else bad = tok;
+    } else if (!strcmp(tok, "fan_min")) {
+      long m = atol(val);
+      if (m >= 1 && m <= 1440) fanMs = m * 60000UL;
+      else bad = tok;
+    } else if (!strcmp(tok, "hum_alarm")) {
+      newHum = atof(val);
+      if (!(newHum >= 30 && newHum <= 95)) bad = tok;
+    } else if (!strcmp(tok, "gas_alarm")) {
+      newGas = atol(val);
+      if (newGas < GAS_ALARM_ENTER - GAS_ALARM_EXIT + 1 || newGas > 1023) bad = tok;
+    } else if (OTA_ENABLED && !strcmp(tok, "ota") && !strcmp(val, "check")) {
+      otaCheck = true;  // Publish ota=check to every silo's cmd topic to roll out a release now
+    } else {
+      bad = tok;
+    }
+  }
+
+  SiloCommand c = {};
+  c.what = CMD_THRESHOLDS | (fanMode >= 0 ? CMD_FAN : 0);
+  c.fanMode = fanMode >= 0 ? fanMode : FanController::AUTO;
+  c.fanMs = fanMs;
+  c.humAlarmPct = newHum;
+  c.gasAlarmEnter = newGas;
+  c.gasAlarmExit = newGas - (GAS_ALARM_ENTER - GAS_ALARM_EXIT);
+
+  char reply[96];
+  int n;
+  if (bad) {
+    n = snprintf(reply, sizeof(reply), "error: %s", bad);
+  } else if (!sendCommand(c)) {
+    n = snprintf(reply, sizeof(reply), "error: busy");
   } else {
-    html += "<div class='card' style='border-top-color: #9e9e9e;'><h3>Exhaust Fan</h3><div class='value' style='color:#757575; font-size: 1.8em; margin-top:25px;'>OFF</div></div>";
+#if OTA_ENABLED
+    if (otaCheck) ota.checkNow();
+#else
+    (void)otaCheck;
+#endif
+    const char* modes[] = { "auto", "on", "off" };
+    n = snprintf(reply, sizeof(reply), "ok fan=%s hum_alarm=%.1f gas_alarm=%u/%u",
+                 modes[fanMode >= 0 ? fanMode : view.fanOverride], newHum,
+                 (unsigned)c.gasAlarmEnter, (unsigned)c.gasAlarmExit);
   }
+  Serial.printf("MQTT command: %s\n", reply);
+  mqtt.publish(MQTT_TOPIC "/ack", (const uint8_t*)reply, n, 0);
+}
 
-  html += "</div>"; 
+// ==========================================
+// TELEGRAM COMMANDS (TELEGRAM_COMMANDS)
+// ==========================================
+// Sent in the alert chat, answered there (telegram_notifier.h long-polls):
+//   /status                 alarm, climate, gas, fan and mute state
+//   /fan on | off | auto    remote override for MQTT_FAN_OVERRIDE_MS (a gas alarm still wins)
+//   /mute 1h | 30m | off    hold back all but gas alerts; a digest follows the mute
+void handleTelegramCommand(const char* text, char* reply, size_t cap) {
+  char cmd[TELEGRAM_CMD_MAX];
+  strncpy(cmd, text, sizeof(cmd) - 1);
+  cmd[sizeof(cmd) - 1] = '\0';
+  char* name = strtok(cmd, " ");
+  char* arg = strtok(nullptr, " ");
+  if (!name) name = cmd;
+  // "/status@SiloBot" in group chats
+  if (char* at = strchr(name, '@')) *at = '\0';
+  SiloState view = netState();
+  const SiloReadings& r = view.readings;
+  SiloCommand c = {};
+  const char* modes[] = { "auto", "on", "off" };
 
-  // Motion Card
-  if (motion == HIGH) {
-    html += "<div class='motion-card' style='border-top-color: #f44336;'><h3>PIR Motion Sensor</h3><div class='value' style='color:#d32f2f; font-size: 2.2em; font-weight:bold; margin-top:15px;'>🚨 MOVEMENT DETECTED! 🚨</div></div>";
+  if (!strcmp(name, "/status")) {
+    // A reply cut short by cap stays NUL-terminated; appendf() stops there
+    int n = 0;
+    if (!r.climateOk) appendf(reply, cap, n, "%s | climate sensor silent", view.status);
+    else appendf(reply, cap, n, "%s | %.1f°C %.0f%%", view.status, r.temp, r.hum);
+    appendf(reply, cap, n, " | gas %d (alarm %u) | fan %s (%s)", (int)r.gasFiltered,
+            (unsigned)view.gasAlarmEnter, view.fan ? "on" : "off", modes[view.fanOverride]);
+    if (view.muteLeftMs) appendf(reply, cap, n, " | muted %u min", (unsigned)((view.muteLeftMs + 59999) / 60000));
+  } else if (!strcmp(name, "/fan") && arg) {
+    int mode = !strcmp(arg, "on") ? FanController::FORCE_ON :
+               !strcmp(arg, "off") ? FanController::FORCE_OFF :
+               !strcmp(arg, "auto") ? FanController::AUTO : -1;
+    if (mode < 0) {
+      snprintf(reply, cap, "Usage: /fan on | off | auto");
+      return;
+    }
+    c.what = CMD_FAN;
+    c.fanMode = mode;
+    c.fanMs = MQTT_FAN_OVERRIDE_MS;
+    if (!sendCommand(c)) snprintf(reply, cap, "Busy, try again.");
+    else if (mode == FanController::AUTO) snprintf(reply, cap, "Fan: auto");
+    else snprintf(reply, cap, "Fan: %s for %u min", modes[mode], (unsigned)(MQTT_FAN_OVERRIDE_MS / 60000));
+  } else if (!strcmp(name, "/mute")) {
+    // "1h", "30m", "90" (minutes) or "off"
+    bool off = arg && !strcmp(arg, "off");
+    char* unit = nullptr;
+    long v = arg ? strtol(arg, &unit, 10) : 60;
+    if (!off && (v <= 0 || v > 1440)) {
+      snprintf(reply, cap, "Usage: /mute 1h | 30m | off");
+      return;
+    }
+    uint32_t ms = off ? 0 : (unit && *unit == 'h' ? v * 3600000UL : v * 60000UL);
+    c.what = CMD_MUTE;
+    c.muteMs = ms;
+    if (!sendCommand(c)) snprintf(reply, cap, "Busy, try again.");
+    else if (ms) snprintf(reply, cap, "Muted for %u min. Gas alerts still come through; a digest follows.",
+                          (unsigned)(min(ms, (uint32_t)ALERT_MUTE_MAX_MS) / 60000));
+    else snprintf(reply, cap, "Alerts unmuted.");
   } else {
-    html += "<div class='motion-card'><h3>PIR Motion Sensor</h3><div class='value' style='color:#1976d2; font-size: 2.2em; font-weight:bold; margin-top:15px;'>No Motion</div></div>";
+    snprintf(reply, cap, "Commands: /status, /fan on|off|auto, /mute 1h|30m|off");
+  }
+}
+
+void taskNetwork() {
+#if SILO_ROLE == SILO_NODE
+  siloLink.poll();       // Everything goes through the gateway
+#else
+  journal.poll();    // Notes the boot time once NTP answers
+  {
+    PerfScope probe(perfTelegram);
+    telegram.poll();
+  }
+  {
+    PerfScope probe(perfThingSpeak);
+    thingspeak.poll(); // Batched from the history
+  }
+  mqtt.poll();       // Live samples, alerts, commands (when enabled)
+#if OTA_ENABLED
+  // Installs only while nothing is alarming and the fan is off
+  SiloState view = netState();
+  ota.poll(millis(), view.alert == SILO_ALERT_NONE && !view.fan);
+#endif
+#if SILO_ROLE == SILO_GATEWAY
+  gateway.poll();    // Node frames, node alerts, site uploads
+#endif
+#endif
+}
+
+// One sample into the humidity forecast. While mold conditions are
+// forecast, the alarm table warns and the fan runs ahead of its table.
+void updateForecast(uint32_t now) {
+  if (forecast.add(now, dhtStale ? NAN : hum)) moldForecast = forecast.riskAhead(temp);
+  else if (!forecast.ready()) moldForecast = false;  // A gap restarted the model
+  fan.setPreempt(moldForecast);
+}
+
+SiloSample takeSample(uint32_t now) {
+  SiloSample s = {};
+  s.ms = now;
+  // Stale climate readings are recorded as missing, not as the last good value
+  s.temp = dhtStale ? NAN : temp;
+  s.hum = dhtStale ? NAN : hum;
+  s.gas = gasValue;
+  s.gasFiltered = gasFiltered;
+  s.motion = pir.takeWindowCount();
+#if GRAIN_PROBES
+  for (uint8_t i = 0; i < probes.count(); i++) {
+    if (probes.stale(i, now)) continue;
+    s.probes |= 1 << i;
+    s.probeTemp[i] = probes.reading(i).temp;
+    s.probeHum[i] = probes.reading(i).hum;
+  }
+#endif
+  return s;
+}
+
+// Network side: the newest history sample to the journal, the gateway and MQTT
+void publishSample() {
+  journal.append(history, history.nextSeq() - 1, millis());
+  sendNodeFrame(0);
+#if MQTT_ENABLED
+  publishFrame(MQTT_TOPIC "/sample", 0, 0, netState());
+#endif
+}
+
+void taskHistory() {
+  uint32_t now = millis();
+  SiloSample s = takeSample(now);
+  addSample(controlHistory, s);
+  windowStats.addMotion(s.motion);
+  for (int i = 0; i < GRAIN_PROBES; i++) {
+    if (s.probes >> i & 1) windowStats.addGrain(s.probeTemp[i], s.probeHum[i]);
+  }
+#if SILO_DUAL_CORE
+  coreLink.samples.push(s);  // Into the network core's history, for the uploads
+#else
+  publishSample();
+#endif
+  // No model exported (or a climate gap) means no verdict
+  fermentationRisk = anomaly.update() && anomaly.confirmed();
+  updateForecast(now);
+}
+
+// Gas and fan into the upload window once a second; the DHT and the
+// history feed it their own readings
+void taskWindow() {
+  WindowSummary w;
+  if (!windowStats.tick(millis(), gasValue, gasFiltered, isFanRunning, w)) return;
+#if SILO_DUAL_CORE
+  coreLink.windows.push(w);  // Into the network core's log, for the uploads
+#else
+  windowLog.push(w, history.nextSeq());
+#endif
+}
+
+// The control side comes first, the network side starts at "web"
+Task tasks[] = {
+  // name       period ms          deadline ms  function
+  { "gas",      50,                20,          taskGas },
+  { "pir",      50,                20,          taskPir },
+  { "alarm",    50,                20,          taskAlarm },
+  { "buzzer",   10,                10,          taskBuzzer },
+  { "fan",      500,               200,         taskFan },
+  { "dht",      1000,              500,         taskDht },
+#if GRAIN_PROBES
+  { "probes",   10,                50,          taskProbes },
+#endif
+  { "history",  SAMPLE_PERIOD_MS,  1000,        taskHistory },
+#if UPLOAD_WINDOWS
+  { "window",   1000,              200,         taskWindow },
+#endif
+#if SILO_DUAL_CORE
+  { "link-out", CORE_LINK_STATE_MS, 20,         taskLinkOut },
+#endif
+  { "web",      5,                 50,          taskWeb },
+  { "wifi",     100,               200,         taskWifi },
+  { "network",  20,                200,         taskNetwork },
+  { "power",    1000,              500,         taskPower },
+  { "live",     50,                20,          taskLive },
+#if SILO_DUAL_CORE
+  { "link-in",  5,                 20,          taskLinkIn },
+#endif
+};
+const uint8_t kTaskCount = sizeof(tasks) / sizeof(tasks[0]);
+
+#if SILO_DUAL_CORE
+uint8_t controlTaskCount() {
+  uint8_t n = 0;
+  while (tasks[n].run != taskWeb) n++;
+  return n;
+}
+Scheduler controlScheduler(tasks, controlTaskCount());
+Scheduler networkScheduler(tasks + controlTaskCount(), kTaskCount - controlTaskCount());
+#else
+Scheduler scheduler(tasks, kTaskCount);
+#endif
+
+#if OTA_ENABLED
+// Rollback boot (ota_updater.h): the silo keeps protecting itself while the
+// good version downloads. Only the local control tasks run, plus WiFi and
+// the updater. Alerts aren't sent from here: saveBootState() drops the
+// alarm state, so the good version raises whatever is still active.
+// taskFan still saves the boot state, so a crash here comes back with the
+// relay as it was.
+void taskRescue() {
+  ota.poll(millis(), true);  // Install as soon as it is verified
+}
+
+Task rescueTasks[] = {
+  { "gas",      50,                20,          taskGas },
+  { "pir",      50,                20,          taskPir },
+  { "alarm",    50,                20,          taskAlarm },
+  { "buzzer",   10,                10,          taskBuzzer },
+  { "fan",      500,               200,         taskFan },
+  { "dht",      1000,              500,         taskDht },
+  { "wifi",     100,               200,         taskWifi },
+  { "ota",      20,                200,         taskRescue },
+};
+Scheduler rescueScheduler(rescueTasks, sizeof(rescueTasks) / sizeof(rescueTasks[0]));
+#endif
+
+// Plain-text per-task stats at /tasks
+void handleTasks() {
+  char line[96];
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain", "");
+  server.sendContent("task      period  runs       overruns  max_late_ms  last_us  max_us\n");
+  for (const Task& t : tasks) {
+    snprintf(line, sizeof(line), "%-9s %-7u %-10u %-9u %-12u %-8u %u\n",
+             t.name, (unsigned)t.periodMs, (unsigned)t.runs, (unsigned)t.overruns,
+             (unsigned)t.maxLateMs, (unsigned)t.lastRunUs, (unsigned)t.maxRunUs);
+    server.sendContent(line);
+  }
+#if SILO_DUAL_CORE
+  snprintf(line, sizeof(line), "\nlink      states %u  samples %u  alerts %u  commands %u  dropped %u\n",
+           (unsigned)coreLink.states.pushed, (unsigned)coreLink.samples.pushed,
+           (unsigned)coreLink.alerts.pushed, (unsigned)coreLink.commands.pushed,
+           (unsigned)(coreLink.samples.dropped + coreLink.alerts.dropped + coreLink.commands.dropped));
+  server.sendContent(line);
+#endif
+  snprintf(line, sizeof(line), "\nfan       on %us  duty_1h %u%%  switches %u  capped %u\n",
+           (unsigned)fan.onSeconds(), (unsigned)fan.dutyPct(),
+           (unsigned)fan.switches, (unsigned)fan.capped);
+  server.sendContent(line);
+  snprintf(line, sizeof(line), "wifi      %s  rssi %d  connects %u  fast %u  drops %u  last_ms %u\n",
+           wifi.stateName(), (int)wifi.rssi(), (unsigned)wifi.connects,
+           (unsigned)wifi.fastConnects, (unsigned)wifi.disconnects, (unsigned)wifi.lastConnectMs);
+  server.sendContent(line);
+  snprintf(line, sizeof(line), "power     %s  radio %.1f%%  est_ma %.2f + sensors %.0f  wakes %u/%u\n",
+           power.modeName(), power.radioPct(), power.averageMa(), POWER_MA_SENSORS,
+           (unsigned)power.state().fullWakes, (unsigned)power.state().wakes);
+  server.sendContent(line);
+  snprintf(line, sizeof(line), "live      viewers %u  events %u  resyncs %u  replaced %u\n",
+           (unsigned)live.viewers(), (unsigned)live.events, (unsigned)live.resyncs,
+           (unsigned)live.replaced);
+  server.sendContent(line);
+#if MQTT_ENABLED
+  snprintf(line, sizeof(line), "mqtt      %s  sent %u  retx %u  dropped %u  rx %u  bytes %u\n",
+           mqtt.stateName(), (unsigned)mqtt.published, (unsigned)mqtt.retransmits,
+           (unsigned)mqtt.dropped, (unsigned)mqtt.received, (unsigned)mqtt.bytesSent);
+  server.sendContent(line);
+#endif
+#if OTA_ENABLED
+  snprintf(line, sizeof(line), "ota       v%u%s  %s v%u  %u/%u bytes  good v%u\n",
+           (unsigned)FIRMWARE_VERSION, ota.trial() ? " (trial)" : "", ota.phaseName(),
+           (unsigned)ota.target(), (unsigned)ota.progress(), (unsigned)ota.size(), (unsigned)ota.good());
+  server.sendContent(line);
+  snprintf(line, sizeof(line), "          checks %u  fetched %u  resumes %u  failed %u\n",
+           (unsigned)ota.checks, (unsigned)ota.downloads, (unsigned)ota.resumes, (unsigned)ota.failures);
+  server.sendContent(line);
+#endif
+#if SILO_ROLE == SILO_NODE
+  snprintf(line, sizeof(line), "espnow    node %u  ch %u  sent %u  failed %u  dropped %u  hops %u\n",
+           (unsigned)SILO_NODE_ID, (unsigned)siloLink.channel(), (unsigned)siloLink.delivered,
+           (unsigned)siloLink.failures, (unsigned)siloLink.dropped, (unsigned)siloLink.hops);
+  server.sendContent(line);
+#elif SILO_ROLE == SILO_GATEWAY
+  snprintf(line, sizeof(line), "gateway   nodes %u  frames %u  bad %u  queued %u  uploaded %u  alerts %u/%u\n",
+           (unsigned)gateway.nodeCount(), (unsigned)gateway.frames, (unsigned)gateway.badFrames,
+           (unsigned)gateway.queued(), (unsigned)gateway.uploaded,
+           (unsigned)gateway.alertsSent, (unsigned)gateway.alertsMerged);
+  server.sendContent(line);
+#endif
+  snprintf(line, sizeof(line), "boot      %s  relay at %u ms\n", bootRestored ? "restored" : "cold",
+           (unsigned)bootDecisionMs);
+  server.sendContent(line);
+  for (uint8_t i = 0; i < resetLog.count(); i++) {
+    const ResetEntry& e = resetLog.entry(i);
+    int n = snprintf(line, sizeof(line), "  #%-5u %-13s after %u s", (unsigned)e.boot,
+                     ResetLog::reasonName(e.reason), (unsigned)e.ranS);
+    if (e.reason == REASON_EXCEPTION_RST)
+      n += snprintf(line + n, sizeof(line) - n, "  exccause %u at 0x%08x", (unsigned)e.exccause, (unsigned)e.epc1);
+    snprintf(line + n, sizeof(line) - n, "\n");
+    server.sendContent(line);
+  }
+  if (journal.ready()) {
+    snprintf(line, sizeof(line), "journal   boot %u  records %u  segments %u  backfilled %u  lost %u\n",
+             (unsigned)journal.boot(), (unsigned)journal.records, (unsigned)journal.segments(),
+             (unsigned)thingspeak.backfilled, (unsigned)(journal.rotatedUnsent + journal.unplaceable));
+    server.sendContent(line);
+  }
+#if UPLOAD_WINDOWS
+  snprintf(line, sizeof(line), "windows   %u s  closed %u  waiting %u  uploaded %u  dropped %u\n",
+           (unsigned)UPLOAD_WINDOW_S, (unsigned)windowLog.nextSeq(), (unsigned)thingspeak.pending(),
+           (unsigned)thingspeak.uploaded, (unsigned)thingspeak.dropped);
+  server.sendContent(line);
+#endif
+  if (anomaly.enabled()) {
+    snprintf(line, sizeof(line), "\nanomaly   scored %u  flagged %u  last_us %u  decision %.3f\n",
+             (unsigned)anomaly.scored, (unsigned)anomaly.anomalies,
+             (unsigned)anomaly.lastScoreUs, anomaly.decision());
+    server.sendContent(line);
+  }
+#if GRAIN_PROBES
+  snprintf(line, sizeof(line), "\nprobes    cycles %u  last_ms %u  max_ms %u  one-by-one_ms %u\n",
+           (unsigned)probes.cycles, (unsigned)probes.lastCycleMs, (unsigned)probes.maxCycleMs,
+           (unsigned)probes.sequentialMs);
+  server.sendContent(line);
+  for (uint8_t i = 0; i < probes.count(); i++) {
+    const Probe& p = probes.probe(i);
+    const ProbeReading& r = probes.reading(i);
+    snprintf(line, sizeof(line), "  %-8s %4ucm %-8s %6.2fC %5.1f%%  reads %u  failed %u  read_us %u%s\n",
+             p.name, (unsigned)p.depthCm, p.bus->kind(), r.temp, r.hum, (unsigned)probes.reads(i),
+             (unsigned)probes.failures(i), (unsigned)probes.lastReadUs(i),
+             probes.stale(i, millis()) ? "  STALE" : "");
+    server.sendContent(line);
+  }
+#endif
+  if (forecast.enabled()) {
+    snprintf(line, sizeof(line), "forecast  steps %u  peak %.1f%%  risk_in %.1fh  last_us %u  max_us %u  over %u\n",
+             (unsigned)forecast.updates, forecast.peakHum(), forecast.hoursToRisk(),
+             (unsigned)forecast.lastUs, (unsigned)forecast.maxUs, (unsigned)forecast.overBudget);
+    server.sendContent(line);
+  }
+  server.sendContent("");
+}
+
+// Prometheus text format at /metrics, for the site Prometheus to scrape
+void handleMetrics() {
+  char labels[48];
+  MetricsWriter m(server);
+
+  m.metric("silo_uptime_seconds", "gauge", "Time since boot.", (uint32_t)(millis() / 1000));
+  m.family("silo_boot_info", "gauge", "Reason for the last reset.");
+  snprintf(labels, sizeof(labels), "reason=\"%s\"", platformResetText().c_str());
+  m.sample("silo_boot_info", labels, (uint32_t)1);
+  m.metric("silo_boot_relay_decision_seconds", "gauge", "Reset to the first relay decision.", bootDecisionMs * 1e-3f);
+  m.metric("silo_boot_state_restored", "gauge", "1 when the control state came back from RTC memory.", (uint32_t)bootRestored);
+
+  m.metric("silo_heap_free_bytes", "gauge", "Free heap.", (uint32_t)ESP.getFreeHeap());
+  m.metric("silo_heap_free_min_bytes", "gauge", "Lowest free heap seen after a task.", minFreeHeap);
+  m.metric("silo_heap_max_block_bytes", "gauge", "Largest allocatable block.", platformMaxFreeBlock());
+  m.metric("silo_heap_fragmentation_percent", "gauge", "Heap fragmentation.", platformHeapFragmentation());
+
+  m.family("silo_loop_duration_seconds", "histogram", "loop() passes that ran a task.");
+  m.histogram("silo_loop_duration_seconds", nullptr, perfLoop);
+  m.family("silo_probe_duration_seconds", "histogram", "Time spent in instrumented code paths.");
+  m.histogram("silo_probe_duration_seconds", "probe=\"dht\"", perfDht);
+  m.histogram("silo_probe_duration_seconds", "probe=\"page\"", perfPage);
+  m.histogram("silo_probe_duration_seconds", "probe=\"alert\"", perfAlert);
+  m.histogram("silo_probe_duration_seconds", "probe=\"telegram\"", perfTelegram);
+  m.histogram("silo_probe_duration_seconds", "probe=\"thingspeak\"", perfThingSpeak);
+
+  m.family("silo_task_runs_total", "counter", "Scheduler task runs.");
+  for (const Task& t : tasks) {
+    snprintf(labels, sizeof(labels), "task=\"%s\"", t.name);
+    m.sample("silo_task_runs_total", labels, t.runs);
+  }
+  m.family("silo_task_overruns_total", "counter", "Task starts later than their deadline.");
+  for (const Task& t : tasks) {
+    snprintf(labels, sizeof(labels), "task=\"%s\"", t.name);
+    m.sample("silo_task_overruns_total", labels, t.overruns);
+  }
+  m.family("silo_task_max_run_seconds", "gauge", "Longest task run since boot.");
+  for (const Task& t : tasks) {
+    snprintf(labels, sizeof(labels), "task=\"%s\"", t.name);
+    m.sample("silo_task_max_run_seconds", labels, t.maxRunUs * 1e-6f);
+  }
+#if SILO_DUAL_CORE
+  m.family("silo_core_link_dropped_total", "counter", "Entries lost to a full ring between the cores.");
+  m.sample("silo_core_link_dropped_total", "ring=\"samples\"", coreLink.samples.dropped);
+  m.sample("silo_core_link_dropped_total", "ring=\"alerts\"", coreLink.alerts.dropped);
+  m.sample("silo_core_link_dropped_total", "ring=\"commands\"", coreLink.commands.dropped);
+#endif
+
+  m.metric("silo_wifi_connected", "gauge", "1 while associated.", (uint32_t)wifi.connected());
+  m.metric("silo_wifi_rssi_dbm", "gauge", "Signal strength (0 when not associated).", (float)wifi.rssi());
+  m.metric("silo_wifi_connects_total", "counter", "Successful associations.", wifi.connects);
+  m.metric("silo_wifi_fast_connects_total", "counter", "Associations using the cached AP.", wifi.fastConnects);
+  m.metric("silo_wifi_connect_failures_total", "counter", "Connect attempts that timed out.", wifi.failures);
+  m.metric("silo_wifi_disconnects_total", "counter", "Established links that dropped.", wifi.disconnects);
+
+  // Counted in windows when UPLOAD_WINDOW_S is set
+  m.metric("silo_upload_samples_total", "counter", "Samples accepted by ThingSpeak.", thingspeak.uploaded);
+  m.metric("silo_upload_requests_total", "counter", "Successful ThingSpeak bulk requests.", thingspeak.posts);
+  m.metric("silo_upload_failures_total", "counter", "Failed ThingSpeak bulk requests.", thingspeak.failures);
+  m.metric("silo_upload_dropped_samples_total", "counter", "Samples lost before upload.", thingspeak.dropped);
+  m.metric("silo_upload_pending_samples", "gauge", "Samples waiting for ThingSpeak.", thingspeak.pending());
+
+  m.metric("silo_alerts_sent_total", "counter", "Telegram alerts delivered.", telegram.sent);
+  m.metric("silo_alerts_failed_total", "counter", "Telegram alerts given up after retries.", telegram.failed);
+  m.metric("silo_alerts_dropped_total", "counter", "Telegram alerts dropped from a full queue.", telegram.dropped);
+  m.metric("silo_telegram_tls_connects_total", "counter", "TLS handshakes with Telegram (full or resumed).", telegram.tlsConnects);
+  m.metric("silo_telegram_tls_connect_seconds", "gauge", "Last connect + handshake time.", telegram.lastConnectMs * 1e-3f);
+  m.metric("silo_telegram_tls_connect_max_seconds", "gauge", "Longest connect + handshake time.", telegram.maxConnectMs * 1e-3f);
+  m.metric("silo_telegram_commands_total", "counter", "Chat commands executed.", telegram.commands);
+  m.metric("silo_alerts_folded_total", "counter", "Alert notifications folded into a digest.", digest.folded);
+  m.metric("silo_alert_digests_total", "counter", "Digest messages sent.", digest.digests);
+  m.metric("silo_alerts_raised_total", "counter", "Alert rules that started and were announced.", alarms.raised);
+  m.metric("silo_alerts_suppressed_total", "counter", "Alert starts held back by the rule's cooldown.", alarms.suppressed);
+  m.metric("silo_alerts_cleared_total", "counter", "Announced alerts that ended.", alarms.cleared);
+#if GRAIN_PROBES
+  m.metric("silo_probe_cycle_seconds", "gauge", "Last cycle over all probes, buses in parallel.", probes.lastCycleMs * 1e-3f);
+  m.family("silo_probe_temperature_celsius", "gauge", "Grain probe temperature (stale probes omitted).");
+  for (uint8_t i = 0; i < probes.count(); i++) {
+    if (probes.stale(i, millis()) || isnan(probes.reading(i).temp)) continue;
+    snprintf(labels, sizeof(labels), "probe=\"%s\"", probes.probe(i).name);
+    m.sample("silo_probe_temperature_celsius", labels, probes.reading(i).temp);
+  }
+  m.family("silo_probe_humidity_percent", "gauge", "Grain probe humidity (stale probes omitted).");
+  for (uint8_t i = 0; i < probes.count(); i++) {
+    if (probes.stale(i, millis()) || isnan(probes.reading(i).hum)) continue;
+    snprintf(labels, sizeof(labels), "probe=\"%s\"", probes.probe(i).name);
+    m.sample("silo_probe_humidity_percent", labels, probes.reading(i).hum);
+  }
+  m.family("silo_probe_failures_total", "counter", "Failed probe reads.");
+  for (uint8_t i = 0; i < probes.count(); i++) {
+    snprintf(labels, sizeof(labels), "probe=\"%s\"", probes.probe(i).name);
+    m.sample("silo_probe_failures_total", labels, probes.failures(i));
+  }
+#endif
+  if (forecast.enabled()) {
+    m.metric("silo_forecast_updates_total", "counter", "Humidity forecast steps run.", forecast.updates);
+    m.metric("silo_forecast_run_seconds", "gauge", "Last forecast update time.", forecast.lastUs * 1e-6f);
+    m.metric("silo_forecast_run_max_seconds", "gauge", "Longest forecast update time.", forecast.maxUs * 1e-6f);
+    m.metric("silo_forecast_budget_seconds", "gauge", "Time allowed per forecast update.", FORECAST_BUDGET_US * 1e-6f);
+    m.metric("silo_forecast_over_budget_total", "counter", "Forecast updates over the budget.", forecast.overBudget);
+    m.metric("silo_forecast_peak_humidity_percent", "gauge", "Highest forecast humidity over the horizon.", forecast.peakHum());
+    m.metric("silo_fan_preempted_total", "counter", "Fan runs started early by the forecast.", fan.preempted);
+  }
+  m.metric("silo_alert_latency_max_seconds", "gauge", "Slowest alert, queue to delivery.", telegram.maxLatencyMs * 1e-3f);
+#if MQTT_ENABLED
+  m.metric("silo_mqtt_connected", "gauge", "1 while the broker session is up.", (uint32_t)mqtt.connected());
+  m.metric("silo_mqtt_published_total", "counter", "MQTT messages sent (QoS 1: acknowledged).", mqtt.published);
+  m.metric("silo_mqtt_failures_total", "counter", "MQTT connects refused or links lost.", mqtt.failures);
+  m.metric("silo_mqtt_dropped_total", "counter", "MQTT messages not sent.", mqtt.dropped);
+#endif
+#if OTA_ENABLED
+  m.metric("silo_firmware_version", "gauge", "FIRMWARE_VERSION of the running image.", (uint32_t)FIRMWARE_VERSION);
+  m.metric("silo_ota_trial", "gauge", "1 until the running version is confirmed.", (uint32_t)ota.trial());
+  m.metric("silo_ota_checks_total", "counter", "Release index fetches.", ota.checks);
+  m.metric("silo_ota_downloads_total", "counter", "Images received and verified.", ota.downloads);
+  m.metric("silo_ota_failures_total", "counter", "Failed checks and downloads.", ota.failures);
+  m.metric("silo_ota_resumes_total", "counter", "Downloads resumed after a dropped link.", ota.resumes);
+  m.metric("silo_ota_received_bytes_total", "counter", "Image bytes received.", ota.bytes);
+  m.metric("silo_ota_download_seconds", "gauge", "Duration of the last complete download.", ota.lastMs * 1e-3f);
+#endif
+}
+
+#if SILO_ROLE == SILO_GATEWAY
+// Plain-text per-node table at /silos (latest frame, link quality)
+void handleSilos() {
+  char line[160];
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain", "");
+  server.sendContent("node  mac                age_s   frames   lost   loss%  dup   reboots  temp   hum   gas   fan  alert\n");
+  for (uint8_t i = 0; i < gateway.nodeCount(); i++) {
+    const SiloNodeState& n = gateway.node(i);
+    const SiloFrame& f = n.latest;
+    char t[8] = "-", h[8] = "-";
+    if (f.temp != HISTORY_TEMP_NONE) snprintf(t, sizeof(t), "%.1f", f.temp / 100.0f);
+    if (f.hum != HISTORY_HUM_NONE) snprintf(h, sizeof(h), "%.1f", f.hum / 2.0f);
+    float loss = n.expected() ? n.lost * 100.0f / n.expected() : 0;
+    snprintf(line, sizeof(line),
+             "%-5u %02x:%02x:%02x:%02x:%02x:%02x  %-7u %-8u %-6u %-6.1f %-5u %-8u %-6s %-5s %-5u %-4s %s%s\n",
+             (unsigned)n.id, n.mac[0], n.mac[1], n.mac[2], n.mac[3], n.mac[4], n.mac[5],
+             (unsigned)((millis() - n.lastSeenMs) / 1000), (unsigned)n.frames, (unsigned)n.lost,
+             loss, (unsigned)n.duplicates, (unsigned)n.reboots, t, h, (unsigned)f.gas,
+             (f.flags & SILO_FLAG_FAN) ? "on" : "off", ALERT_NAME[f.alert < SILO_ALERT_COUNT ? f.alert : 0],
+             n.offline ? " (offline)" : "");
+    server.sendContent(line);
+  }
+  server.sendContent("");
+}
+#endif
+
+// ==========================================
+// TRACE REPLAY (TRACE_REPLAY)
+// ==========================================
+// Recorded frames stand in for the DHT, the MQ-2 and the PIR, and the
+// control tasks run on a virtual clock (see trace_replay.h). The tick
+// sequence is the scheduler's: gas and alarm every 50 ms, fan every 500 ms,
+// then the sample work once per frame.
+#if TRACE_REPLAY
+#define TRACE_TICK_MS 50
+TraceReader traceIn;
+TraceStats traceStats;
+File traceFile;
+uint32_t traceNowMs = 0;    // Virtual millis()
+uint32_t traceLastMs = 0;   // Trace time of the previous frame
+
+void replayFrame(const TraceFrame& f) {
+  uint32_t gap = traceStats.frames ? f.ms - traceLastMs : TRACE_TICK_MS;
+  if ((int32_t)gap < 0) gap = TRACE_TICK_MS;  // Out of order: one tick
+  uint32_t ticks = min(gap, (uint32_t)TRACE_REPLAY_MAX_GAP_MS) / TRACE_TICK_MS;
+  if (!ticks) ticks = 1;
+  traceLastMs = f.ms;
+
+  bool climateOk = !isnan(f.temp) && !isnan(f.hum);
+  if (climateOk) {
+    temp = f.temp;
+    hum = f.hum;
+  }
+  dhtStale = !climateOk;  // Last good values stay, like a stale DHT
+  motion = f.motion ? HIGH : LOW;
+  traceQueued = 0;
+
+  uint32_t frameStart = micros();
+  uint32_t worstTick = 0;
+  for (uint32_t i = 0; i < ticks; i++) {
+    uint32_t tickStart = micros();
+    traceNowMs += TRACE_TICK_MS;
+    gas.update(f.gas, traceNowMs);
+    takeGas();
+    if (traceStats.ticks++ % (500 / TRACE_TICK_MS) == 0) applyFan(traceNowMs);
+    applyAlarm(traceNowMs);
+    uint32_t us = micros() - tickStart;
+    if (us > worstTick) worstTick = us;
+  }
+  history.push(traceNowMs, climateOk ? temp : NAN, climateOk ? hum : NAN, gasValue, gasFiltered, f.motion);
+  fermentationRisk = anomaly.update() && anomaly.confirmed();
+  updateForecast(traceNowMs);
+  uint32_t frameUs = micros() - frameStart;
+
+  traceStats.frames++;
+  traceStats.busyUs += frameUs;
+  traceStats.alerts += traceQueued;
+  if (frameUs > traceStats.worstFrameUs) traceStats.worstFrameUs = frameUs;
+  if (worstTick > traceStats.worstTickUs) traceStats.worstTickUs = worstTick;
+  if (traceQueued) Serial.printf("A,%u,%s\n", (unsigned)f.ms, ALERT_NAME[alertCode]);
+  Serial.printf("D,%u,%s,%d,%d,%u,%u,%u\n", (unsigned)f.ms, ALERT_NAME[alertCode], (int)buzzerPattern,
+                (int)isFanRunning, (unsigned)traceQueued, (unsigned)frameUs, (unsigned)worstTick);
+}
+
+void setupReplay() {
+  Serial.setRxBufferSize(TRACE_REPLAY_RX_BUFFER);
+  Serial.begin(TRACE_REPLAY_BAUD);
+  pinMode(BUZZER_PIN, OUTPUT);
+  pinMode(RELAY_PIN, OUTPUT);
+  digitalWrite(RELAY_PIN, RELAY_OFF);
+  digitalWrite(BUZZER_PIN, LOW);
+  if (LittleFS.begin() && LittleFS.exists(TRACE_REPLAY_FILE)) traceFile = LittleFS.open(TRACE_REPLAY_FILE, "r");
+  Serial.printf("\n# trace replay ready: %s, window %u\n",
+                traceFile ? TRACE_REPLAY_FILE : "serial", (unsigned)TRACE_REPLAY_WINDOW);
+}
+
+// One frame per loop() pass, so the WiFi stack and the watchdog still get their time
+void taskReplay() {
+  TraceFrame f;
+  Stream& in = traceFile ? (Stream&)traceFile : (Stream&)Serial;
+  if (traceIn.poll(in, f)) replayFrame(f);
+  if (traceIn.ended || (traceFile && !traceFile.available())) {
+    traceStats.printSummary(Serial);
+    if (traceIn.rejected) Serial.printf("# %u line(s) rejected\n", (unsigned)traceIn.rejected);
+    Serial.flush();
+    ESP.restart();
+  }
+}
+#endif
+
+// ==========================================
+// DUAL CORE (ESP32, SILO_DUAL_CORE)
+// ==========================================
+// WiFi, lwIP and the TLS handshakes run on core 0, next to the network
+// task; the control task has core 1 to itself. A two-second handshake or a
+// slow dashboard client can't delay a relay decision, and the models get a
+// whole core. Each task runs its slice of tasks[] with its own Scheduler,
+// like loop() on the ESP8266. The stats in /tasks and /metrics are read
+// across cores without a lock: 32-bit counters are read whole, at worst one
+// update old.
+#if SILO_DUAL_CORE
+#define CONTROL_CORE 1
+#define NETWORK_CORE 0
+#define CONTROL_PRIORITY 3           // Above the Arduino loop task (1)
+#define NETWORK_PRIORITY 2           // Below the WiFi and lwIP tasks
+#define CONTROL_STACK 8192
+#define NETWORK_STACK 16384          // mbedTLS handshake
+
+void runControl(void*) {
+  controlScheduler.begin();
+  for (;;) {
+    uint32_t start = ESP.getCycleCount();
+    if (controlScheduler.runNext()) {
+      perfLoop.record(ESP.getCycleCount() - start);
+      uint32_t heap = ESP.getFreeHeap();
+      if (heap < minFreeHeap) minFreeHeap = heap;
+    } else {
+      vTaskDelay(1);
+    }
   }
+}
 
-  html += "</body></html>";
-  server.send(200, "text/html", html);
+void runNetwork(void*) {
+  networkScheduler.begin();
+  for (;;) {
+    if (!networkScheduler.runNext()) vTaskDelay(1);  // Idle time goes to WiFi and lwIP
+  }
 }
+#endif
 
 // ==========================================
 // STANDARD SETUP & LOOP
 // ==========================================
 void setup() {
+#if TRACE_REPLAY
+  setupReplay();
+  return;
+#endif
   Serial.begin(115200);
+#if SILO_DUAL_CORE
+  analogReadResolution(10);  // The MQ-2 thresholds are 10-bit counts
+#endif
   
   pinMode(PIR_PIN, INPUT);
   pinMode(BUZZER_PIN, OUTPUT);
@@ -141,119 +1494,138 @@ void setup() {
   
   // Force fan OFF immediately on startup using our cheat code
   digitalWrite(RELAY_PIN, RELAY_OFF); 
+#if POWER_MODE != POWER_DEEP_SLEEP
+  fastBoot();  // Relay and alarm decided from the saved state; everything below is slower
+#endif
+
+#if OTA_ENABLED
+  // Before anything that could be what crashed a new version
+  LittleFS.begin();
+  if (ota.begin()) {
+    // Rollback: the control tasks, WiFi and the updater (rescueTasks). The
+    // relay and alarm stay as fastBoot() decided them.
+    dht.begin();
+    pir.begin(PIR_PIN);
+    wifi.begin(ssid, password);
+    rescueScheduler.begin();
+    return;
+  }
+#endif
   
   dht.begin();
+  pir.begin(PIR_PIN);
+#if GRAIN_PROBES
+  Wire.begin();
+  probes.begin();
+  for (uint8_t i = 0; i < grainString.found(); i++) {
+    const uint8_t* rom = grainString.rom(i);
+    Serial.printf("DS18B20 %u: %02X%02X%02X%02X%02X%02X%02X%02X\n", (unsigned)i,
+                  rom[0], rom[1], rom[2], rom[3], rom[4], rom[5], rom[6], rom[7]);
+  }
+#endif
+
+  bool woke = power.begin();
+#if POWER_MODE == POWER_DEEP_SLEEP
+  if (woke && !power.fullWake()) quickWake(); // Back to sleep, no radio
+  // The RTC accumulator replaces the journal here: every wake is a new boot
+  power.restoreGas(gas);
+  power.replay(history);
+  wakeSeq = history.nextSeq();
+#else
+  (void)woke;
+#if SILO_DUAL_CORE
+  LittleFS.begin(true);  // Formats a blank partition, as the ESP8266 core does by itself
+#endif
+  if (SILO_ROLE != SILO_NODE && journal.begin()) thingspeak.useJournal(&journal);
+  if (journal.ready() || LittleFS.begin()) resetLog.record(bootRanS);
+#endif
+#if POWER_MODE != POWER_ALWAYS_ON
+  // The radio windows do the batching: send whatever is waiting
+  thingspeak.setBatching(UPLOAD_BATCH_MAX, 0);
+#elif MQTT_ENABLED
+  // Live values go out over MQTT; ThingSpeak only archives, in fewer requests
+  thingspeak.setBatching(UPLOAD_BATCH_MAX, MQTT_ARCHIVE_FLUSH_MS);
+#endif
+#if UPLOAD_WINDOWS
+  windowStats.begin(UPLOAD_WINDOW_S * 1000UL, millis());
+  thingspeak.useWindows(&windowLog, UPLOAD_WINDOW_S);
+#endif
 
   Serial.println("\n--- Starting Smart Grain Monitor ---");
-  Serial.print("Connecting to WiFi");
-  
-  WiFi.begin(ssid, password);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print("."); 
-  }
-  
-  Serial.println("\nWiFi Connected!");
-  Serial.print("IP Address for your Webpage: ");
-  Serial.println(WiFi.localIP()); 
+  Serial.printf("Reset: %s, relay decided %u ms after it (%s)\n", platformResetText().c_str(),
+                (unsigned)bootDecisionMs, bootRestored ? "state restored" : "cold start");
+
+  // Monitoring starts now; the link comes up in the background (taskWifi)
+  // and the web server answers as soon as it does.
+#if SILO_ROLE == SILO_NODE
+  siloLink.begin(SILO_NODE_ID, gatewayMac); // No AP, no cloud: ESP-NOW only
+#else
+  wifi.begin(ssid, password);
+  configTime(0, 0, "pool.ntp.org", "time.nist.gov"); // UTC, for journal timestamps
+#if SILO_ROLE == SILO_GATEWAY
+  gateway.begin();
+  server.on("/silos", handleSilos);
+#endif
+  // A long poll would hold the radio awake, and a gateway's chat is for the whole site
+  if (TELEGRAM_COMMANDS && SILO_ROLE == SILO_STANDALONE && POWER_MODE == POWER_ALWAYS_ON)
+    telegram.onCommand(handleTelegramCommand);
+#if MQTT_ENABLED
+  snprintf(mqttClientId, sizeof(mqttClientId), "silo-%06x", (unsigned)platformChipId());
+  mqtt.setWill(MQTT_TOPIC "/status", "offline", "online");
+  mqtt.subscribe(MQTT_TOPIC "/cmd");
+  mqtt.onMessage(handleMqttCommand);
+  mqtt.begin(mqttHost, mqttPort, mqttClientId, mqttUser, mqttPassword);
+#endif
+#endif
 
-  server.on("/", handleRoot);
+  for (uint8_t i = 0; i < kStaticAssetCount; i++) {
+    const StaticAsset& a = kStaticAssets[i];
+    server.on(a.path, [&a]() {
+      PerfScope probe(perfPage);
+      serveStaticAsset(server, a);
+    });
+  }
+  server.collectHeaders(kStaticAssetHeaders, sizeof(kStaticAssetHeaders) / sizeof(kStaticAssetHeaders[0]));
+  server.on("/lite", handleLite);
+  server.on("/state", handleState);
+  server.on("/history", handleHistory);
+  server.on("/tasks", handleTasks);
+  server.on("/events", handleEvents);
+  server.on("/metrics", handleMetrics);
   server.begin();
+
+#if SILO_DUAL_CORE
+  netView = captureState(millis());
+  xTaskCreatePinnedToCore(runControl, "control", CONTROL_STACK, nullptr, CONTROL_PRIORITY, nullptr, CONTROL_CORE);
+  xTaskCreatePinnedToCore(runNetwork, "network", NETWORK_STACK, nullptr, NETWORK_PRIORITY, nullptr, NETWORK_CORE);
+#else
+  scheduler.begin();
+#endif
 }
 
 void loop() {
-  server.handleClient();
-  
-  gasValue = analogRead(GAS_PIN);
-  motion = digitalRead(PIR_PIN);
-  
-  float t = dht.readTemperature();
-  float h = dht.readHumidity();
-  if (!isnan(t)) temp = t;
-  if (!isnan(h)) hum = h;
-
-  // ---> AUTOMATED EXHAUST FAN LOGIC <---
-  if (hum > 50.0 || gasValue > 90) {
-    digitalWrite(RELAY_PIN, RELAY_ON); // Turn Fan ON
-    isFanRunning = true;
-  } else {
-    digitalWrite(RELAY_PIN, RELAY_OFF);  // Turn Fan OFF safely
-    isFanRunning = false;
-  }
-
-  // ---> MULTI-STAGE ALARM LOGIC (WITH TELEGRAM) <---
-  // Priority 1: Gas/Smoke (most critical — fire or spoilage)
-  if (gasValue > 90) {
-    alertStatus = "SPOILAGE ALERT!";
-    digitalWrite(BUZZER_PIN, HIGH); // Solid continuous beep for gas/fire
-    
-    if (millis() - lastTelegramMsg > 60000) {
-      sendTelegram("🚨 CRITICAL ALERT: High Gas/Smoke detected in Grain Silo!");
-      lastTelegramMsg = millis();
-    }
-  }
-  // Priority 2: High Humidity (mold risk)
-  else if (hum > 60.0) {
-    alertStatus = "HIGH HUMIDITY ALERT!";
-    // Non-blocking slow pulse: 300ms on / 300ms off
-    if (millis() - lastBuzzerToggle > 300) {
-      buzzerState = !buzzerState;
-      digitalWrite(BUZZER_PIN, buzzerState ? HIGH : LOW);
-      lastBuzzerToggle = millis();
-    }
-    
-    if (millis() - lastTelegramMsg > 60000) {
-      sendTelegram("💧 CLIMATE ALERT: Humidity > 60%. Exhaust Fan activated to purge air.");
-      lastTelegramMsg = millis();
-    }
+#if TRACE_REPLAY
+  taskReplay();
+  return;
+#endif
+#if OTA_ENABLED
+  if (ota.rescue()) {
+    if (!rescueScheduler.runNext() && rescueScheduler.idleMs() > 0) delay(1);
+    return;
   }
-  // Priority 3: Motion (intruder/rodent)
-  else if (motion == HIGH) {
-    alertStatus = "INTRUDER DETECTED!";
-    // Non-blocking fast pulse: 150ms on / 150ms off
-    if (millis() - lastBuzzerToggle > 150) {
-      buzzerState = !buzzerState;
-      digitalWrite(BUZZER_PIN, buzzerState ? HIGH : LOW);
-      lastBuzzerToggle = millis();
-    }
-    
-    if (millis() - lastTelegramMsg > 60000) {
-      sendTelegram("⚠️ SECURITY ALERT: Motion detected at Grain Silo hatch!");
-      lastTelegramMsg = millis();
-    }
+#endif
+#if SILO_DUAL_CORE
+  vTaskDelete(nullptr);  // Both sides run in their own tasks (setup())
+#else
+  // Run due tasks one at a time; only when nothing is due, give the idle
+  // time back to the WiFi stack.
+  uint32_t start = ESP.getCycleCount();
+  if (scheduler.runNext()) {
+    perfLoop.record(ESP.getCycleCount() - start);
+    uint32_t heap = ESP.getFreeHeap();
+    if (heap < minFreeHeap) minFreeHeap = heap;
+  } else if (scheduler.idleMs() > 0) {
+    delay(1);
   }
-  // All clear
-  else {
-    alertStatus = "SAFE";
-    digitalWrite(BUZZER_PIN, LOW);
-    buzzerState = false;
-  }
-  
-  // ---> THINGSPEAK CLOUD UPLOAD (Every 20 Seconds) <---
-  if (millis() - lastCloudUpload > 20000) {
-    if (WiFi.status() == WL_CONNECTED) {
-      if (client.connect(serverName, 80)) {
-        String postStr = apiKey;
-        postStr += "&field1=" + String(temp);
-        postStr += "&field2=" + String(hum);
-        postStr += "&field3=" + String(gasValue);
-        postStr += "&field4=" + String(motion); 
-        postStr += "\r\n\r\n";
-
-        client.print("POST /update HTTP/1.1\n");
-        client.print("Host: api.thingspeak.com\n");
-        client.print("Connection: close\n");
-        client.print("X-THINGSPEAKAPIKEY: " + String(apiKey) + "\n");            
-        client.print("Content-Type: application/x-www-form-urlencoded\n");
-        client.print("Content-Length: " + String(postStr.length()) + "\n\n");
-        client.print(postStr);
-        
-        Serial.println("Data sent to ThingSpeak!");
-        lastCloudUpload = millis();
-      }
-      client.stop();
-    }
-  }
-
-  delay(100);
-}
\ No newline at end of file
+#endif
+}
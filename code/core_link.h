@@ -0,0 +1,98 @@
+#pragma once
+
+// ==========================================
+// CONTROL / NETWORK HANDOFF (PORTABLE CORE)
+// ==========================================
+// The firmware has two sides. The control side reads the sensors, decides
+// the alarms and the fan, and runs the models. The network side runs WiFi,
+// TLS, the uploads, MQTT, Telegram and the web server. What the network
+// side shows or sends about the silo comes from a SiloState snapshot; what
+// it changes goes back as a SiloCommand.
+//
+// On the ESP8266 both sides share loop(): the snapshot is taken from the
+// control globals when it is needed, and a command is applied at once. On
+// the ESP32 (SILO_DUAL_CORE, platform.h) each side is a task on its own
+// core, and CoreLink's rings are the only way across:
+//   states    control -> network   every CORE_LINK_STATE_MS
+//   samples   control -> network   every history sample (journal, uploads)
+//   alerts    control -> network   with the state that raised them
+//   windows   control -> network   every closed upload window (UPLOAD_WINDOW_S)
+//   commands  network -> control   /fan, /mute, MQTT settings
+// Neither side ever waits for the other. A full ring drops the newest
+// entry and counts it (/tasks).
+
+#include <Arduino.h>
+#include "sample_history.h"
+#include "silo_logic.h"
+#include "spsc_ring.h"
+#include "window_stats.h"
+
+#define CORE_LINK_STATE_MS 50        // Snapshot rate (the alarm task's period)
+#define CORE_LINK_STATES 4
+#define CORE_LINK_SAMPLES 8          // 2 min of samples: a stalled network side catches up
+#define CORE_LINK_ALERTS 8
+#define CORE_LINK_WINDOWS 4
+#define CORE_LINK_COMMANDS 4
+#define CORE_LINK_TEXT_MAX 160       // Alert text (TELEGRAM_MSG_MAX)
+
+struct SiloState {
+  SiloReadings readings;
+  const char* status;                // String literal (ALARM_RULES): fine on either core
+  SiloAlert alert;
+  bool fan;                          // Relay on
+  uint8_t fanOverride;               // FanController::Override
+  float humAlarmPct;
+  uint16_t gasAlarmEnter;
+  uint16_t gasAlarmExit;
+  uint32_t muteLeftMs;               // Alert mute left when taken
+};
+
+// One history sample with its grain probes, as the control side took it
+struct SiloSample {
+  uint32_t ms;
+  float temp;                        // NaN = missing
+  float hum;
+  uint16_t gas;
+  uint16_t gasFiltered;
+  uint8_t motion;                    // Events in the sample period
+  uint8_t probes;                    // Bit i set: probe i was read
+  float probeTemp[GRAIN_PROBES ? GRAIN_PROBES : 1];
+  float probeHum[GRAIN_PROBES ? GRAIN_PROBES : 1];
+};
+static_assert(GRAIN_PROBES <= 8, "SiloSample keeps one bit per probe");
+
+inline void addSample(SampleHistory& history, const SiloSample& s) {
+  history.push(s.ms, s.temp, s.hum, s.gas, s.gasFiltered, s.motion);
+  for (int i = 0; i < GRAIN_PROBES; i++) {
+    if (s.probes >> i & 1) history.recordProbe(i, s.probeTemp[i], s.probeHum[i]);
+  }
+}
+
+enum SiloCommandBits : uint8_t {
+  CMD_FAN = 1 << 0,                  // fanMode for fanMs
+  CMD_THRESHOLDS = 1 << 1,           // humAlarmPct, gasAlarmEnter/Exit
+  CMD_MUTE = 1 << 2,                 // muteMs, 0 = unmute
+};
+
+struct SiloCommand {
+  uint8_t what;                      // SiloCommandBits
+  uint8_t fanMode;                   // FanController::Override
+  uint32_t fanMs;
+  float humAlarmPct;
+  uint16_t gasAlarmEnter;
+  uint16_t gasAlarmExit;
+  uint32_t muteMs;
+};
+
+struct SiloAlertText {
+  SiloState state;                   // For the MQTT alert frame
+  char text[CORE_LINK_TEXT_MAX];
+};
+
+struct CoreLink {
+  SpscRing<SiloState, CORE_LINK_STATES> states;
+  SpscRing<SiloSample, CORE_LINK_SAMPLES> samples;
+  SpscRing<SiloAlertText, CORE_LINK_ALERTS> alerts;
+  SpscRing<WindowSummary, CORE_LINK_WINDOWS> windows;
+  SpscRing<SiloCommand, CORE_LINK_COMMANDS> commands;
+};
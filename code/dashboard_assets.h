@@ -0,0 +1,141 @@
+#pragma once
+
+// ==========================================
+// DASHBOARD ASSETS (GENERATED)
+// ==========================================
+// Written by code/web/build_assets.py from the sources in code/web/.
+// Do not edit; change the sources and re-run the script.
+//
+//   path              source  minified  gzip
+//   /dashboard.css    2095    1782      722
+//   /dashboard.js     1134    958       479
+//   /                 1164    1094      553
+
+#include "static_assets.h"
+
+static const uint8_t kAsset_dashboard_css[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x54, 0x5d, 0x8f, 0xa3, 0x20,
+  0x14, 0xfd, 0x2b, 0x26, 0x9b, 0xc9, 0xcc, 0x24, 0xd5, 0xa0, 0xad, 0xad, 0xc5, 0x97, 0x7d, 0xdb,
+  0xec, 0xf3, 0x7e, 0x24, 0xfb, 0x78, 0x15, 0x50, 0x76, 0x14, 0x0c, 0xe0, 0xb4, 0x5d, 0xe3, 0x7f,
+  0x5f, 0xd0, 0xda, 0x5a, 0xa7, 0x93, 0xcc, 0x84, 0x04, 0x25, 0xf7, 0x70, 0xb8, 0xf7, 0xdc, 0x03,
+  0x99, 0x24, 0xa7, 0x8e, 0x49, 0x61, 0x7c, 0x06, 0x35, 0xaf, 0x4e, 0xf8, 0xf1, 0x07, 0x2d, 0x24,
+  0xf5, 0x7e, 0x7d, 0x7f, 0x5c, 0xfd, 0x84, 0x52, 0xd6, 0xb0, 0xfa, 0x46, 0x05, 0x7d, 0x85, 0xd5,
+  0x6f, 0xaa, 0x08, 0x08, 0x58, 0x69, 0x10, 0xda, 0xd7, 0x54, 0x71, 0x96, 0x66, 0x90, 0xbf, 0x14,
+  0x4a, 0xb6, 0x82, 0xf8, 0xb9, 0xac, 0xa4, 0xc2, 0x5f, 0x68, 0xc2, 0x62, 0xba, 0x4f, 0xcf, 0xab,
+  0x30, 0x8b, 0x69, 0x84, 0xd2, 0x1a, 0x54, 0xc1, 0x05, 0x46, 0x69, 0x03, 0x84, 0x70, 0x51, 0xe0,
+  0x08, 0x35, 0xc7, 0xd4, 0xd0, 0xa3, 0xf1, 0xa1, 0xe2, 0x85, 0xc0, 0x39, 0x15, 0x86, 0xaa, 0xbe,
+  0x0c, 0xbb, 0x11, 0xea, 0x67, 0xd2, 0x18, 0x59, 0xe3, 0xd8, 0xc2, 0x86, 0xdc, 0x34, 0xff, 0x47,
+  0x71, 0x14, 0x44, 0xb4, 0x9e, 0xa8, 0x23, 0xba, 0x23, 0xeb, 0xa8, 0x6f, 0x02, 0xdd, 0x66, 0x86,
+  0x9b, 0x8a, 0x76, 0xe7, 0xc0, 0x26, 0x07, 0x16, 0xa3, 0xd9, 0xb6, 0x30, 0x08, 0xed, 0xb6, 0x33,
+  0xb1, 0x91, 0x0d, 0x9e, 0x12, 0x9a, 0x4e, 0x59, 0xa3, 0xe9, 0x98, 0x03, 0xe5, 0x45, 0x69, 0x70,
+  0x26, 0x2b, 0xd2, 0x07, 0x85, 0xe2, 0xa4, 0x23, 0x5c, 0x37, 0x15, 0x9c, 0x30, 0xab, 0xa8, 0xc5,
+  0xd8, 0xc9, 0x3f, 0x28, 0x68, 0xb0, 0x9b, 0xd2, 0xbf, 0xad, 0x36, 0x9c, 0x9d, 0x6c, 0xe9, 0x36,
+  0x7b, 0x61, 0xce, 0x55, 0xa4, 0x85, 0x8d, 0x0f, 0x05, 0xd6, 0x60, 0xd1, 0x9c, 0x98, 0x12, 0xef,
+  0xd1, 0xb8, 0x1e, 0x65, 0xf0, 0xa0, 0x35, 0xb2, 0x0f, 0x72, 0x50, 0xa4, 0xbb, 0x2a, 0x88, 0x0f,
+  0x25, 0x37, 0x34, 0xcd, 0xa4, 0x22, 0x54, 0xf9, 0x0a, 0x08, 0x6f, 0x35, 0x0e, 0x9d, 0x02, 0x17,
+  0xd5, 0xdc, 0x62, 0x24, 0x8c, 0x06, 0xc2, 0x4c, 0x1e, 0x7d, 0x5d, 0x02, 0x91, 0x07, 0x4b, 0xba,
+  0x6d, 0x8e, 0x5e, 0x18, 0xd9, 0x49, 0x15, 0x19, 0x3c, 0xa1, 0xd5, 0x30, 0x82, 0xf0, 0x79, 0x62,
+  0x74, 0x95, 0x3b, 0x8c, 0x96, 0x15, 0x27, 0xde, 0x24, 0x93, 0x51, 0xb6, 0x9b, 0xdc, 0x70, 0x29,
+  0xf0, 0xf0, 0xcb, 0xa4, 0xaa, 0x3d, 0x14, 0x44, 0x7a, 0xcc, 0x0f, 0x97, 0xf2, 0x95, 0xaa, 0xee,
+  0x12, 0x1a, 0x41, 0x15, 0x18, 0xfa, 0xe7, 0xc9, 0xb7, 0xe9, 0x3c, 0x8f, 0x30, 0xaf, 0x5c, 0x77,
+  0x97, 0x26, 0xcf, 0x95, 0x9f, 0x35, 0x6c, 0x17, 0xbb, 0x31, 0x76, 0xfd, 0xca, 0xd7, 0x36, 0x0d,
+  0x55, 0x39, 0x68, 0x9a, 0x56, 0xd4, 0x58, 0xf5, 0x7c, 0xdd, 0x40, 0xee, 0x8a, 0x0d, 0x9b, 0xe3,
+  0x99, 0x3b, 0x78, 0x85, 0xaa, 0xa5, 0xdd, 0xdc, 0x07, 0xb1, 0xa5, 0x5d, 0x36, 0x6c, 0x92, 0xd7,
+  0x49, 0xe6, 0x21, 0x37, 0x16, 0x56, 0x09, 0xb4, 0x01, 0xd3, 0x6a, 0x3f, 0x03, 0x21, 0x6c, 0x4d,
+  0x13, 0xdc, 0x0a, 0x39, 0x34, 0xc4, 0x5b, 0x4f, 0x7f, 0xb7, 0x36, 0x5d, 0x34, 0xe4, 0xb6, 0xb1,
+  0xc9, 0x16, 0xdd, 0x58, 0x34, 0x0c, 0x92, 0x7b, 0xa9, 0xdd, 0x34, 0x6a, 0x63, 0x8f, 0x49, 0x96,
+  0x7d, 0x8a, 0xac, 0x92, 0x1a, 0x18, 0xed, 0xde, 0x5e, 0xa9, 0x73, 0xa7, 0xc6, 0xd5, 0x60, 0x92,
+  0x3e, 0xb0, 0x17, 0xb1, 0xb0, 0x35, 0xbc, 0x05, 0xdb, 0x42, 0x59, 0xc4, 0xe6, 0xe0, 0x14, 0x04,
+  0xaf, 0x61, 0xe8, 0x70, 0x56, 0x71, 0xf1, 0xe2, 0x85, 0xda, 0xb3, 0x5f, 0x0a, 0xca, 0xe3, 0x82,
+  0x71, 0xe1, 0xf8, 0xbe, 0xbe, 0xd0, 0x13, 0x53, 0x50, 0x53, 0xed, 0x0d, 0x98, 0x2e, 0x46, 0x0f,
+  0x9d, 0x74, 0x9d, 0x30, 0x27, 0x8c, 0x82, 0xa4, 0xef, 0x83, 0x5a, 0x3a, 0x0a, 0xff, 0xf3, 0xa6,
+  0x45, 0x17, 0xd3, 0x26, 0xe8, 0x61, 0x26, 0xdd, 0x76, 0x33, 0xbb, 0x13, 0x57, 0xed, 0x3f, 0xe2,
+  0xe9, 0xf8, 0x3d, 0x53, 0x47, 0xe1, 0x7e, 0xcb, 0xd6, 0x37, 0xc9, 0xbe, 0x6b, 0xcd, 0xcd, 0xd5,
+  0x9a, 0x71, 0xfc, 0x49, 0x5f, 0x16, 0xa0, 0xbb, 0x6b, 0x06, 0x93, 0xf6, 0x8c, 0xed, 0x13, 0x84,
+  0x86, 0xe8, 0x64, 0xda, 0x29, 0x12, 0xef, 0x72, 0x17, 0xb1, 0x6f, 0x55, 0x77, 0x7b, 0x1d, 0x66,
+  0xcf, 0x52, 0xe2, 0x98, 0x19, 0x88, 0x3b, 0xcc, 0x7b, 0xea, 0xc6, 0x10, 0x5d, 0x30, 0x9f, 0x69,
+  0x96, 0x0e, 0x9c, 0xd1, 0xba, 0x57, 0x63, 0xd8, 0x19, 0xc8, 0xbb, 0xd4, 0x79, 0xb4, 0xcb, 0xd0,
+  0x04, 0x58, 0xb0, 0x4f, 0xc1, 0xb9, 0x9e, 0xb7, 0x88, 0x70, 0xbf, 0xdb, 0x92, 0xe8, 0xcd, 0x23,
+  0xfd, 0xce, 0xe5, 0x1c, 0x12, 0x0a, 0x87, 0x84, 0x66, 0x94, 0xf7, 0x13, 0x63, 0x9b, 0xcd, 0x7a,
+  0xbd, 0x5d, 0x02, 0x17, 0xc7, 0x8f, 0x76, 0xef, 0x03, 0xc9, 0x98, 0xf3, 0xb4, 0x37, 0x3c, 0xda,
+  0xab, 0xeb, 0x72, 0xee, 0xda, 0xab, 0x9f, 0xe3, 0xfe, 0x3f, 0xc4, 0x42, 0x24, 0x68, 0xf6, 0x06,
+  0x00, 0x00,
+};
+
+static const uint8_t kAsset_dashboard_js[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x92, 0xd1, 0x6e, 0xd3, 0x30,
+  0x14, 0x86, 0xef, 0xfb, 0x14, 0xa7, 0xd2, 0x24, 0x27, 0x1a, 0x18, 0xb8, 0x5d, 0x29, 0xa8, 0x6c,
+  0xe9, 0x54, 0x44, 0x53, 0xb4, 0x64, 0x48, 0x5c, 0x7a, 0xf1, 0x71, 0x1a, 0xa9, 0xb1, 0xa7, 0xd8,
+  0x2d, 0x9b, 0xa6, 0x5d, 0xee, 0x9a, 0x6b, 0x26, 0xa4, 0xdd, 0xee, 0x11, 0x78, 0x9e, 0xbd, 0x00,
+  0x3c, 0x02, 0xc7, 0x2e, 0x59, 0x3b, 0x1a, 0x69, 0x57, 0x71, 0x8e, 0xff, 0xef, 0xff, 0x7f, 0xd9,
+  0x2e, 0x8c, 0xb6, 0x0e, 0xf6, 0x60, 0x08, 0x15, 0x0c, 0xdf, 0x81, 0x34, 0xc5, 0xb2, 0x46, 0xed,
+  0x78, 0x89, 0x2e, 0x59, 0xa0, 0x5f, 0x7e, 0xb8, 0x9c, 0xc8, 0xa8, 0x8a, 0x07, 0xbd, 0x22, 0x48,
+  0xd1, 0x92, 0x56, 0xe3, 0x37, 0x48, 0x56, 0xb4, 0x99, 0x99, 0x65, 0x53, 0x60, 0xc4, 0x5e, 0xa1,
+  0xff, 0xb3, 0x8c, 0x64, 0x68, 0xb9, 0xd1, 0xe6, 0x1c, 0x35, 0xe9, 0xa2, 0xf8, 0x89, 0xe9, 0x99,
+  0x91, 0x97, 0xbc, 0x58, 0x08, 0x6b, 0x3f, 0x55, 0xd6, 0xf1, 0x06, 0x6b, 0xb3, 0x22, 0xd8, 0x28,
+  0xb5, 0xa8, 0x34, 0x3e, 0xc2, 0xd8, 0x34, 0xa6, 0x79, 0x96, 0x16, 0x52, 0xee, 0xa2, 0x35, 0x5a,
+  0x2b, 0x4a, 0x24, 0x18, 0x3d, 0x7b, 0xf5, 0xaf, 0xb4, 0xa4, 0xc1, 0xc7, 0x6c, 0x96, 0xf2, 0x73,
+  0xd1, 0x58, 0x8c, 0x90, 0x4b, 0xe1, 0x04, 0x31, 0x95, 0x82, 0x88, 0x39, 0x06, 0x95, 0x06, 0x19,
+  0xc3, 0x9e, 0x5f, 0xc7, 0xdc, 0xe1, 0x85, 0x3b, 0x34, 0xda, 0x51, 0x26, 0x61, 0x92, 0x3b, 0xee,
+  0xcc, 0xb8, 0xba, 0x40, 0x19, 0xbd, 0x69, 0x91, 0xf9, 0x16, 0x32, 0xef, 0x40, 0xe6, 0xbb, 0x48,
+  0xb9, 0x85, 0x94, 0x1d, 0x48, 0xd9, 0xea, 0xd4, 0xb6, 0x50, 0x75, 0x29, 0x55, 0x2b, 0xb5, 0xdb,
+  0x52, 0xbb, 0x23, 0x8d, 0x48, 0x6b, 0xe1, 0x2d, 0xbc, 0x86, 0xf7, 0xc0, 0x18, 0x1c, 0x00, 0xdb,
+  0x67, 0x31, 0xec, 0x7b, 0x0b, 0xbb, 0x5b, 0x50, 0x09, 0xdd, 0xda, 0x5d, 0xf5, 0xc8, 0x50, 0x15,
+  0x64, 0xb8, 0x39, 0x6e, 0x67, 0xca, 0x72, 0xe1, 0x2f, 0x4b, 0xb3, 0x17, 0xd0, 0xef, 0x4b, 0x4e,
+  0x7a, 0x42, 0xbd, 0x70, 0xd5, 0x51, 0x92, 0x76, 0x7d, 0xea, 0xc3, 0xed, 0x8f, 0xdf, 0xbf, 0xbe,
+  0xc3, 0xe7, 0xd3, 0x93, 0xe3, 0x49, 0x7a, 0x0c, 0xa3, 0xc9, 0x49, 0xe8, 0x31, 0x1b, 0x8f, 0xd9,
+  0xa0, 0x77, 0xbd, 0x0e, 0xae, 0x9f, 0xc4, 0xd6, 0xcf, 0xc4, 0xd6, 0xeb, 0xd0, 0xba, 0x2b, 0xb4,
+  0xf6, 0x91, 0x7f, 0xee, 0x6e, 0xef, 0x61, 0x3a, 0xfb, 0x92, 0x4c, 0x93, 0x34, 0x87, 0xa3, 0x24,
+  0x4f, 0x0e, 0xf3, 0xe4, 0xa8, 0x0f, 0x7e, 0x1e, 0xc2, 0x53, 0x03, 0x53, 0xe3, 0x2a, 0x72, 0x7c,
+  0xac, 0x20, 0x36, 0x15, 0xd6, 0x0f, 0xc6, 0x0a, 0x85, 0xc1, 0x52, 0xc0, 0x70, 0x08, 0x2c, 0x1b,
+  0x8d, 0x13, 0x16, 0x72, 0xad, 0x6b, 0xeb, 0xa5, 0xa2, 0xf6, 0x12, 0x9a, 0x08, 0xb7, 0xb4, 0x2f,
+  0xcf, 0x84, 0xa6, 0x87, 0x0b, 0x8c, 0xce, 0x37, 0x0a, 0x34, 0x55, 0xf1, 0xdf, 0x10, 0x29, 0x85,
+  0x2e, 0xb1, 0x61, 0xf1, 0xc6, 0xe2, 0xbf, 0x9b, 0x6a, 0x89, 0x87, 0x9f, 0x37, 0x01, 0x08, 0x65,
+  0xfd, 0x5d, 0x31, 0xc8, 0xbe, 0x66, 0x79, 0x32, 0x85, 0x2c, 0x1f, 0xe5, 0xa7, 0xd9, 0x41, 0x08,
+  0xa0, 0x5a, 0xbe, 0xfa, 0xf5, 0xe0, 0x2f, 0x73, 0x5c, 0xb8, 0x20, 0xbe, 0x03, 0x00, 0x00,
+};
+
+static const uint8_t kAsset_dashboard_html[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x94, 0x4d, 0x72, 0x9c, 0x30,
+  0x10, 0x85, 0xaf, 0xa2, 0x2c, 0x12, 0x6d, 0x42, 0x30, 0x99, 0xb2, 0x13, 0x67, 0x80, 0x94, 0xcb,
+  0x9e, 0x71, 0xb2, 0xf0, 0x4f, 0x19, 0xbc, 0xf0, 0x52, 0x83, 0x1a, 0x50, 0xac, 0x1f, 0x22, 0x35,
+  0xd8, 0x73, 0x87, 0xdc, 0x21, 0x37, 0xf1, 0x99, 0x72, 0x84, 0x88, 0x01, 0x67, 0x06, 0x4f, 0x2a,
+  0xd9, 0x50, 0x85, 0xe8, 0xfe, 0xde, 0xeb, 0x07, 0x4d, 0xfc, 0xea, 0xec, 0xea, 0x34, 0xbf, 0xbb,
+  0x5e, 0x90, 0x1a, 0x95, 0x4c, 0xe3, 0xf1, 0x0a, 0x8c, 0xa7, 0x31, 0x0a, 0x94, 0x90, 0x66, 0x8a,
+  0x59, 0x24, 0x99, 0x90, 0x86, 0x9c, 0x31, 0x57, 0xaf, 0x0c, 0xb3, 0x3c, 0x0e, 0x87, 0x67, 0xb1,
+  0x02, 0x64, 0xa4, 0xa8, 0x99, 0x75, 0x80, 0x09, 0xbd, 0xcd, 0x97, 0xc1, 0x47, 0x3a, 0x9e, 0x6a,
+  0xa6, 0x20, 0xa1, 0x9d, 0x80, 0x87, 0xc6, 0x58, 0xa4, 0xa4, 0x30, 0x1a, 0x41, 0xfb, 0xaa, 0x07,
+  0xc1, 0xb1, 0x4e, 0x38, 0x74, 0xa2, 0x80, 0x60, 0x73, 0xf3, 0x96, 0x08, 0x2d, 0x50, 0x30, 0x19,
+  0xb8, 0x82, 0x49, 0x48, 0x22, 0xcf, 0xd0, 0xc6, 0x15, 0x56, 0x34, 0x38, 0xd2, 0x6a, 0xc4, 0x26,
+  0x80, 0xef, 0xad, 0xe8, 0x12, 0x6a, 0xa1, 0xb4, 0xe0, 0xea, 0x1d, 0xe4, 0xc1, 0x9c, 0xb4, 0x56,
+  0x26, 0xa1, 0x14, 0x08, 0xbe, 0x37, 0xdc, 0x36, 0x4b, 0xa1, 0xef, 0x89, 0x05, 0x99, 0x50, 0x87,
+  0x6b, 0xe9, 0xbb, 0x00, 0xbc, 0x97, 0xda, 0x23, 0x12, 0x1a, 0xf2, 0xe7, 0x79, 0xde, 0x15, 0xce,
+  0x7d, 0xee, 0x92, 0xd5, 0xe1, 0x87, 0x59, 0x74, 0x7c, 0x74, 0xdc, 0x23, 0x86, 0x08, 0x56, 0x86,
+  0xaf, 0x7d, 0x1c, 0x51, 0xfa, 0xeb, 0xe7, 0x8f, 0x27, 0x32, 0x44, 0x71, 0x6e, 0x99, 0xd0, 0x9b,
+  0x40, 0x7c, 0x55, 0x94, 0xc6, 0x0d, 0x29, 0x24, 0x73, 0xce, 0x2b, 0xb4, 0xab, 0x4d, 0x2c, 0x34,
+  0xbd, 0x01, 0x3f, 0x4b, 0x2e, 0x14, 0x90, 0x93, 0xca, 0x8a, 0xa2, 0x95, 0xd8, 0x5a, 0x26, 0xc9,
+  0x85, 0xf1, 0x63, 0x1a, 0x2b, 0x74, 0x45, 0xb2, 0xb5, 0x43, 0x50, 0x71, 0xd8, 0xa4, 0x31, 0x17,
+  0x1d, 0x11, 0xbc, 0x37, 0x48, 0xff, 0x90, 0x90, 0x61, 0xeb, 0x82, 0x15, 0xd3, 0x1a, 0x2c, 0x71,
+  0xac, 0xf4, 0xcc, 0xec, 0x2e, 0xcb, 0x17, 0x17, 0x24, 0xcb, 0x4f, 0xf2, 0xdb, 0xec, 0x13, 0x09,
+  0x82, 0x38, 0xf4, 0x9d, 0x43, 0xfb, 0xd8, 0xe6, 0xb5, 0x38, 0x9d, 0x9c, 0x14, 0x7e, 0x38, 0x7f,
+  0x52, 0xcf, 0xd2, 0x1c, 0x54, 0x03, 0xd6, 0x63, 0x2d, 0x78, 0xdb, 0xb3, 0x49, 0x55, 0xc7, 0x64,
+  0xdb, 0xe7, 0xe6, 0x1a, 0xa6, 0x37, 0x56, 0x90, 0xa6, 0x3d, 0xbf, 0xbf, 0x4f, 0xc9, 0x1b, 0x0e,
+  0xd5, 0xfc, 0x74, 0x54, 0xdb, 0xd3, 0xdc, 0x2a, 0x7c, 0x69, 0x95, 0xe0, 0x02, 0xd7, 0xff, 0xc7,
+  0xd7, 0xbb, 0xf8, 0xd7, 0xff, 0x22, 0x93, 0x8a, 0xb9, 0x81, 0x7e, 0xce, 0x5c, 0x98, 0x29, 0x73,
+  0xbf, 0xe3, 0xbe, 0x47, 0x55, 0xf4, 0x85, 0xca, 0xdf, 0x72, 0xf1, 0x2f, 0x86, 0xa6, 0xa5, 0x90,
+  0x08, 0x16, 0x38, 0xd9, 0xfa, 0xa8, 0xca, 0xc9, 0x9c, 0xde, 0x3e, 0x37, 0x38, 0xdf, 0x2d, 0x70,
+  0x3b, 0x05, 0xa1, 0x12, 0x7a, 0xcf, 0x6b, 0x5f, 0x55, 0x16, 0x74, 0xe2, 0xb9, 0x64, 0x7a, 0xf0,
+  0xbc, 0x78, 0xac, 0x59, 0xeb, 0x90, 0x2c, 0x99, 0x9e, 0xba, 0x2e, 0xbb, 0x97, 0xb6, 0xaf, 0x96,
+  0xcb, 0x09, 0x7b, 0xaa, 0xa0, 0xb6, 0x0a, 0xca, 0xa0, 0x30, 0x3a, 0xd8, 0xc6, 0x7e, 0xfd, 0xf5,
+  0xc6, 0x7f, 0x58, 0xfd, 0x21, 0xc9, 0x40, 0x3b, 0x63, 0xa7, 0x52, 0x6a, 0x4f, 0xea, 0xd2, 0x8c,
+  0xf5, 0x13, 0xa9, 0x61, 0x61, 0x88, 0xb3, 0xc5, 0x64, 0x31, 0xbe, 0xf5, 0x7b, 0x11, 0x1d, 0x1d,
+  0x1c, 0xbe, 0x8f, 0x78, 0xbf, 0x96, 0xe1, 0xf3, 0x62, 0x85, 0xc3, 0x6a, 0x84, 0x9b, 0x1f, 0xc6,
+  0x6f, 0xf3, 0x61, 0x44, 0x95, 0x46, 0x04, 0x00, 0x00,
+};
+
+static const StaticAsset kStaticAssets[] = {
+  { "/dashboard.css", "text/css", kAsset_dashboard_css, sizeof(kAsset_dashboard_css), "\"b5731969\"", true },
+  { "/dashboard.js", "application/javascript", kAsset_dashboard_js, sizeof(kAsset_dashboard_js), "\"160521d1\"", true },
+  { "/", "text/html", kAsset_dashboard_html, sizeof(kAsset_dashboard_html), "\"fe16a797\"", false },
+};
+constexpr uint8_t kStaticAssetCount = sizeof(kStaticAssets) / sizeof(kStaticAssets[0]);
@@ -0,0 +1,138 @@
+#pragma once
+
+// ==========================================
+// DASHBOARD RENDERING (PORTABLE CORE)
+// ==========================================
+// Everything the firmware shows a browser, minus the sockets:
+//   - formatLive(): the JSON state and deltas pushed over /events and
+//     returned by /state,
+//   - renderLite(): the no-JavaScript page at /lite. The markup lives in
+//     flash (PROGMEM) and is streamed as chunks, with the live values
+//     formatted into one small stack buffer.
+// renderLite() writes to anything with sendContent()/sendContent_P():
+// ESP8266WebServer in the firmware, a capturing shim in the host build.
+
+#include <Arduino.h>
+#include "silo_logic.h"
+
+#define LIVE_GAS_DEADBAND 2          // Raw gas counts
+#define LIVE_SLOPE_DEADBAND 10       // Gas slope, tenths of a count/min
+
+// What the page shows, in display units (tenths where it prints one decimal)
+struct LiveView {
+  int16_t temp, hum;  // x10; INT16_MIN = no reading
+  int16_t gas, gasFiltered, slope;
+  bool fan, motion;
+  const char* status;
+};
+
+inline LiveView liveView(const SiloReadings& r, bool fan, const char* status) {
+  LiveView v;
+  v.temp = r.climateOk ? (int16_t)lroundf(r.temp * 10) : INT16_MIN;
+  v.hum = r.climateOk ? (int16_t)lroundf(r.hum * 10) : INT16_MIN;
+  v.gas = r.gas;
+  v.gasFiltered = r.gasFiltered;
+  v.slope = (int16_t)lroundf(r.gasSlope * 10);
+  v.fan = fan;
+  v.motion = r.motion;
+  v.status = status;
+  return v;
+}
+
+// JSON with the fields of v that differ from *shown (all of them when
+// shown is null). *shown is updated to match what was written.
+inline int formatLive(char* buf, size_t cap, const LiveView& v, LiveView* shown) {
+  int n = snprintf(buf, cap, "{");
+  auto sep = [&]() { return n > 1 ? "," : ""; };
+  // Stale climate values stay on the page; the status banner reports the fault
+  if (v.temp != INT16_MIN && (!shown || v.temp != shown->temp))
+    n += snprintf(buf + n, cap - n, "%s\"t\":%.1f", sep(), v.temp / 10.0f);
+  if (v.hum != INT16_MIN && (!shown || v.hum != shown->hum))
+    n += snprintf(buf + n, cap - n, "%s\"h\":%.1f", sep(), v.hum / 10.0f);
+  if (!shown || abs(v.gas - shown->gas) >= LIVE_GAS_DEADBAND)
+    n += snprintf(buf + n, cap - n, "%s\"g\":%d", sep(), v.gas);
+  if (!shown || v.gasFiltered != shown->gasFiltered)
+    n += snprintf(buf + n, cap - n, "%s\"gf\":%d", sep(), v.gasFiltered);
+  if (!shown || abs(v.slope - shown->slope) >= LIVE_SLOPE_DEADBAND)
+    n += snprintf(buf + n, cap - n, "%s\"gs\":%.1f", sep(), v.slope / 10.0f);
+  if (!shown || v.fan != shown->fan) n += snprintf(buf + n, cap - n, "%s\"fan\":%d", sep(), v.fan);
+  if (!shown || v.motion != shown->motion) n += snprintf(buf + n, cap - n, "%s\"m\":%d", sep(), v.motion);
+  if (!shown || v.status != shown->status)
+    n += snprintf(buf + n, cap - n, "%s\"a\":\"%s\"", sep(), v.status);
+  n += snprintf(buf + n, cap - n, "}");
+  if (shown) {
+    // Only what was sent counts as shown; values inside a deadband stay as they were
+    if (v.temp != INT16_MIN) shown->temp = v.temp;
+    if (v.hum != INT16_MIN) shown->hum = v.hum;
+    if (abs(v.gas - shown->gas) >= LIVE_GAS_DEADBAND) shown->gas = v.gas;
+    if (abs(v.slope - shown->slope) >= LIVE_SLOPE_DEADBAND) shown->slope = v.slope;
+    shown->gasFiltered = v.gasFiltered;
+    shown->fan = v.fan;
+    shown->motion = v.motion;
+    shown->status = v.status;
+  }
+  return n;
+}
+
+// The /lite page. It reloads every 2 s.
+static const char DASH_HEAD[] PROGMEM = R"rawliteral(<!DOCTYPE html><html><head><title>Smart Silo Dashboard</title><meta charset='UTF-8'><meta name='viewport' content='width=device-width, initial-scale=1'><meta http-equiv='refresh' content='2'><style>
+body { font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif; background-color: #e8f5e9; color: #1b5e20; margin: 0; padding: 20px; text-align: center; }
+h1 { margin-bottom: 5px; font-size: 2.2em; color: #2e7d32; }
+p.subtitle { color: #4caf50; font-size: 1.1em; margin-top: 0; margin-bottom: 30px; font-weight: bold; }
+.grid { display: flex; flex-wrap: wrap; justify-content: center; gap: 20px; max-width: 900px; margin: 0 auto; }
+.card { background: white; border-radius: 15px; padding: 25px; width: 200px; box-shadow: 0 6px 12px rgba(0,0,0,0.1); border-top: 6px solid #4caf50; transition: transform 0.2s; }
+.card:hover { transform: translateY(-5px); }
+.card h3 { margin: 0; font-size: 1.2em; color: #757575; text-transform: uppercase; letter-spacing: 1px; }
+.card .value { font-size: 2.5em; font-weight: bold; margin: 15px 0 0 0; color: #2e7d32; }
+.status-banner { margin: 10px auto 30px auto; padding: 20px; border-radius: 10px; max-width: 860px; font-size: 1.8em; font-weight: bold; box-shadow: 0 4px 8px rgba(0,0,0,0.2); }
+.safe { background-color: #4caf50; color: white; }
+.danger { background-color: #d32f2f; color: white; animation: blink 1s linear infinite; }
+@keyframes blink { 50% { opacity: 0.8; } }
+.motion-card { background: white; border-radius: 15px; padding: 20px; width: 80%; max-width: 640px; margin: 30px auto; box-shadow: 0 6px 12px rgba(0,0,0,0.15); border-top: 6px solid #2196f3; }
+.motion-card h3 { margin: 0; font-size: 1.4em; color: #555; text-transform: uppercase; letter-spacing: 1px; }
+</style></head><body><h1>🌾 Smart Grain Silo</h1><p class='subtitle'>Real-Time Agricultural Monitoring System</p>)rawliteral";
+
+// Main Status Banner: css class, icon, status text
+static const char DASH_BANNER_FMT[] PROGMEM =
+  "<div id='st' class='status-banner %s'>%s SYSTEM STATUS: %s</div>";
+
+// Sensor cards: temperature, humidity, gas
+static const char DASH_CARDS_FMT[] PROGMEM =
+  "<div class='grid'>"
+  "<div class='card'><h3>Temperature</h3><div class='value'><span id='t'>%.1f</span> &deg;C</div></div>"
+  "<div class='card'><h3>Humidity</h3><div class='value'><span id='h'>%.1f</span> %%</div></div>"
+  "<div class='card' style='border-top-color: #ff9800;'><h3>Gas/Smoke</h3><div id='g' class='value' style='color:#f57c00;'>%d</div>"
+  "<div style='color:#757575; margin-top:8px;'>filtered <span id='gf'>%d</span> &middot; <span id='gs'>%+.1f</span>/min</div></div>";
+
+// Exhaust Fan UI Card (closes the grid)
+static const char DASH_FAN_ON[] PROGMEM =
+  "<div id='fc' class='card' style='border-top-color: #9c27b0;'><h3>Exhaust Fan</h3><div id='fv' class='value' style='color:#9c27b0; font-size: 1.8em; margin-top:25px;'>⚙️ PURGING AIR</div></div></div>";
+static const char DASH_FAN_OFF[] PROGMEM =
+  "<div id='fc' class='card' style='border-top-color: #9e9e9e;'><h3>Exhaust Fan</h3><div id='fv' class='value' style='color:#757575; font-size: 1.8em; margin-top:25px;'>OFF</div></div></div>";
+
+// Motion Card (then DASH_TAIL closes the page)
+static const char DASH_MOTION_ON[] PROGMEM =
+  "<div id='mc' class='motion-card' style='border-top-color: #f44336;'><h3>PIR Motion Sensor</h3><div id='mv' class='value' style='color:#d32f2f; font-size: 2.2em; font-weight:bold; margin-top:15px;'>🚨 MOVEMENT DETECTED! 🚨</div></div>";
+static const char DASH_MOTION_OFF[] PROGMEM =
+  "<div id='mc' class='motion-card'><h3>PIR Motion Sensor</h3><div id='mv' class='value' style='color:#1976d2; font-size: 2.2em; font-weight:bold; margin-top:15px;'>No Motion</div></div>";
+
+static const char DASH_TAIL[] PROGMEM = "</body></html>";
+
+template <typename Out>
+void renderLite(Out& out, const SiloReadings& r, bool fan, const char* status) {
+  char buf[512]; // Large enough for the biggest formatted fragment
+
+  out.sendContent_P(DASH_HEAD);
+
+  bool safe = strcmp(status, "SAFE") == 0;
+  snprintf_P(buf, sizeof(buf), DASH_BANNER_FMT,
+             safe ? "safe" : "danger", safe ? "✅" : "🚨", status);
+  out.sendContent(buf);
+
+  snprintf_P(buf, sizeof(buf), DASH_CARDS_FMT, r.temp, r.hum, r.gas, r.gasFiltered, r.gasSlope);
+  out.sendContent(buf);
+
+  out.sendContent_P(fan ? DASH_FAN_ON : DASH_FAN_OFF);
+  out.sendContent_P(r.motion ? DASH_MOTION_ON : DASH_MOTION_OFF);
+  out.sendContent_P(DASH_TAIL);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// ==========================================
+// RATE-LIMITED DHT SAMPLING ENGINE
+// ==========================================
+// The DHT driver bit-bangs the sensor with interrupts disabled, and
+// readTemperature() / readHumidity() can each trigger a full read. Here one
+// forced dht.read() per interval fetches both values; the two accessors then
+// return the driver's cached result without touching the bus. The engine
+// stays at the sensor's maximum rate (1 Hz for DHT11, 0.5 Hz for DHT22).
+//
+// Consecutive failures and the age of the last good reading are tracked, so
+// the fan and alarm logic can tell a dead sensor from a quiet silo.
+
+#include <Arduino.h>
+#include <DHT.h>
+
+#define DHT_STALE_FAILURES 3         // Consecutive NaN reads before "stale"
+#define DHT_STALE_MS 10000           // ...or no good read for this long
+
+class DhtSampler {
+ public:
+  DhtSampler(DHT& dht, uint8_t type)
+    : dht_(dht), intervalMs_(type == DHT11 ? 1000 : 2000) {}
+
+  uint32_t intervalMs() const { return intervalMs_; }
+
+  // Read the sensor if the interval has passed. Returns true on a new
+  // good reading.
+  bool poll() {
+    uint32_t now = millis();
+    if (attempts && now - lastAttemptMs_ < intervalMs_) return false;
+    lastAttemptMs_ = now;
+    attempts++;
+
+    uint32_t start = micros();
+    bool ok = dht_.read(true);
+    float t = dht_.readTemperature(); // Cached by read() above
+    float h = dht_.readHumidity();
+    lastReadUs = micros() - start;
+
+    if (!ok || isnan(t) || isnan(h)) {
+      failures++;
+      if (consecutiveFailures < 255) consecutiveFailures++;
+      return false;
+    }
+    temp_ = t;
+    hum_ = h;
+    lastGoodMs_ = now;
+    hasReading_ = true;
+    consecutiveFailures = 0;
+    return true;
+  }
+
+  // A reading carried across a reset (boot_state.h). It counts as just
+  // read, so it goes stale after DHT_STALE_MS if the sensor stays silent.
+  void restore(float t, float h) {
+    temp_ = t;
+    hum_ = h;
+    lastGoodMs_ = millis();
+    hasReading_ = true;
+  }
+
+  float temperature() const { return temp_; }
+  float humidity() const { return hum_; }
+  uint32_t ageMs() const { return hasReading_ ? millis() - lastGoodMs_ : UINT32_MAX; }
+
+  // True when the cached values can no longer be trusted
+  bool stale() const {
+    return !hasReading_ || consecutiveFailures >= DHT_STALE_FAILURES || ageMs() > DHT_STALE_MS;
+  }
+
+  uint32_t attempts = 0;
+  uint32_t failures = 0;
+  uint8_t consecutiveFailures = 0;
+  uint32_t lastReadUs = 0;   // Time spent inside the driver
+
+ private:
+  DHT& dht_;
+  uint32_t intervalMs_;
+  uint32_t lastAttemptMs_ = 0;
+  uint32_t lastGoodMs_ = 0;
+  bool hasReading_ = false;
+  float temp_ = NAN;
+  float hum_ = NAN;
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+// ==========================================
+// ESP-NOW SILO LINK (NODE SIDE)
+// ==========================================
+// On sites with many silos only one board, the gateway, talks to the cloud.
+// All the others run as nodes: they keep their local sensing, fan and
+// alarms, but instead of joining the access point they send each sample as
+// a 16-byte SiloFrame over ESP-NOW (no association, no IP, no TLS). Alerts
+// are sent the moment taskAlarm raises them, without waiting for the next
+// sample. See silo_gateway.h for the receiving end.
+//
+// Every frame carries a per-node sequence number, so the gateway can count
+// lost and duplicated frames. Frames go unicast to the gateway's MAC and
+// are acknowledged by the radio; a frame that still fails after
+// ESPNOW_RETRIES attempts moves the node to the next channel, because
+// ESP-NOW only works on the channel the gateway's access point uses. The
+// channel that worked is kept in RTC memory across resets. With an all-zero
+// gateway MAC, frames are broadcast instead: nothing to configure, but
+// nothing is acknowledged and the channel must be set by ESPNOW_CHANNEL.
+
+#include "platform.h"
+#if !SILO_DUAL_CORE
+#include <espnow.h>
+#include <user_interface.h>
+#endif
+#include "rtc_store.h"
+#include "sample_history.h"
+#include "silo_payload.h"
+
+#define SILO_STANDALONE 0            // Talks to ThingSpeak and Telegram itself
+#define SILO_NODE 1                  // Sends its samples to a gateway
+#define SILO_GATEWAY 2               // Standalone, plus uploads for its nodes
+
+#ifndef SILO_ROLE
+#define SILO_ROLE SILO_STANDALONE
+#endif
+
+#define ESPNOW_CHANNEL 1             // First channel to try (the AP's channel)
+#define ESPNOW_RETRIES 3             // Attempts per channel before hopping
+#define ESPNOW_QUEUE_LEN 8           // Frames waiting to be sent
+#define ESPNOW_SEND_TIMEOUT_MS 50    // No send callback by then = failed
+
+// SiloFrame, SILO_FLAG_* and SiloAlert are in silo_payload.h / silo_logic.h
+
+#define RTC_SLOT_ESPNOW 116          // EspNowCache, 2 blocks
+
+struct EspNowCache {
+  uint8_t channel;
+  uint8_t reserved[3];
+};
+
+// ESP-NOW here is the ESP8266 SDK's; the ESP32 build is standalone only
+#if !SILO_DUAL_CORE
+class SiloNodeLink {
+ public:
+  void begin(uint8_t nodeId, const uint8_t gatewayMac[6]) {
+    node_ = nodeId;
+    instance_ = this;
+    static const uint8_t none[6] = {};
+    broadcast_ = memcmp(gatewayMac, none, sizeof(none)) == 0;
+    if (broadcast_) memset(peer_, 0xFF, sizeof(peer_));
+    else memcpy(peer_, gatewayMac, sizeof(peer_));
+
+    EspNowCache cache;
+    channel_ = rtcLoad(RTC_SLOT_ESPNOW, cache) && cache.channel >= 1 && cache.channel <= 13
+                 ? cache.channel : ESPNOW_CHANNEL;
+
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.disconnect(); // Stay off the AP: nodes never associate
+    wifi_set_channel(channel_);
+    ready_ = esp_now_init() == 0;
+    if (!ready_) {
+      Serial.println("ESP-NOW init failed");
+      return;
+    }
+    esp_now_set_self_role(ESP_NOW_ROLE_CONTROLLER);
+    esp_now_register_send_cb(onSent);
+    esp_now_add_peer(peer_, ESP_NOW_ROLE_SLAVE, channel_, nullptr, 0);
+    Serial.printf("ESP-NOW node %u on channel %u\n", (unsigned)node_, (unsigned)channel_);
+  }
+
+  // Queue a frame; node, seq and header are filled in here. The oldest
+  // waiting frame is dropped when the queue is full.
+  void send(SiloFrame f) {
+    if (!ready_) return;
+    f.magic = SILO_FRAME_MAGIC;
+    f.version = SILO_FRAME_VERSION;
+    f.node = node_;
+    f.seq = seq_++;
+    if (!sentAny_) f.flags |= SILO_FLAG_BOOT;
+    sentAny_ = true;
+    if (count_ == ESPNOW_QUEUE_LEN) {
+      // Drop the oldest frame that isn't on the air
+      uint8_t first = inFlight_ ? 1 : 0;
+      for (uint8_t i = first; i + 1 < count_; i++)
+        queue_[(head_ + i) % ESPNOW_QUEUE_LEN] = queue_[(head_ + i + 1) % ESPNOW_QUEUE_LEN];
+      if (first == 0) attempts_ = 0;
+      count_--;
+      dropped++;
+    }
+    queue_[(head_ + count_) % ESPNOW_QUEUE_LEN] = f;
+    count_++;
+  }
+
+  // One step: check the frame on the air, or put the next one there
+  void poll() {
+    if (!ready_) return;
+    if (inFlight_) {
+      uint8_t status = status_;
+      if (status == STATUS_PENDING && millis() - sentAtMs_ < ESPNOW_SEND_TIMEOUT_MS) return;
+      inFlight_ = false;
+      if (status == STATUS_OK) {
+        delivered++;
+        attempts_ = 0;
+        popHead();
+        saveChannel();
+      } else {
+        failures++;
+        attempts_++;
+        if (attempts_ % ESPNOW_RETRIES == 0) hop();
+        // Tried every channel: give this frame up
+        if (attempts_ >= ESPNOW_RETRIES * 13) {
+          attempts_ = 0;
+          popHead();
+          dropped++;
+        }
+      }
+    }
+    if (count_ == 0) return;
+    status_ = STATUS_PENDING;
+    sentAtMs_ = millis();
+    inFlight_ = true;
+    esp_now_send(peer_, (uint8_t*)&queue_[head_], sizeof(SiloFrame));
+  }
+
+  uint8_t channel() const { return channel_; }
+  uint16_t nextSeq() const { return seq_; }
+
+  // Stats
+  uint32_t delivered = 0;   // Frames acknowledged (broadcast: just sent)
+  uint32_t failures = 0;    // Attempts without an acknowledgement
+  uint32_t dropped = 0;     // Frames given up (queue full or no gateway found)
+  uint32_t hops = 0;        // Channel changes
+
+ private:
+  enum { STATUS_PENDING, STATUS_OK, STATUS_FAILED };
+
+  // SDK callback, runs outside loop(); only hands the result over
+  static void onSent(uint8_t* mac, uint8_t status) {
+    instance_->status_ = status == 0 ? STATUS_OK : STATUS_FAILED;
+  }
+
+  void popHead() {
+    head_ = (head_ + 1) % ESPNOW_QUEUE_LEN;
+    count_--;
+  }
+
+  void hop() {
+    if (broadcast_) return; // No acknowledgements to tell a wrong channel
+    channel_ = channel_ % 13 + 1;
+    wifi_set_channel(channel_);
+    esp_now_set_peer_channel(peer_, channel_);
+    hops++;
+  }
+
+  void saveChannel() {
+    if (channel_ == savedChannel_) return;
+    EspNowCache cache = { channel_, {} };
+    rtcSave(RTC_SLOT_ESPNOW, cache);
+    savedChannel_ = channel_;
+  }
+
+  static inline SiloNodeLink* instance_ = nullptr;
+
+  bool ready_ = false;
+  bool broadcast_ = false;
+  uint8_t node_ = 0;
+  uint8_t peer_[6];
+  uint8_t channel_ = ESPNOW_CHANNEL;
+  uint8_t savedChannel_ = 0;
+  uint16_t seq_ = 0;
+  bool sentAny_ = false;
+
+  SiloFrame queue_[ESPNOW_QUEUE_LEN];
+  uint8_t head_ = 0;
+  uint8_t count_ = 0;
+  bool inFlight_ = false;
+  volatile uint8_t status_ = STATUS_PENDING;
+  uint32_t sentAtMs_ = 0;
+  uint8_t attempts_ = 0;
+};
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+// ==========================================
+// EXHAUST FAN CONTROLLER
+// ==========================================
+// Evaluates the policy table from fan_policy.h (exported from the RL agent
+// in ml/fan_optimization.py):
+//   - per temperature/gas bin, separate ON and OFF humidity thresholds,
+//     so the relay doesn't chatter around a single value,
+//   - minimum ON and OFF times for humidity-driven runs,
+//   - a cap on the fan's ON share over the last hour.
+// A gas alarm always runs the fan at once, ignoring the rest time and the
+// duty cap; it still gets the minimum run time after the alarm clears.
+//
+// A remote override (MQTT "fan=on" / "fan=off") replaces the table, the
+// minimum times and the duty cap until it expires. Even a forced-off fan
+// starts on a gas alarm.
+//
+// setPreempt() starts the fan ahead of the table while the on-device
+// forecast (mold_forecaster.h) sees humidity heading for the mold range.
+// The minimum times and the duty cap still apply to such runs.
+//
+// Duty is tracked in FAN_DUTY_BUCKETS time buckets covering the last
+// FAN_DUTY_WINDOW_MS, so every update is O(1).
+
+#include <Arduino.h>
+#include "fan_policy.h"
+
+#define FAN_DUTY_WINDOW_MS 3600000UL // Duty cap window (1 hour)
+#define FAN_DUTY_BUCKETS 12          // ...in 5-minute buckets
+
+class FanController {
+ public:
+  enum Override : uint8_t { AUTO, FORCE_ON, FORCE_OFF };
+
+  // Hold the fan on or off for durationMs, or return to the table (AUTO)
+  void setOverride(Override mode, uint32_t now, uint32_t durationMs) {
+    override_ = mode;
+    overrideUntilMs_ = now + durationMs;
+  }
+
+  Override override(uint32_t now) {
+    if (override_ != AUTO && (int32_t)(now - overrideUntilMs_) >= 0) override_ = AUTO;
+    return override_;
+  }
+
+  // Run the fan while humidity is forecast to reach the mold range
+  void setPreempt(bool on) { preempt_ = on; }
+  bool preempt() const { return preempt_; }
+
+  // Returns the wanted fan state. climateValid = false means hum/temp are
+  // stale and only the gas alarm can start the fan.
+  bool update(uint32_t now, float temp, float hum, bool climateValid,
+              uint16_t gas, bool gasAlarm) {
+    account(now);
+
+    bool want = running_;
+    bool early = false;   // Only the forecast wants it on
+    if (gasAlarm) {
+      want = true;
+    } else if (!climateValid) {
+      want = false;
+    } else {
+      uint8_t ti = tempBin(temp);
+      uint8_t gi = gasBin(gas);
+      if (running_) want = hum > kFanOffHum[ti][gi];
+      else want = hum > kFanOnHum[ti][gi];
+      if (preempt_ && !want) want = early = true;
+    }
+
+    Override forced = override(now);
+    if (forced != AUTO && !gasAlarm) {
+      want = forced == FORCE_ON;
+    } else if (want != running_ && !gasAlarm) {
+      uint32_t held = now - lastSwitchMs_;
+      if ((switches || restored_) && held < (running_ ? kFanMinOnMs : kFanMinOffMs)) want = running_;
+    }
+    // Over the duty cap: humidity can wait, gas can't
+    if (kFanMaxDutyPct < 100 && want && !gasAlarm && forced == AUTO && dutyPct() >= kFanMaxDutyPct) {
+      if (!running_ || now - lastSwitchMs_ >= kFanMinOnMs) {
+        want = false;
+        if (running_) capped++;
+      }
+    }
+
+    if (want != running_) {
+      running_ = want;
+      lastSwitchMs_ = now;
+      switches++;
+      if (want && early) preempted++;
+    }
+    return running_;
+  }
+
+  bool running() const { return running_; }
+
+  // For the boot snapshot (boot_state.h)
+  uint32_t heldMs(uint32_t now) const { return now - lastSwitchMs_; }
+  uint32_t overrideLeftMs(uint32_t now) { return override(now) != AUTO ? overrideUntilMs_ - now : 0; }
+
+  // Carry on from before a reset: the relay state, how long it has been
+  // held (the minimum run and rest times still count) and a remote
+  // override. The duty window starts over.
+  void restore(bool running, uint32_t heldMs, Override mode, uint32_t overrideLeftMs, uint32_t now) {
+    running_ = running;
+    lastSwitchMs_ = now - heldMs;
+    restored_ = true;
+    if (mode != AUTO) setOverride(mode, now, overrideLeftMs);
+  }
+
+  // Would the table start a resting fan at these readings? Deep-sleep wakes
+  // use this to decide whether the full firmware has to come up.
+  static bool wouldStart(float temp, float hum, uint16_t gas) {
+    return hum > kFanOnHum[tempBin(temp)][gasBin(gas)];
+  }
+
+  // ON share of the last hour, in percent
+  uint8_t dutyPct() const {
+    uint32_t on = 0;
+    for (uint8_t i = 0; i < FAN_DUTY_BUCKETS; i++) on += bucketMs_[i];
+    return (uint8_t)(on / (FAN_DUTY_WINDOW_MS / 100));
+  }
+
+  uint32_t onSeconds() const { return (uint32_t)(onMs_ / 1000); }  // Since boot
+
+  uint32_t switches = 0;  // Relay state changes
+  uint32_t capped = 0;    // Runs cut short by the duty cap
+  uint32_t preempted = 0; // Runs started early by the forecast
+
+ private:
+  static constexpr uint32_t kBucketMs = FAN_DUTY_WINDOW_MS / FAN_DUTY_BUCKETS;
+
+  static uint8_t tempBin(float temp) {
+    uint8_t ti = 0;
+    while (ti < kFanTempBins - 1 && temp >= kFanTempEdges[ti]) ti++;
+    return ti;
+  }
+
+  static uint8_t gasBin(uint16_t gas) {
+    uint8_t gi = 0;
+    while (gi < kFanGasBins - 1 && gas >= kFanGasEdges[gi]) gi++;
+    return gi;
+  }
+
+  // Add the time since the last update to the ON counters
+  void account(uint32_t now) {
+    if (!started_) {
+      started_ = true;
+      lastMs_ = now;
+      bucketStartMs_ = now;
+      return;
+    }
+    while (now - bucketStartMs_ >= kBucketMs) {
+      uint32_t part = bucketStartMs_ + kBucketMs - lastMs_;
+      if (running_) {
+        bucketMs_[bucket_] += part;
+        onMs_ += part;
+      }
+      lastMs_ = bucketStartMs_ += kBucketMs;
+      bucket_ = (bucket_ + 1) % FAN_DUTY_BUCKETS;
+      bucketMs_[bucket_] = 0;
+    }
+    if (running_) {
+      bucketMs_[bucket_] += now - lastMs_;
+      onMs_ += now - lastMs_;
+    }
+    lastMs_ = now;
+  }
+
+  bool running_ = false;
+  bool preempt_ = false;
+  Override override_ = AUTO;
+  uint32_t overrideUntilMs_ = 0;
+  bool started_ = false;
+  bool restored_ = false;  // lastSwitchMs_ came from before a reset
+  uint32_t lastSwitchMs_ = 0;
+  uint32_t lastMs_ = 0;
+  uint64_t onMs_ = 0;
+  uint32_t bucketStartMs_ = 0;
+  uint32_t bucketMs_[FAN_DUTY_BUCKETS] = {};
+  uint8_t bucket_ = 0;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+// ==========================================
+// FAN POLICY TABLE (GENERATED)
+// ==========================================
+// Default policy: the original 50% humidity threshold with a small
+// hysteresis band and 1-minute minimum run/rest times, no duty cap.
+// Run `python export_fan_policy.py` in ml/ after training the PPO agent
+// to replace it with the learned policy.
+// Bins are chosen by temperature and filtered gas; kFanTempEdges /
+// kFanGasEdges are the upper (exclusive) edges of every bin but the last.
+// Humidity thresholds are whole percent: the fan starts above kFanOnHum
+// and stops at or below kFanOffHum. 101 means "never on" in that bin.
+
+#include <Arduino.h>
+
+constexpr uint8_t kFanTempBins = 4;
+constexpr uint8_t kFanGasBins = 2;
+constexpr float kFanTempEdges[kFanTempBins - 1] = { 22.5f, 27.5f, 32.5f };
+constexpr uint16_t kFanGasEdges[kFanGasBins - 1] = { 65 };
+
+constexpr uint8_t kFanOnHum[kFanTempBins][kFanGasBins] = {
+  { 50, 50 },  // temp < 22.5
+  { 50, 50 },  // temp < 27.5
+  { 50, 50 },  // temp < 32.5
+  { 50, 50 },  // temp >= 32.5
+};
+constexpr uint8_t kFanOffHum[kFanTempBins][kFanGasBins] = {
+  { 47, 47 },
+  { 47, 47 },
+  { 47, 47 },
+  { 47, 47 },
+};
+
+constexpr uint32_t kFanMinOnMs = 60000;   // Shortest humidity-driven run
+constexpr uint32_t kFanMinOffMs = 60000;  // Shortest rest between runs
+constexpr uint8_t kFanMaxDutyPct = 100;   // Max ON share of the last hour
@@ -0,0 +1,27 @@
+#pragma once
+
+// ==========================================
+// HUMIDITY FORECAST MODEL (GENERATED)
+// ==========================================
+// Placeholder: no model has been exported yet, so the on-device mold-risk
+// forecast is disabled. Run `python export_forecaster.py` in ml/ to fit
+// ARIMA(5,1,2) on your silo's humidity and overwrite this file.
+// The model runs on 20-minute mean humidity in centi-percent. Each step
+// predicts the next change from the last kForecastP changes and the last
+// kForecastQ one-step errors, with coefficients in fixed point
+// (value = coef / 2^kForecastShift).
+
+#include <Arduino.h>
+
+constexpr bool kForecastTrained = false;
+constexpr uint8_t kForecastP = 5;                 // AR order (on differences)
+constexpr uint8_t kForecastQ = 2;                 // MA order
+constexpr uint8_t kForecastShift = 14;            // Coefficient fixed point
+constexpr uint32_t kForecastStepMs = 1200000;     // 20 min, as forecasting.py resamples
+constexpr uint8_t kForecastHorizon = 18;          // Steps ahead (6 h)
+constexpr int32_t kForecastRiskHum = 6500;        // MOLD_GROWTH_HUM_MIN, centi-%
+constexpr float kForecastTempMin = 20.0f;         // MOLD_GROWTH_TEMP_MIN/MAX
+constexpr float kForecastTempMax = 40.0f;
+
+constexpr int16_t kForecastAr[kForecastP] = { 0, 0, 0, 0, 0 };
+constexpr int16_t kForecastMa[kForecastQ] = { 0, 0 };
@@ -0,0 +1,141 @@
+#pragma once
+
+// ==========================================
+// MQ-2 GAS ACQUISITION PIPELINE
+// ==========================================
+// Every sample() call:
+//   1. reads A0 GAS_BURST times back-to-back and takes the median,
+//      which throws away single-sample ADC spikes,
+//   2. feeds the median into a fixed-point EMA (Q4, alpha = 1/8),
+//   3. once a second, updates a slow baseline (drift/warm-up estimate)
+//      and the slope over the last GAS_SLOPE_WINDOW_S seconds,
+//   4. runs the alarm through enter/exit hysteresis, so the fan and the
+//      buzzer no longer flip on noise around a single threshold.
+//
+// update() runs steps 2-4 on a reading from elsewhere, at a given time;
+// the trace replay (trace_replay.h) feeds recorded values through it.
+//
+// A freshly powered MQ-2 reads high while its heater warms up. For the first
+// GAS_WARMUP_MS only a reading well above the normal threshold raises the
+// alarm, so a real fire still does.
+
+#include <Arduino.h>
+
+#define GAS_BURST 7                  // ADC reads per sample (odd, for the median)
+#define GAS_EMA_SHIFT 3              // alpha = 1/8
+#define GAS_ALARM_ENTER 90           // Filtered value that raises the alarm
+#define GAS_ALARM_EXIT 80            // ...and the value it must fall below to clear
+#define GAS_WARMUP_MS 120000         // MQ-2 heater settling time after boot
+#define GAS_WARMUP_ENTER 200         // Alarm threshold while warming up
+#define GAS_BASELINE_SHIFT 8         // Baseline time constant ~256 s
+#define GAS_SLOPE_WINDOW_S 10        // Slope is measured over this many seconds
+
+class GasChannel {
+ public:
+  explicit GasChannel(uint8_t pin) : pin_(pin) {}
+
+  void setThresholds(uint16_t enter, uint16_t exit) {
+    enter_ = enter;
+    exit_ = exit < enter ? exit : enter;
+  }
+
+  void sample() {
+    uint16_t burst[GAS_BURST];
+    for (uint8_t i = 0; i < GAS_BURST; i++) {
+      uint16_t v = analogRead(pin_);
+      // Insertion sort as we go; GAS_BURST is tiny
+      uint8_t j = i;
+      while (j > 0 && burst[j - 1] > v) {
+        burst[j] = burst[j - 1];
+        j--;
+      }
+      burst[j] = v;
+    }
+    update(burst[GAS_BURST / 2], millis());
+  }
+
+  void update(uint16_t raw, uint32_t now) {
+    raw_ = raw;
+    nowMs_ = now;
+    if (!primed_) {
+      ema_ = (int32_t)raw_ << 4;
+      baseline_ = ema_;
+      for (uint8_t i = 0; i < GAS_SLOPE_WINDOW_S; i++) slopeRing_[i] = ema_;
+      lastSecondMs_ = now;
+      bootMs_ = now;
+      primed_ = true;
+    } else {
+      ema_ += (((int32_t)raw_ << 4) - ema_) >> GAS_EMA_SHIFT;
+    }
+
+    // Once-a-second bookkeeping: slope window and baseline
+    while (now - lastSecondMs_ >= 1000) {
+      lastSecondMs_ += 1000;
+      slopeIdx_ = (slopeIdx_ + 1) % GAS_SLOPE_WINDOW_S;
+      oldestEma_ = slopeRing_[slopeIdx_];
+      slopeRing_[slopeIdx_] = ema_;
+      // The baseline only learns clean air: it follows drops freely but
+      // stops tracking while the alarm is active
+      if (!alarm_ || ema_ < baseline_) {
+        baseline_ += (ema_ - baseline_) >> GAS_BASELINE_SHIFT;
+        if (ema_ < baseline_ && warmingUp()) baseline_ = ema_;
+      }
+    }
+
+    uint16_t enter = warmingUp() ? GAS_WARMUP_ENTER : enter_;
+    uint16_t value = filtered();
+    if (!alarm_ && value > enter) alarm_ = true;
+    else if (alarm_ && value < exit_) alarm_ = false;
+  }
+
+  uint16_t raw() const { return raw_; }                       // Burst median
+  uint16_t filtered() const { return (ema_ + 8) >> 4; }       // EMA, rounded
+  uint16_t baseline() const { return (baseline_ + 8) >> 4; }  // Clean-air estimate
+  int16_t drift() const { return filtered() - baseline(); }
+  bool alarm() const { return alarm_; }
+  uint16_t alarmEnter() const { return enter_; }
+  uint16_t alarmExit() const { return exit_; }
+  bool warmingUp() const { return nowMs_ - bootMs_ < GAS_WARMUP_MS; }  // As of the last sample
+
+  // Filter state, for carrying it across deep sleep (power_manager.h).
+  // The MQ-2 heater stays powered while the ESP8266 sleeps, so a warm
+  // sensor skips the warm-up again.
+  int32_t emaQ4() const { return ema_; }
+  int32_t baselineQ4() const { return baseline_; }
+
+  void restore(int32_t emaQ4, int32_t baselineQ4, bool alarm, bool warm) {
+    uint32_t now = millis();
+    nowMs_ = now;
+    ema_ = emaQ4;
+    baseline_ = baselineQ4;
+    for (uint8_t i = 0; i < GAS_SLOPE_WINDOW_S; i++) slopeRing_[i] = ema_;
+    oldestEma_ = ema_;
+    alarm_ = alarm;
+    lastSecondMs_ = now;
+    bootMs_ = warm ? now - GAS_WARMUP_MS : now;
+    primed_ = true;
+  }
+
+  // Change of the filtered value, in ADC counts per minute
+  float slopePerMin() const {
+    return (ema_ - oldestEma_) / 16.0f * (60.0f / GAS_SLOPE_WINDOW_S);
+  }
+
+ private:
+  uint8_t pin_;
+  uint16_t enter_ = GAS_ALARM_ENTER;
+  uint16_t exit_ = GAS_ALARM_EXIT;
+
+  bool primed_ = false;
+  uint16_t raw_ = 0;
+  int32_t ema_ = 0;        // Q4
+  int32_t baseline_ = 0;   // Q4
+  bool alarm_ = false;
+  uint32_t bootMs_ = 0;
+  uint32_t nowMs_ = 0;     // Time of the last sample
+
+  uint32_t lastSecondMs_ = 0;
+  int32_t slopeRing_[GAS_SLOPE_WINDOW_S];  // One EMA snapshot per second
+  uint8_t slopeIdx_ = 0;
+  int32_t oldestEma_ = 0;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+// ==========================================
+// NON-BLOCKING HTTP/1.1 RESPONSE READER
+// ==========================================
+// Shared by the Telegram notifier and the ThingSpeak uploader. poll() only
+// consumes bytes the client has already buffered, so it never waits on the
+// network. The body is read to keep a keep-alive connection in sync for
+// the next request; it is discarded unless begin() is given a buffer, which
+// keeps its first bytes (NUL-terminated, the rest is dropped). The body
+// ends after Content-Length bytes, after the last chunk of a chunked body
+// (the chunk framing is not kept), or when the server closes. After
+// beginHeaders(), poll() stops at the end of the headers and leaves the
+// body in the client for the caller to stream (OTA images).
+
+#include <Arduino.h>
+#include <Client.h>
+
+class HttpResponseReader {
+ public:
+  enum Result { PENDING, DONE, FAILED };
+
+  void begin(uint32_t timeoutMs, char* body = nullptr, size_t bodyCap = 0) {
+    body_ = body;
+    bodyCap_ = body ? bodyCap : 0;
+    bodyLen_ = 0;
+    if (body_ && bodyCap_) body_[0] = '\0';
+    state_ = STATUS;
+    lineLen_ = 0;
+    code_ = 0;
+    contentLength_ = -1;
+    chunked_ = false;
+    chunkLeft_ = 0;
+    keepAlive_ = true;
+    headersOnly_ = false;
+    deadline_ = millis() + timeoutMs;
+  }
+
+  void beginHeaders(uint32_t timeoutMs) {
+    begin(timeoutMs);
+    headersOnly_ = true;
+  }
+
+  Result poll(Client& client) {
+    while (client.available()) {
+      if (state_ == COMPLETE) break;
+      if (state_ == BODY) {
+        if (headersOnly_ || contentLength_ == 0) break;
+        // No length (-1): read until the server closes
+        int got = readBody(client, contentLength_ < 0 ? INT32_MAX : contentLength_);
+        if (got <= 0) break;
+        if (contentLength_ > 0) contentLength_ -= got;
+        continue;
+      }
+      if (state_ == CHUNK_DATA) {
+        int got = readBody(client, chunkLeft_);
+        if (got <= 0) break;
+        chunkLeft_ -= got;
+        if (chunkLeft_ == 0) state_ = CHUNK_END;
+        continue;
+      }
+
+      char c = client.read();
+      if (c == '\r') continue;
+      if (c != '\n') {
+        if (lineLen_ < sizeof(line_) - 1) line_[lineLen_++] = c;
+        continue;
+      }
+      line_[lineLen_] = '\0';
+      lineLen_ = 0;
+
+      if (state_ == STATUS) {
+        // "HTTP/1.1 200 OK"
+        const char* sp = strchr(line_, ' ');
+        code_ = sp ? atoi(sp + 1) : 0;
+        state_ = HEADERS;
+      } else if (state_ == CHUNK_SIZE) {
+        // "1a2;ext" in hex; 0 is the last chunk, trailers follow
+        chunkLeft_ = strtol(line_, nullptr, 16);
+        state_ = chunkLeft_ > 0 ? CHUNK_DATA : TRAILERS;
+      } else if (state_ == CHUNK_END) {
+        state_ = CHUNK_SIZE;              // The CRLF after a chunk's data
+      } else if (state_ == TRAILERS) {
+        if (line_[0] == '\0') state_ = COMPLETE;
+      } else if (line_[0] == '\0') {
+        // Chunked framing overrides any Content-Length (RFC 9112)
+        state_ = chunked_ && !headersOnly_ ? CHUNK_SIZE : BODY;
+      } else if (strncasecmp(line_, "Content-Length:", 15) == 0) {
+        contentLength_ = atol(line_ + 15);
+      } else if (strncasecmp(line_, "Transfer-Encoding:", 18) == 0 && strstr(line_, "chunked")) {
+        chunked_ = true;
+      } else if (strncasecmp(line_, "Connection:", 11) == 0 && strstr(line_, "close")) {
+        keepAlive_ = false;
+      }
+    }
+
+    if (state_ == COMPLETE) return DONE;
+    if (state_ == BODY) {
+      if (headersOnly_ || contentLength_ == 0) return DONE;
+      // Without a length the body runs until the server closes the socket
+      if (contentLength_ < 0 && !client.connected()) {
+        keepAlive_ = false;
+        return DONE;
+      }
+    } else if (!client.connected() && !client.available()) {
+      return FAILED;
+    }
+
+    if ((int32_t)(millis() - deadline_) >= 0) return FAILED;
+    return PENDING;
+  }
+
+  int code() const { return code_; }
+  bool keepAlive() const { return keepAlive_; }
+  int32_t contentLength() const { return contentLength_; }  // -1 = not sent; counts down as the body is read
+  size_t bodyLength() const { return bodyLen_; }  // Bytes kept
+
+ private:
+  enum State { STATUS, HEADERS, BODY, CHUNK_SIZE, CHUNK_DATA, CHUNK_END, TRAILERS, COMPLETE };
+
+  // Up to left body bytes: into the caller's buffer while it has room,
+  // otherwise read and dropped. Returns the bytes read.
+  int readBody(Client& client, int32_t left) {
+    uint8_t sink[64];
+    uint8_t* dst = sink;
+    int32_t room = sizeof(sink);
+    if (bodyLen_ + 1 < bodyCap_) {
+      dst = (uint8_t*)body_ + bodyLen_;
+      room = bodyCap_ - 1 - bodyLen_;
+    }
+    int want = left < room ? left : room;
+    int got = client.read(dst, want);
+    if (got > 0 && dst != sink) {
+      bodyLen_ += got;
+      body_[bodyLen_] = '\0';
+    }
+    return got;
+  }
+
+  State state_ = STATUS;
+  char line_[64];
+  size_t lineLen_ = 0;
+  int code_ = 0;
+  int32_t contentLength_ = -1;
+  bool chunked_ = false;
+  int32_t chunkLeft_ = 0;              // Data bytes left in the current chunk
+  bool keepAlive_ = true;
+  bool headersOnly_ = false;
+  uint32_t deadline_ = 0;
+  char* body_ = nullptr;
+  size_t bodyCap_ = 0;
+  size_t bodyLen_ = 0;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+// ==========================================
+// LIVE DASHBOARD PUSH (SERVER-SENT EVENTS)
+// ==========================================
+// The dashboard is served once. It then opens an EventSource on /events,
+// and the firmware pushes an event only when something on the page
+// changed. An event carries only the fields that changed, as a small JSON
+// object. With no viewers attached none of this runs, and each viewer
+// costs one lwIP write per change however often it looks.
+//
+// The handler takes over the web server's client: it writes the SSE
+// headers itself and keeps a reference. The server then drops its own
+// reference without closing the socket, the same trick as the core's
+// ServerSentEvents example. ESP8266WebServer itself stays single-request.
+//
+// Writes never block. A viewer whose send buffer is full skips the change
+// and is marked out of sync. Once it has room again, it gets the latest
+// full state instead of the deltas it missed. Each viewer holds a TCP
+// connection, and lwIP's default budget is 5, shared with Telegram,
+// ThingSpeak, MQTT and the page requests. So only LIVE_MAX_VIEWERS are
+// kept, and a new viewer replaces the oldest one.
+
+#include "platform.h"
+
+#define LIVE_MAX_VIEWERS 3
+#define LIVE_EVENT_MAX 200           // Longest JSON state (full snapshot)
+#define LIVE_PING_MS 15000           // Comment line to keep proxies and NAT awake
+#define LIVE_RETRY_MS 2000           // Browser reconnect delay after a drop
+
+class LiveEvents {
+ public:
+  // Take over the current request's client and send it the full state.
+  // Returns false when the client is already gone.
+  bool attach(WiFiClient client, const char* full) {
+    if (!client.connected()) return false;
+    Viewer* v = nullptr;
+    for (uint8_t i = 0; i < LIVE_MAX_VIEWERS; i++) {
+      if (!viewers_[i].used) {
+        v = &viewers_[i];
+        break;
+      }
+      if (!v || (int32_t)(viewers_[i].sinceMs - v->sinceMs) < 0) v = &viewers_[i];
+    }
+    if (v->used) {
+      v->client.stop();
+      replaced++;
+    }
+    v->client = client;
+    v->client.setNoDelay(true);
+    v->used = true;
+    v->inSync = false;
+    v->sinceMs = v->lastWriteMs = millis();
+    char head[160];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                     "Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n"
+                     "retry: %u\n\n", (unsigned)LIVE_RETRY_MS);
+    v->client.write((const uint8_t*)head, n);
+    setFull(full);
+    v->inSync = writeEvent(*v, full_);
+    return true;
+  }
+
+  // A change: the delta goes to viewers in sync, the full state to the rest
+  void broadcast(const char* delta, const char* full) {
+    setFull(full);
+    for (uint8_t i = 0; i < LIVE_MAX_VIEWERS; i++) {
+      Viewer& v = viewers_[i];
+      if (!v.used) continue;
+      if (!v.inSync) resync(v);
+      else if (!writeEvent(v, delta)) v.inSync = false;
+    }
+    events++;
+  }
+
+  // Drop closed viewers, catch up lagging ones, keep idle ones alive
+  void poll() {
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < LIVE_MAX_VIEWERS; i++) {
+      Viewer& v = viewers_[i];
+      if (!v.used) continue;
+      if (!v.client.connected()) {
+        v.client.stop();
+        v.used = false;
+        continue;
+      }
+      while (v.client.available()) v.client.read(); // Browsers send nothing; discard if they do
+      if (!v.inSync) resync(v);
+      else if (now - v.lastWriteMs >= LIVE_PING_MS && platformWriteRoom(v.client) >= 3) {
+        v.client.write((const uint8_t*)":\n\n", 3);
+        v.lastWriteMs = now;
+      }
+    }
+  }
+
+  uint8_t viewers() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < LIVE_MAX_VIEWERS; i++) n += viewers_[i].used;
+    return n;
+  }
+
+  // Stats
+  uint32_t events = 0;    // Changes pushed
+  uint32_t resyncs = 0;   // Full states sent to lagging viewers
+  uint32_t replaced = 0;  // Viewers dropped to make room
+
+ private:
+  struct Viewer {
+    WiFiClient client;
+    bool used = false;
+    bool inSync = false;   // Has every change since its last full state
+    uint32_t sinceMs = 0;
+    uint32_t lastWriteMs = 0;
+  };
+
+  void setFull(const char* full) {
+    strncpy(full_, full, sizeof(full_) - 1);
+    full_[sizeof(full_) - 1] = '\0';
+  }
+
+  void resync(Viewer& v) {
+    if (writeEvent(v, full_)) {
+      v.inSync = true;
+      resyncs++;
+    }
+  }
+
+  // "data: <json>\n\n" in one write, or nothing if it wouldn't fit
+  bool writeEvent(Viewer& v, const char* json) {
+    char buf[LIVE_EVENT_MAX + 10];
+    int n = snprintf(buf, sizeof(buf), "data: %s\n\n", json);
+    if (n <= 0 || n >= (int)sizeof(buf)) return false;
+    if (platformWriteRoom(v.client) < n) return false;
+    if (v.client.write((const uint8_t*)buf, n) != (size_t)n) return false;
+    v.lastWriteMs = millis();
+    return true;
+  }
+
+  Viewer viewers_[LIVE_MAX_VIEWERS];
+  char full_[LIVE_EVENT_MAX] = "{}";
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+// ==========================================
+// ON-DEVICE MOLD-RISK FORECAST (PORTABLE CORE)
+// ==========================================
+// Runs the ARIMA(5,1,2) humidity model exported by ml/export_forecaster.py
+// (forecast_model.h) in integer arithmetic. Samples are averaged into
+// 20-minute steps as they arrive. Each closed step updates the model state
+// (the last kForecastP differences and kForecastQ one-step errors) and
+// re-forecasts kForecastHorizon steps ahead. Memory is constant and no
+// history is re-read. If humidity is forecast to reach MOLD_GROWTH_HUM_MIN
+// within the horizon while the temperature is in the mold range, riskAhead()
+// is set: the alarm table warns and the fan starts early.
+//
+// The state is built from live samples, so a forecast needs kForecastP + 1
+// steps (2 h) after boot, and a gap longer than one step starts over. In
+// POWER_DEEP_SLEEP the RAM doesn't survive a wake, so the forecast never
+// gets ready there.
+
+#include <Arduino.h>
+#include "forecast_model.h"
+
+#define FORECAST_BUDGET_US 2000      // Allowed time per update (one step, full horizon)
+#define FORECAST_DIFF_MAX 2000       // Largest step change believed, centi-% (20 %)
+
+static_assert(kForecastShift > 0 && kForecastShift < 16, "forecast coefficients need a fixed-point shift");
+
+class MoldForecaster {
+ public:
+  static constexpr bool enabled() { return kForecastTrained; }
+
+  // One sample (NaN = missing). Returns true when a step closed and the
+  // forecast was updated.
+  bool add(uint32_t now, float hum) {
+    if (!enabled()) return false;
+    if (!started_) {
+      started_ = true;
+      stepStartMs_ = now;
+    }
+    bool updated = false;
+    if (now - stepStartMs_ >= kForecastStepMs) {
+      // This sample belongs to the next step
+      stepStartMs_ += kForecastStepMs;
+      if (now - stepStartMs_ >= kForecastStepMs || !count_) {
+        // Steps went by without data: the differences no longer line up
+        reset();
+        stepStartMs_ = now;
+      } else {
+        uint32_t started = micros();
+        observe(sum_ / (int32_t)count_);
+        lastUs = micros() - started;
+        if (lastUs > maxUs) maxUs = lastUs;
+        if (lastUs > FORECAST_BUDGET_US) overBudget++;
+        updates++;
+        updated = true;
+      }
+      sum_ = 0;
+      count_ = 0;
+    }
+    if (!isnan(hum)) {
+      sum_ += lroundf(hum * 100);
+      count_++;
+    }
+    return updated;
+  }
+
+  bool ready() const { return diffs_ == kForecastP; }
+
+  // Mold conditions forecast within the horizon at this temperature
+  bool riskAhead(float temp) const {
+    return ready() && stepsToRisk_ > 0 && temp >= kForecastTempMin && temp <= kForecastTempMax;
+  }
+
+  float peakHum() const { return peak_ / 100.0f; }       // Highest forecast value
+  float hoursToRisk() const { return stepsToRisk_ * (kForecastStepMs / 3600000.0f); }  // 0 = none
+
+  // Stats
+  uint32_t updates = 0;
+  uint32_t lastUs = 0;     // Time of the last update
+  uint32_t maxUs = 0;
+  uint32_t overBudget = 0; // Updates over FORECAST_BUDGET_US
+
+ private:
+  void reset() {
+    diffs_ = 0;
+    have_ = false;
+    stepsToRisk_ = 0;
+    predNext_ = 0;
+    for (int32_t& x : diff_) x = 0;
+    for (int32_t& x : err_) x = 0;
+  }
+
+  void observe(int32_t level) {
+    if (!have_) {
+      last_ = level;
+      peak_ = level;
+      have_ = true;
+      return;
+    }
+    int32_t d = level - last_;
+    if (d > FORECAST_DIFF_MAX) d = FORECAST_DIFF_MAX;
+    if (d < -FORECAST_DIFF_MAX) d = -FORECAST_DIFF_MAX;
+    last_ = level;
+    // One-step error, once the model has made a prediction
+    int32_t e = ready() ? d - predNext_ : 0;
+    push(diff_, kForecastP, d);
+    push(err_, kForecastQ, e);
+    if (diffs_ < kForecastP) diffs_++;
+    if (ready()) forecast();
+  }
+
+  void forecast() {
+    int32_t d[kForecastP];
+    int32_t e[kForecastQ];
+    memcpy(d, diff_, sizeof(d));
+    memcpy(e, err_, sizeof(e));
+    int32_t level = last_;
+    peak_ = level;
+    stepsToRisk_ = 0;
+    for (uint8_t h = 1; h <= kForecastHorizon; h++) {
+      int64_t acc = (int64_t)1 << (kForecastShift - 1);  // Round to nearest
+      for (uint8_t i = 0; i < kForecastP; i++) acc += (int64_t)kForecastAr[i] * d[i];
+      for (uint8_t j = 0; j < kForecastQ; j++) acc += (int64_t)kForecastMa[j] * e[j];
+      int32_t next = (int32_t)(acc >> kForecastShift);
+      if (h == 1) predNext_ = next;
+      // Future errors are 0 in expectation
+      push(d, kForecastP, next);
+      push(e, kForecastQ, 0);
+      level += next;
+      if (level > peak_) peak_ = level;
+      if (!stepsToRisk_ && level >= kForecastRiskHum) stepsToRisk_ = h;
+    }
+  }
+
+  static void push(int32_t* v, uint8_t n, int32_t x) {
+    for (uint8_t i = n - 1; i > 0; i--) v[i] = v[i - 1];
+    v[0] = x;
+  }
+
+  int32_t diff_[kForecastP] = {};  // Newest first
+  int32_t err_[kForecastQ] = {};
+  int32_t last_ = 0;               // Last step mean, centi-%
+  int32_t peak_ = 0;
+  int32_t predNext_ = 0;           // Forecast of the next difference
+  uint8_t diffs_ = 0;
+  uint8_t stepsToRisk_ = 0;
+  bool have_ = false;
+  bool started_ = false;
+
+  int32_t sum_ = 0;
+  uint16_t count_ = 0;
+  uint32_t stepStartMs_ = 0;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+// ==========================================
+// INTERRUPT-DRIVEN PIR CAPTURE
+// ==========================================
+// The PIR pin interrupt timestamps every edge into a lock-free
+// single-producer/single-consumer queue: the ISR only writes head_, the main
+// loop only writes tail_. The ESP8266 has one core and 32-bit stores are
+// atomic, so volatile indices are all the synchronisation needed. poll()
+// drains the queue from the main loop and turns raw edges into debounced
+// motion events, so a short trigger is never missed, even while the loop
+// is busy. On the ESP32 the interrupt is attached from setup() and polled
+// by the control task, both on core 1, so the same holds there.
+
+#include <Arduino.h>
+
+#define MOTION_QUEUE_LEN 32          // Edge slots (power of two)
+#define MOTION_DEBOUNCE_MS 50        // Rising edges closer than this are one event
+#define MOTION_HOLD_MS 2000          // "Motion" stays active this long after an event
+
+class MotionSensor {
+ public:
+  void begin(uint8_t pin) {
+    pin_ = pin;
+    instance_ = this;
+    level_ = digitalRead(pin);
+    attachInterrupt(digitalPinToInterrupt(pin), onEdge, CHANGE);
+  }
+
+  // Drain captured edges (main loop only).
+  void poll() {
+    while (tail_ != head_) {
+      const volatile Edge& e = queue_[tail_ & (MOTION_QUEUE_LEN - 1)];
+      uint32_t ms = e.ms;
+      bool high = e.high;
+      tail_ = tail_ + 1;
+
+      if (high && (!events || ms - lastEventMs_ >= MOTION_DEBOUNCE_MS)) {
+        lastEventMs_ = ms;
+        events++;
+        if (windowEvents_ < 255) windowEvents_++;
+      }
+      level_ = high;
+    }
+  }
+
+  // Debounced motion state: the PIR output is high, or an event happened
+  // within the hold time.
+  bool active() const {
+    return level_ || (events && millis() - lastEventMs_ < MOTION_HOLD_MS);
+  }
+
+  // Events since the previous call (one upload/history window).
+  uint8_t takeWindowCount() {
+    uint8_t n = windowEvents_;
+    windowEvents_ = 0;
+    return n;
+  }
+
+  uint32_t lastEventMs() const { return lastEventMs_; }
+
+  uint32_t events = 0;           // Total debounced motion events
+  volatile uint32_t overflows = 0; // Edges lost because the queue was full
+
+ private:
+  struct Edge {
+    uint32_t ms;
+    bool high;
+  };
+
+  // The slot is filled before head_ moves, so the reader never sees a
+  // half-written edge.
+  static void IRAM_ATTR onEdge() {
+    MotionSensor* self = instance_;
+    uint32_t head = self->head_;
+    if (head - self->tail_ >= MOTION_QUEUE_LEN) {
+      self->overflows = self->overflows + 1;
+      return;
+    }
+    volatile Edge& e = self->queue_[head & (MOTION_QUEUE_LEN - 1)];
+    e.ms = millis();
+    e.high = digitalRead(self->pin_);
+    self->head_ = head + 1;
+  }
+
+  static inline MotionSensor* instance_ = nullptr;
+
+  uint8_t pin_ = 0;
+  volatile Edge queue_[MOTION_QUEUE_LEN];
+  volatile uint32_t head_ = 0;   // Written by the ISR
+  volatile uint32_t tail_ = 0;   // Written by the main loop
+
+  bool level_ = false;
+  uint32_t lastEventMs_ = 0;
+  uint8_t windowEvents_ = 0;
+};
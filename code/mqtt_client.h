@@ -0,0 +1,446 @@
+#pragma once
+
+// ==========================================
+// MINIMAL NON-BLOCKING MQTT 3.1.1 CLIENT
+// ==========================================
+// Just the parts of MQTT that a silo needs: CONNECT with a last will,
+// PUBLISH at QoS 0 and 1, SUBSCRIBE, keep-alive pings, and the matching
+// acknowledgements. One connection stays open, so a sample costs one small
+// PUBLISH packet and no HTTP request line or headers.
+//
+// Like the Telegram and ThingSpeak clients, poll() does one step per pass
+// and only reads bytes that have already arrived. The TCP connect itself
+// still blocks, bounded by MQTT_TIMEOUT_MS.
+//
+// QoS 1 messages are copied into a small outbox and kept until the broker
+// sends PUBACK. They are resent with the DUP flag after MQTT_RETRY_MS and
+// after every reconnect. QoS 0 messages are only sent while connected;
+// otherwise they are dropped, because the next sample replaces them anyway.
+//
+// The session is clean, and subscriptions are renewed on every connect.
+// Incoming packets longer than MQTT_RX_MAX are read and discarded.
+
+#include "platform.h"
+
+#define MQTT_KEEPALIVE_S 60          // Ping the broker when idle this long / 2
+#define MQTT_TIMEOUT_MS 5000         // TCP connect, CONNACK and PINGRESP
+#define MQTT_RETRY_MS 10000          // Resend a QoS 1 message without PUBACK
+#define MQTT_BACKOFF_MIN_MS 2000
+#define MQTT_BACKOFF_MAX_MS 120000
+#define MQTT_OUTBOX_LEN 4            // QoS 1 messages awaiting PUBACK
+#define MQTT_TOPIC_MAX 48
+#define MQTT_PAYLOAD_MAX 32          // Largest QoS 1 payload (a SiloFrame is 16)
+#define MQTT_PACKET_MAX 192          // Largest packet we send (CONNECT, usually)
+#define MQTT_RX_MAX 160              // Largest packet we receive
+#define MQTT_MAX_SUBS 2
+
+class MqttClient {
+ public:
+  typedef void (*Handler)(const char* topic, const uint8_t* payload, uint16_t len);
+
+  // Strings must stay valid (string literals or globals)
+  void begin(const char* host, uint16_t port, const char* clientId,
+             const char* user, const char* password) {
+    host_ = host;
+    port_ = port;
+    clientId_ = clientId;
+    user_ = user;
+    password_ = password;
+    state_ = CONNECT;
+  }
+
+  // Retained status topic: the broker publishes `offline` there if we
+  // vanish, and we publish `online` after every connect
+  void setWill(const char* topic, const char* offline, const char* online) {
+    willTopic_ = topic;
+    willMessage_ = offline;
+    birthMessage_ = online;
+  }
+
+  void onMessage(Handler handler) { handler_ = handler; }
+
+  // QoS 1 subscription, renewed after every connect
+  void subscribe(const char* topic) {
+    if (subCount_ < MQTT_MAX_SUBS) subs_[subCount_++] = topic;
+  }
+
+  // QoS 0: sent now or not at all. QoS 1: queued until acknowledged (the
+  // oldest waiting message is dropped when the outbox is full).
+  bool publish(const char* topic, const uint8_t* payload, uint16_t len,
+               uint8_t qos, bool retain = false) {
+    if (qos == 0) {
+      if (state_ != CONNECTED) {
+        dropped++;
+        return false;
+      }
+      bool ok = writePublish(topic, payload, len, 0, retain, 0, false);
+      if (ok) published++;
+      return ok;
+    }
+    if (strlen(topic) >= MQTT_TOPIC_MAX || len > MQTT_PAYLOAD_MAX) return false;
+    Outbox* slot = nullptr;
+    for (uint8_t i = 0; i < MQTT_OUTBOX_LEN; i++) {
+      if (!outbox_[i].id) {
+        slot = &outbox_[i];
+        break;
+      }
+      if (!slot || (int32_t)(outbox_[i].queuedMs - slot->queuedMs) < 0) slot = &outbox_[i];
+    }
+    if (slot->id) dropped++;
+    strcpy(slot->topic, topic);
+    memcpy(slot->payload, payload, len);
+    slot->len = len;
+    slot->retain = retain;
+    slot->id = nextId();
+    slot->queuedMs = millis();
+    slot->sentMs = 0;
+    slot->sent = false;
+    if (state_ == CONNECTED) sendOutbox(slot);
+    return true;
+  }
+
+  void poll() {
+    uint32_t now = millis();
+
+    switch (state_) {
+      case OFF:
+        return;
+
+      case BACKOFF:
+        if ((int32_t)(now - retryAt_) < 0) return;
+        state_ = CONNECT;
+        // fall through
+      case CONNECT:
+        if (WiFi.status() != WL_CONNECTED) return;
+        client_.setTimeout(MQTT_TIMEOUT_MS);
+        if (!client_.connect(host_, port_)) {
+          fail("connect");
+          return;
+        }
+        client_.setNoDelay(true);
+        rxState_ = RX_HEADER;
+        pingPending_ = false;
+        if (!writeConnect()) {
+          fail("CONNECT too long");
+          return;
+        }
+        waitMs_ = now;
+        state_ = WAIT_CONNACK;
+        return;
+
+      case WAIT_CONNACK:
+      case CONNECTED:
+        if (!client_.connected()) {
+          fail("connection lost");
+          return;
+        }
+        readPackets();
+        if (state_ == WAIT_CONNACK && now - waitMs_ >= MQTT_TIMEOUT_MS) {
+          fail("no CONNACK");
+          return;
+        }
+        if (state_ != CONNECTED) return;
+        if (pingPending_ && now - pingMs_ >= MQTT_TIMEOUT_MS) {
+          fail("no PINGRESP");
+          return;
+        }
+        for (uint8_t i = 0; i < MQTT_OUTBOX_LEN; i++) {
+          Outbox& m = outbox_[i];
+          if (m.id && (!m.sent || now - m.sentMs >= MQTT_RETRY_MS)) sendOutbox(&m);
+        }
+        if (!pingPending_ && now - lastTxMs_ >= MQTT_KEEPALIVE_S * 500UL) {
+          const uint8_t ping[2] = { 0xC0, 0x00 };
+          if (client_.write(ping, 2) == 2) {
+            lastTxMs_ = now;
+            pingMs_ = now;
+            pingPending_ = true;
+          }
+        }
+        return;
+    }
+  }
+
+  bool connected() const { return state_ == CONNECTED; }
+
+  // QoS 1 messages not yet acknowledged
+  uint8_t pending() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < MQTT_OUTBOX_LEN; i++) n += outbox_[i].id != 0;
+    return n;
+  }
+  bool busy() const { return pending() > 0; }
+
+  const char* stateName() const {
+    switch (state_) {
+      case CONNECT: return "connecting";
+      case WAIT_CONNACK: return "handshake";
+      case CONNECTED: return "connected";
+      case BACKOFF: return "backoff";
+      default: return "off";
+    }
+  }
+
+  // Stats
+  uint32_t connects = 0;    // Sessions accepted by the broker
+  uint32_t failures = 0;    // Connects refused or timed out, links lost
+  uint32_t published = 0;   // QoS 0 sent + QoS 1 acknowledged
+  uint32_t retransmits = 0; // QoS 1 resends
+  uint32_t dropped = 0;     // Not sent: offline (QoS 0) or outbox full (QoS 1)
+  uint32_t received = 0;    // PUBLISH packets delivered to the handler
+  uint32_t bytesSent = 0;
+
+ private:
+  enum State { OFF, CONNECT, WAIT_CONNACK, CONNECTED, BACKOFF };
+  enum RxState { RX_HEADER, RX_LENGTH, RX_BODY };
+
+  struct Outbox {
+    char topic[MQTT_TOPIC_MAX];
+    uint8_t payload[MQTT_PAYLOAD_MAX];
+    uint8_t len;
+    bool retain;
+    bool sent;        // Sent in this session
+    uint16_t id;      // Packet identifier; 0 = free slot
+    uint32_t queuedMs;
+    uint32_t sentMs;
+  };
+
+  // Packets are assembled in one buffer and written with a single write(),
+  // so each one leaves in a single TCP segment. The first 5 bytes are kept
+  // free for the fixed header, which is only known once the body is done.
+  struct Packet {
+    uint8_t buf[MQTT_PACKET_MAX];
+    size_t len = 5;
+    bool ok = true;
+    void bytes(const void* p, size_t n) {
+      if (len + n > sizeof(buf)) {
+        ok = false;
+        return;
+      }
+      memcpy(buf + len, p, n);
+      len += n;
+    }
+    void u8(uint8_t v) { bytes(&v, 1); }
+    void u16(uint16_t v) { u8(v >> 8); u8(v); }
+    void str(const char* s) {
+      size_t n = strlen(s);
+      u16(n);
+      bytes(s, n);
+    }
+  };
+
+  bool send(Packet& p, uint8_t header) {
+    if (!p.ok) return false;
+    uint8_t varint[4];
+    uint8_t k = 0;
+    size_t remaining = p.len - 5;
+    do {
+      varint[k] = remaining % 128;
+      remaining /= 128;
+      if (remaining) varint[k] |= 0x80;
+      k++;
+    } while (remaining);
+    size_t start = 4 - k;
+    p.buf[start] = header;
+    memcpy(p.buf + start + 1, varint, k);
+    size_t total = p.len - start;
+    if (client_.write(p.buf + start, total) != total) return false;
+    lastTxMs_ = millis();
+    bytesSent += total;
+    return true;
+  }
+
+  bool writeConnect() {
+    Packet p;
+    p.str("MQTT");
+    p.u8(4); // Protocol level 3.1.1
+    uint8_t flags = 0x02; // Clean session
+    if (willTopic_) flags |= 0x04 | 0x08 | 0x20; // Will, QoS 1, retained
+    if (user_ && *user_) flags |= 0x80;
+    if (password_ && *password_) flags |= 0x40;
+    p.u8(flags);
+    p.u16(MQTT_KEEPALIVE_S);
+    p.str(clientId_);
+    if (willTopic_) {
+      p.str(willTopic_);
+      p.str(willMessage_);
+    }
+    if (flags & 0x80) p.str(user_);
+    if (flags & 0x40) p.str(password_);
+    return send(p, 0x10);
+  }
+
+  bool writePublish(const char* topic, const uint8_t* payload, uint16_t len,
+                    uint8_t qos, bool retain, uint16_t id, bool dup) {
+    Packet p;
+    p.str(topic);
+    if (qos) p.u16(id);
+    p.bytes(payload, len);
+    return send(p, 0x30 | (dup ? 0x08 : 0) | (qos << 1) | (retain ? 0x01 : 0));
+  }
+
+  void sendOutbox(Outbox* m) {
+    bool resend = m->sentMs != 0;
+    if (!writePublish(m->topic, m->payload, m->len, 1, m->retain, m->id, resend)) return;
+    if (resend) retransmits++;
+    m->sent = true;
+    m->sentMs = millis();
+  }
+
+  void writeSubscriptions() {
+    for (uint8_t i = 0; i < subCount_; i++) {
+      Packet p;
+      p.u16(nextId());
+      p.str(subs_[i]);
+      p.u8(1); // Max QoS 1
+      send(p, 0x82);
+    }
+  }
+
+  uint16_t nextId() {
+    if (++lastId_ == 0) lastId_ = 1;
+    return lastId_;
+  }
+
+  // Read whatever has arrived, one byte of framing at a time
+  void readPackets() {
+    while (client_.available() && (state_ == WAIT_CONNACK || state_ == CONNECTED)) {
+      switch (rxState_) {
+        case RX_HEADER:
+          rxHeader_ = client_.read();
+          rxRemaining_ = 0;
+          rxShift_ = 0;
+          rxState_ = RX_LENGTH;
+          break;
+
+        case RX_LENGTH: {
+          uint8_t b = client_.read();
+          rxRemaining_ |= (uint32_t)(b & 0x7F) << rxShift_;
+          rxShift_ += 7;
+          if (b & 0x80) {
+            if (rxShift_ > 21) fail("bad length");
+            break;
+          }
+          rxLen_ = 0;
+          rxState_ = RX_BODY;
+          if (rxRemaining_ == 0) dispatch();
+          break;
+        }
+
+        case RX_BODY: {
+          uint8_t sink[32];
+          uint8_t* dst = rxLen_ < MQTT_RX_MAX ? rxBuf_ + rxLen_ : sink;
+          size_t room = rxLen_ < MQTT_RX_MAX ? MQTT_RX_MAX - rxLen_ : sizeof(sink);
+          size_t want = rxRemaining_ < room ? rxRemaining_ : room;
+          int got = client_.read(dst, want);
+          if (got <= 0) return;
+          rxRemaining_ -= got;
+          rxLen_ += got;
+          if (rxRemaining_ == 0) dispatch();
+          break;
+        }
+      }
+    }
+  }
+
+  void dispatch() {
+    rxState_ = RX_HEADER;
+    if (rxLen_ > MQTT_RX_MAX) return; // Too long for us: skipped
+    const uint8_t* b = rxBuf_;
+    switch (rxHeader_ >> 4) {
+      case 2: // CONNACK
+        if (rxLen_ < 2 || b[1] != 0) {
+          Serial.printf("MQTT: connection refused (%u)\n", rxLen_ < 2 ? 255u : (unsigned)b[1]);
+          fail(nullptr);
+          return;
+        }
+        state_ = CONNECTED;
+        connects++;
+        backoffMs_ = 0;
+        Serial.printf("MQTT: connected to %s\n", host_);
+        if (willTopic_) writePublish(willTopic_, (const uint8_t*)birthMessage_, strlen(birthMessage_), 0, true, 0, false);
+        writeSubscriptions();
+        for (uint8_t i = 0; i < MQTT_OUTBOX_LEN; i++) outbox_[i].sent = false;
+        return;
+
+      case 3: { // PUBLISH
+        if (rxLen_ < 2) return;
+        uint8_t qos = (rxHeader_ >> 1) & 0x03;
+        uint16_t topicLen = (b[0] << 8) | b[1];
+        size_t pos = 2 + topicLen + (qos ? 2 : 0);
+        if (pos > rxLen_) return;
+        if (qos) {
+          const uint8_t ack[4] = { 0x40, 0x02, b[2 + topicLen], b[3 + topicLen] };
+          if (client_.write(ack, 4) == 4) lastTxMs_ = millis();
+        }
+        if (topicLen >= MQTT_TOPIC_MAX || !handler_) return;
+        char topic[MQTT_TOPIC_MAX];
+        memcpy(topic, b + 2, topicLen);
+        topic[topicLen] = '\0';
+        received++;
+        handler_(topic, b + pos, rxLen_ - pos);
+        return;
+      }
+
+      case 4: { // PUBACK
+        if (rxLen_ < 2) return;
+        uint16_t id = (b[0] << 8) | b[1];
+        for (uint8_t i = 0; i < MQTT_OUTBOX_LEN; i++) {
+          if (outbox_[i].id == id) {
+            outbox_[i].id = 0;
+            published++;
+          }
+        }
+        return;
+      }
+
+      case 9: // SUBACK
+        if (rxLen_ >= 3 && b[2] == 0x80) Serial.println("MQTT: subscription refused");
+        return;
+
+      case 13: // PINGRESP
+        pingPending_ = false;
+        return;
+    }
+  }
+
+  void fail(const char* what) {
+    if (what) Serial.printf("MQTT Error: %s\n", what);
+    client_.stop();
+    failures++;
+    backoffMs_ = backoffMs_ ? backoffMs_ * 2 : MQTT_BACKOFF_MIN_MS;
+    if (backoffMs_ > MQTT_BACKOFF_MAX_MS) backoffMs_ = MQTT_BACKOFF_MAX_MS;
+    retryAt_ = millis() + backoffMs_;
+    state_ = BACKOFF;
+  }
+
+  const char* host_ = nullptr;
+  uint16_t port_ = 1883;
+  const char* clientId_ = nullptr;
+  const char* user_ = nullptr;
+  const char* password_ = nullptr;
+  const char* willTopic_ = nullptr;
+  const char* willMessage_ = nullptr;
+  const char* birthMessage_ = nullptr;
+  Handler handler_ = nullptr;
+  const char* subs_[MQTT_MAX_SUBS];
+  uint8_t subCount_ = 0;
+
+  WiFiClient client_;
+  State state_ = OFF;
+  uint32_t waitMs_ = 0;
+  uint32_t retryAt_ = 0;
+  uint32_t backoffMs_ = 0;
+  uint32_t lastTxMs_ = 0;
+  uint32_t pingMs_ = 0;
+  bool pingPending_ = false;
+  uint16_t lastId_ = 0;
+
+  Outbox outbox_[MQTT_OUTBOX_LEN] = {};
+
+  RxState rxState_ = RX_HEADER;
+  uint8_t rxHeader_ = 0;
+  uint32_t rxRemaining_ = 0;
+  uint8_t rxShift_ = 0;
+  size_t rxLen_ = 0;
+  uint8_t rxBuf_[MQTT_RX_MAX];
+};
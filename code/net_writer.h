@@ -0,0 +1,135 @@
+#pragma once
+
+// ==========================================
+// REQUEST WRITER (PORTABLE CORE)
+// ==========================================
+// Builds an outgoing HTTP request in one fixed buffer and passes it to the
+// connection in as few write() calls as possible. Over TLS each write() is
+// at least one record, and on plain TCP each one is usually one segment.
+// The Telegram request used to go out as a dozen prints; now it leaves in
+// one write, or two for a long message.
+//
+// Nothing here allocates. Text is copied in, a message is percent-encoded
+// as it streams through, and numbers and JSON entries are formatted with
+// snprintf straight into the buffer (reserve()/commit()). Out is anything
+// with write(const uint8_t*, size_t): a WiFiClient, or ByteCounter to size
+// a body for Content-Length before sending it.
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+#define NET_WRITER_BUF 512           // Bytes per write(); holds a whole Telegram request
+
+// Out that only counts, for the Content-Length pass
+struct ByteCounter {
+  size_t bytes = 0;
+  size_t write(const uint8_t*, size_t n) {
+    bytes += n;
+    return n;
+  }
+};
+
+template <typename Out>
+class NetWriter {
+ public:
+  explicit NetWriter(Out& out) : out_(out) {}
+  ~NetWriter() { flush(); }
+
+  void text(const char* s) { append(s, strlen(s)); }
+
+  // A PSTR()/PROGMEM string
+  void textP(PGM_P s) {
+    size_t n = strlen_P(s);
+    while (n) {
+      size_t k = room(n);
+      memcpy_P(buf_ + len_, s, k);
+      len_ += k;
+      s += k;
+      n -= k;
+    }
+  }
+
+  void number(uint32_t v) {
+    char* p = reserve(11);
+    commit(snprintf(p, 11, "%u", (unsigned)v));
+  }
+
+  // Percent-encoded for a URL query (RFC 3986: only unreserved bytes stay),
+  // so spaces, '&', '#', '+' and UTF-8 emoji all arrive intact
+  void encoded(const char* s) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (const uint8_t* p = (const uint8_t*)s; *p; p++) {
+      uint8_t c = *p;
+      if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+        if (len_ == NET_WRITER_BUF) flush();
+        buf_[len_++] = c;
+      } else {
+        char* e = reserve(3);
+        e[0] = '%';
+        e[1] = hex[c >> 4];
+        e[2] = hex[c & 0x0F];
+        commit(3);
+      }
+    }
+  }
+
+  // At most NET_WRITER_BUF - 1 bytes per call; longer output is cut
+  void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf_ + len_, NET_WRITER_BUF - len_, fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n >= NET_WRITER_BUF - len_ && len_) {
+      flush();
+      va_start(args, fmt);
+      n = vsnprintf(buf_, NET_WRITER_BUF, fmt, args);
+      va_end(args);
+      if (n < 0) return;
+    }
+    len_ += (size_t)n < NET_WRITER_BUF - len_ ? n : NET_WRITER_BUF - 1 - len_;
+  }
+
+  // Contiguous space for up to n bytes (n <= NET_WRITER_BUF); format into
+  // it, then commit() what was used
+  char* reserve(size_t n) {
+    if (NET_WRITER_BUF - len_ < n) flush();
+    return buf_ + len_;
+  }
+  void commit(size_t n) { len_ += n; }
+
+  void flush() {
+    if (!len_) return;
+    size_t n = out_.write((const uint8_t*)buf_, len_);
+    if (n != len_) failed = true;
+    written += len_;
+    writes++;
+    len_ = 0;
+  }
+
+  size_t written = 0;   // Bytes handed to Out
+  uint16_t writes = 0;  // write() calls
+  bool failed = false;  // A write came up short (connection lost)
+
+ private:
+  // Room for up to n more bytes, flushing if the buffer is full
+  size_t room(size_t n) {
+    if (len_ == NET_WRITER_BUF) flush();
+    size_t free = NET_WRITER_BUF - len_;
+    return n < free ? n : free;
+  }
+
+  void append(const char* s, size_t n) {
+    while (n) {
+      size_t k = room(n);
+      memcpy(buf_ + len_, s, k);
+      len_ += k;
+      s += k;
+      n -= k;
+    }
+  }
+
+  Out& out_;
+  char buf_[NET_WRITER_BUF];
+  size_t len_ = 0;
+};
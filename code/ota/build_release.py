@@ -0,0 +1,95 @@
+"""
+Smart Grain Silo - OTA Release Builder
+======================================
+Turns a compiled firmware image into a release that silos with
+OTA_ENABLED fetch on their own (see code/ota_updater.h):
+
+  firmware.bin  ->  <out>/v<version>.bin.gz   the gzipped image
+                    <out>/releases.txt        the release index, one line
+                                              per release: version size md5 path
+
+The version is FIRMWARE_VERSION from code/code.ino, so raise it there
+before building. The index keeps the older releases, newest first: a silo
+that rolls back fetches its last good version from it, so don't delete
+images that silos may still need. The gzip timestamp is fixed, so the same
+image always gives the same file and MD5.
+
+Serve <out> at --url-prefix on otaHost:otaPort (otaManifest is then
+"<prefix>/releases.txt") from a server that answers Range requests, such
+as nginx or Caddy. Python's http.server doesn't, and a silo rejects a
+resumed download that comes back whole.
+
+Usage (Arduino IDE: Sketch -> Export Compiled Binary):
+    python build_release.py ../build/code.ino.bin --out releases/silo --url-prefix /silo
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+
+CODE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+INDEX_NAME = "releases.txt"
+
+
+def firmware_version():
+    with open(os.path.join(CODE_DIR, "code.ino"), encoding="utf-8") as f:
+        match = re.search(r"^#define FIRMWARE_VERSION (\d+)", f.read(), re.M)
+    if not match:
+        raise SystemExit("[!] FIRMWARE_VERSION not found in code/code.ino")
+    return int(match.group(1))
+
+
+def read_index(path):
+    releases = {}
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) == 4 and not parts[0].startswith("#"):
+                    releases[int(parts[0])] = parts
+    return releases
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gzip a firmware image and add it to the OTA release index")
+    parser.add_argument("image", help="Compiled firmware .bin")
+    parser.add_argument("--out", default="releases", help="Folder served to the silos")
+    parser.add_argument("--url-prefix", default="/silo", help="URL path of that folder on the server")
+    parser.add_argument("--version", type=int, default=None, help="Override FIRMWARE_VERSION")
+    parser.add_argument("--keep", type=int, default=5, help="Releases kept in the index")
+    args = parser.parse_args()
+
+    version = args.version or firmware_version()
+    with open(args.image, "rb") as f:
+        image = f.read()
+    if image[:1] != b"\xe9":
+        raise SystemExit(f"[!] {args.image} is not an ESP8266 application image")
+
+    packed = gzip.compress(image, compresslevel=9, mtime=0)
+    name = f"v{version}.bin.gz"
+    os.makedirs(args.out, exist_ok=True)
+    with open(os.path.join(args.out, name), "wb") as f:
+        f.write(packed)
+    md5 = hashlib.md5(packed).hexdigest()
+    print(f"[+] Version {version}: {len(image)} -> {len(packed)} bytes "
+          f"({100 * len(packed) / len(image):.0f}%), md5 {md5}")
+
+    index_path = os.path.join(args.out, INDEX_NAME)
+    releases = read_index(index_path)
+    if version in releases:
+        print(f"[!] Replacing the existing version {version}; silos that already run it won't fetch it again")
+    releases[version] = [str(version), str(len(packed)), md5, f"{args.url_prefix.rstrip('/')}/{name}"]
+
+    # Newest first: the firmware keeps only the first OTA_MANIFEST_MAX bytes
+    kept = sorted(releases, reverse=True)[:args.keep]
+    with open(index_path, "w", encoding="utf-8") as f:
+        f.write("# version size md5 path\n")
+        for v in kept:
+            f.write(" ".join(releases[v]) + "\n")
+    print(f"[+] {index_path}: versions {', '.join(map(str, kept))}")
+
+
+if __name__ == "__main__":
+    main()
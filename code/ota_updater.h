@@ -0,0 +1,418 @@
+#pragma once
+
+// ==========================================
+// BACKGROUND FIRMWARE UPDATES (OTA_ENABLED)
+// ==========================================
+// Pulls new firmware from the fleet's own HTTP server while the silo keeps
+// monitoring. ArduinoOTA isn't used: it pushes from a laptop, one silo at a
+// time, and holds loop() for the whole upload. Here every silo polls a
+// release index (otaManifest in code.ino, written by
+// code/ota/build_release.py), one line per release:
+//   # version  size    md5 of the file                   path
+//   7          318442  9b2c...e0                         /silo/v7.bin.gz
+// and downloads the newest version above its own FIRMWARE_VERSION.
+//
+// Images are gzip-compressed (.bin.gz, about 30% smaller). The core's
+// Updater recognises the gzip header and the bootloader unpacks the image
+// while it copies it into place, so nothing is decompressed here.
+// poll() hands at most OTA_CHUNK bytes to Updater per call. Every 4 KB,
+// Updater erases and writes one flash sector, which stalls the loop for
+// about 35 ms; the sensors and the alarm keep running between sectors.
+// The MD5 from the index is checked before anything is committed. A
+// dropped link resumes where it stopped with an HTTP Range request, so a
+// weak signal costs retries, not a restart from zero.
+//
+// A verified image is installed on the next restart. The restart waits
+// until no alert is active and the fan is off, but never longer than
+// OTA_RESTART_WAIT_MS.
+//
+// The ESP8266 has one application slot, so a rollback means downloading
+// the old image again. The new version boots on trial, tracked in
+// OTA_STATE_FILE (LittleFS, which survives power loss). If it crashes
+// (exception or watchdog reset) OTA_TRIAL_CRASHES times before it is
+// confirmed, the next boot is a rollback. The silo then keeps only its
+// local control running (gas, climate, alarm, buzzer, fan) next to WiFi and
+// this updater, fetches the last confirmed-good version and records the
+// trial version as rejected, so it is never fetched again.
+// A trial version is confirmed after OTA_CONFIRM_MS of uptime plus one
+// successful check of the index, which shows the network stack works.
+
+#include <LittleFS.h>
+#include <Updater.h>
+#include "http_response.h"
+#include "net_writer.h"
+#include "platform.h"
+#include "rtc_store.h"
+
+#define OTA_CHECK_MS 3600000         // Look for a new release this often
+#define OTA_RETRY_MS 600000          // After a failed check or download
+#define OTA_TIMEOUT_MS 15000         // Connect, headers, or silence mid-image
+#define OTA_CHUNK 1024               // Image bytes per poll()
+#define OTA_RESUMES_MAX 5            // Range requests per download before giving up
+#define OTA_RESUME_DELAY_MS 5000     // Pause before a resume
+#define OTA_CONFIRM_MS 300000        // Trial uptime before the version counts as good
+#define OTA_TRIAL_CRASHES 3          // Crash resets during a trial that trigger a rollback
+#define OTA_RESTART_WAIT_MS 3600000  // Longest wait for a quiet moment to install
+#define OTA_MANIFEST_MAX 512         // Index bytes kept (newest releases first helps)
+#define OTA_STATE_FILE "/ota.state"
+
+struct OtaRelease {
+  uint32_t version = 0;
+  uint32_t size = 0;
+  char md5[33] = "";
+  char path[64] = "";
+};
+
+// Pick a release from the index text. want != 0 asks for that version;
+// otherwise the newest version above `above` that isn't `skip` is chosen.
+// False when there is none.
+inline bool parseOtaManifest(const char* text, uint32_t above, uint32_t skip, uint32_t want, OtaRelease& out) {
+  bool found = false;
+  for (const char* line = text; *line; ) {
+    const char* end = strchr(line, '\n');
+    if (!end) end = line + strlen(line);
+    char buf[128];
+    size_t n = end - line;
+    if (n >= sizeof(buf)) n = sizeof(buf) - 1;
+    memcpy(buf, line, n);
+    buf[n] = '\0';
+    line = *end ? end + 1 : end;
+
+    OtaRelease r;
+    unsigned version, size;
+    if (buf[0] == '#' || sscanf(buf, "%u %u %32s %63s", &version, &size, r.md5, r.path) != 4) continue;
+    if (strlen(r.md5) != 32 || r.path[0] != '/' || size == 0) continue;
+    r.version = version;
+    r.size = size;
+    bool match = want ? r.version == want : r.version > above && r.version != skip;
+    if (match && (!found || r.version > out.version)) {
+      out = r;
+      found = true;
+    }
+  }
+  return found;
+}
+
+class OtaUpdater {
+ public:
+  OtaUpdater(const char* host, uint16_t port, const char* manifestPath, uint32_t version)
+    : host_(host), port_(port), manifestPath_(manifestPath), version_(version) {}
+
+  // Call first thing in setup(), with LittleFS mounted. Counts a crash
+  // against a trial version. Returns true when this boot is a rollback:
+  // start only WiFi and the control tasks, and keep calling poll().
+  bool begin() {
+    if (!loadState()) state_ = Persisted();
+    if (state_.trial && state_.trial != version_) {
+      // The update was downloaded but this isn't it: it never got installed
+      Serial.printf("OTA: version %u was not installed, still on %u\n",
+                    (unsigned)state_.trial, (unsigned)version_);
+      state_.trial = 0;
+      state_.crashes = 0;
+      saveState();
+    }
+    if (trial()) {
+      uint32_t reason = platformReset().reason;
+      if (reason == REASON_WDT_RST || reason == REASON_EXCEPTION_RST || reason == REASON_SOFT_WDT_RST) {
+        state_.crashes++;
+        saveState();
+      }
+      rescue_ = state_.crashes >= OTA_TRIAL_CRASHES && state_.good && state_.good != version_;
+      Serial.printf("OTA: version %u on trial, %u crash(es)%s\n", (unsigned)version_,
+                    (unsigned)state_.crashes, rescue_ ? ", rolling back" : "");
+    }
+    nextCheckMs_ = millis();
+    return rescue_;
+  }
+
+  // Look at the index on the next poll()
+  void checkNow() {
+    if (phase_ == IDLE || phase_ == WAIT) nextCheckMs_ = millis();
+  }
+
+  // quiet: nothing would be interrupted by a restart right now
+  void poll(uint32_t now, bool quiet) {
+    switch (phase_) {
+      case IDLE:
+        if ((int32_t)(now - nextCheckMs_) < 0 || WiFi.status() != WL_CONNECTED) return;
+        checks++;
+        if (!connect()) {
+          fail("connect");
+          return;
+        }
+        request(manifestPath_, 0);
+        response_.begin(OTA_TIMEOUT_MS, manifest_, sizeof(manifest_));
+        phase_ = MANIFEST;
+        return;
+
+      case MANIFEST:
+        switch (response_.poll(client_)) {
+          case HttpResponseReader::PENDING: return;
+          case HttpResponseReader::FAILED: fail("no index"); return;
+          case HttpResponseReader::DONE: break;
+        }
+        client_.stop();
+        if (response_.code() != 200) {
+          fail("index not found");
+          return;
+        }
+        chooseRelease(now);
+        return;
+
+      case REQUEST:
+        // A resume waits out its delay, and the link, without counting
+        if ((int32_t)(now - nextCheckMs_) < 0 || WiFi.status() != WL_CONNECTED) return;
+        if (!connect()) {
+          resume(now, "connect");
+          return;
+        }
+        request(release_.path, offset_);
+        response_.beginHeaders(OTA_TIMEOUT_MS);
+        phase_ = HEADERS;
+        return;
+
+      case HEADERS:
+        switch (response_.poll(client_)) {
+          case HttpResponseReader::PENDING: return;
+          case HttpResponseReader::FAILED: resume(now, "no reply"); return;
+          case HttpResponseReader::DONE: break;
+        }
+        // A server that ignores Range would send the image from the start
+        if (response_.code() != (offset_ ? 206 : 200) ||
+            (response_.contentLength() >= 0 && (uint32_t)response_.contentLength() != release_.size - offset_)) {
+          abort("bad reply");
+          return;
+        }
+        lastDataMs_ = now;
+        phase_ = BODY;
+        return;
+
+      case BODY:
+        receive(now);
+        return;
+
+      case READY:
+        if (!quiet && now - readyMs_ < OTA_RESTART_WAIT_MS) return;
+        Serial.printf("OTA: restarting into version %u\n", (unsigned)release_.version);
+        Serial.flush();
+        ESP.restart();
+        return;
+
+      case WAIT:
+        if ((int32_t)(now - nextCheckMs_) >= 0) phase_ = IDLE;
+        return;
+    }
+  }
+
+  bool rescue() const { return rescue_; }
+  bool trial() const { return state_.trial == version_; }
+  bool downloading() const { return phase_ >= REQUEST && phase_ <= BODY; }
+  uint32_t target() const { return release_.version; }  // Version being fetched or installed
+  uint32_t progress() const { return offset_; }
+  uint32_t size() const { return release_.size; }
+  uint32_t good() const { return state_.good; }
+  uint32_t rejected() const { return state_.rejected; }
+
+  const char* phaseName() const {
+    static const char* const names[] = { "idle", "checking", "connecting", "connecting", "downloading", "ready", "waiting" };
+    return names[phase_];
+  }
+
+  // Stats
+  uint32_t checks = 0;       // Index fetches started
+  uint32_t downloads = 0;    // Images received and verified
+  uint32_t failures = 0;     // Failed checks and downloads
+  uint32_t resumes = 0;      // Range requests after a dropped link
+  uint32_t bytes = 0;        // Image bytes received
+  uint32_t lastMs = 0;       // Duration of the last complete download
+  uint32_t lastBytes = 0;    // ...and its size
+
+ private:
+  enum Phase { IDLE, MANIFEST, REQUEST, HEADERS, BODY, READY, WAIT };
+
+  // Kept in flash across power loss
+  struct Persisted {
+    uint32_t trial = 0;      // Version installed but not yet confirmed
+    uint32_t good = 0;       // Last confirmed version (the rollback target)
+    uint32_t rejected = 0;   // Version rolled back from; never fetched again
+    uint32_t crashes = 0;    // Crash resets of the trial version
+  };
+
+  void chooseRelease(uint32_t now) {
+    // An index cut at OTA_MANIFEST_MAX may end in half a line
+    if (response_.bodyLength() >= sizeof(manifest_) - 1) {
+      char* nl = strrchr(manifest_, '\n');
+      *(nl ? nl + 1 : manifest_) = '\0';
+    }
+    // A version that came by OTA or by cable becomes the rollback target
+    // once it has run long enough and the index was reachable. Until then
+    // nothing newer is fetched.
+    if (!rescue_ && state_.good != version_) {
+      if (millis() < OTA_CONFIRM_MS) {
+        wait(now, OTA_CONFIRM_MS - millis());
+        return;
+      }
+      state_.good = version_;
+      state_.trial = 0;
+      state_.crashes = 0;
+      saveState();
+      Serial.printf("OTA: version %u confirmed\n", (unsigned)version_);
+    }
+
+    OtaRelease r;
+    bool found = rescue_ ? parseOtaManifest(manifest_, 0, 0, state_.good, r)
+                         : parseOtaManifest(manifest_, version_, state_.rejected, 0, r);
+    if (!found) {
+      if (rescue_) fail("good version not in index");
+      else wait(now, OTA_CHECK_MS);
+      return;
+    }
+    if (!Update.begin(r.size) || !Update.setMD5(r.md5)) {
+      Update.end();
+      fail("no room for image");
+      return;
+    }
+    release_ = r;
+    offset_ = 0;
+    resumesLeft_ = OTA_RESUMES_MAX;
+    startMs_ = now;
+    nextCheckMs_ = now;
+    phase_ = REQUEST;
+    Serial.printf("OTA: fetching version %u (%u bytes)\n", (unsigned)r.version, (unsigned)r.size);
+  }
+
+  void receive(uint32_t now) {
+    uint8_t buf[256];
+    size_t budget = OTA_CHUNK;
+    while (budget && offset_ < release_.size) {
+      size_t want = release_.size - offset_;
+      if (want > sizeof(buf)) want = sizeof(buf);
+      if (want > budget) want = budget;
+      int got = client_.read(buf, want);
+      if (got <= 0) break;
+      if (Update.write(buf, got) != (size_t)got) {
+        abort("flash write");
+        return;
+      }
+      offset_ += got;
+      bytes += got;
+      budget -= got;
+      lastDataMs_ = now;
+    }
+
+    if (offset_ < release_.size) {
+      if (!client_.connected() && !client_.available()) resume(now, "link lost");
+      else if (now - lastDataMs_ > OTA_TIMEOUT_MS) resume(now, "stalled");
+      return;
+    }
+
+    client_.stop();
+    if (!Update.end()) {
+      // MD5 mismatch or a bad image header
+      failures++;
+      Serial.printf("OTA: version %u rejected by Updater (error %u)\n",
+                    (unsigned)release_.version, (unsigned)Update.getError());
+      wait(now, OTA_RETRY_MS);
+      return;
+    }
+    downloads++;
+    lastMs = now - startMs_;
+    lastBytes = release_.size;
+    if (rescue_) {
+      // Back to the good version; never fetch the one that crashed
+      state_.rejected = state_.trial;
+      state_.trial = 0;
+    } else {
+      state_.trial = release_.version;
+    }
+    state_.crashes = 0;
+    saveState();
+    Serial.printf("OTA: version %u verified, %u bytes in %u ms\n", (unsigned)release_.version,
+                  (unsigned)lastBytes, (unsigned)lastMs);
+    readyMs_ = now;
+    phase_ = READY;
+  }
+
+  // Pick the download up where it stopped, or give up on it
+  void resume(uint32_t now, const char* why) {
+    client_.stop();
+    if (!resumesLeft_) {
+      abort(why);
+      return;
+    }
+    resumesLeft_--;
+    resumes++;
+    Serial.printf("OTA: %s at %u/%u bytes, resuming\n", why, (unsigned)offset_, (unsigned)release_.size);
+    nextCheckMs_ = now + OTA_RESUME_DELAY_MS;
+    phase_ = REQUEST;
+  }
+
+  // Drop the staged image; the running firmware is untouched
+  void abort(const char* why) {
+    client_.stop();
+    Update.end();  // With bytes still missing this discards the staging area
+    fail(why);
+  }
+
+  void fail(const char* why) {
+    client_.stop();
+    failures++;
+    Serial.printf("OTA: %s\n", why);
+    wait(millis(), OTA_RETRY_MS);
+  }
+
+  void wait(uint32_t now, uint32_t ms) {
+    nextCheckMs_ = now + ms;
+    phase_ = WAIT;
+  }
+
+  bool connect() {
+    client_.setTimeout(OTA_TIMEOUT_MS);
+    return client_.connect(host_, port_);
+  }
+
+  void request(const char* path, uint32_t from) {
+    NetWriter<WiFiClient> w(client_);
+    w.printf("GET %s HTTP/1.1\r\nHost: %s\r\n", path, host_);
+    if (from) w.printf("Range: bytes=%u-\r\n", (unsigned)from);
+    w.text("Connection: close\r\n\r\n");
+  }
+
+  bool loadState() {
+    File f = LittleFS.open(OTA_STATE_FILE, "r");
+    if (!f) return false;
+    RtcSlot<Persisted> slot;
+    bool ok = f.read((uint8_t*)&slot, sizeof(slot)) == sizeof(slot) &&
+              slot.crc == rtcCrc(&slot.value, sizeof(slot.value), sizeof(slot.value));
+    f.close();
+    if (ok) state_ = slot.value;
+    return ok;
+  }
+
+  // Same CRC framing as the RTC slots
+  void saveState() {
+    File f = LittleFS.open(OTA_STATE_FILE, "w");
+    if (!f) return;
+    RtcSlot<Persisted> slot = { rtcCrc(&state_, sizeof(state_), sizeof(state_)), state_ };
+    f.write((const uint8_t*)&slot, sizeof(slot));
+    f.close();
+  }
+
+  const char* host_;
+  uint16_t port_;
+  const char* manifestPath_;
+  uint32_t version_;
+  WiFiClient client_;
+  HttpResponseReader response_;
+  char manifest_[OTA_MANIFEST_MAX];
+  Persisted state_;
+  bool rescue_ = false;
+  Phase phase_ = IDLE;
+  OtaRelease release_;
+  uint32_t offset_ = 0;
+  uint8_t resumesLeft_ = 0;
+  uint32_t nextCheckMs_ = 0;
+  uint32_t startMs_ = 0;
+  uint32_t lastDataMs_ = 0;
+  uint32_t readyMs_ = 0;
+};
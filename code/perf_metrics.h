@@ -0,0 +1,120 @@
+#pragma once
+
+// ==========================================
+// RUNTIME METRICS (/metrics)
+// ==========================================
+// Hot-path probes are timed with the CPU cycle counter (one register
+// read), and the duration goes into a log2 histogram: the bucket comes
+// from one count-leading-zeros instruction, then a few adds. No floating
+// point, no allocation. Bucket k counts durations <= 2^k us, from 1 us to
+// ~1 s; anything longer lands in +Inf. The cycle counter wraps after ~53 s
+// at 80 MHz, well beyond anything a probe measures.
+//
+// MetricsWriter streams the Prometheus text format (version 0.0.4) in
+// chunks from a small stack buffer, the same way /tasks is sent, so a
+// scrape never assembles the whole page in RAM.
+
+#include <stdarg.h>
+#include "platform.h"
+
+#define PERF_BUCKETS 21              // Upper bounds 2^0 .. 2^20 us, then +Inf
+
+struct PerfHistogram {
+  uint32_t buckets[PERF_BUCKETS + 1] = {};  // Not cumulative; the writer adds them up
+  uint32_t count = 0;
+  uint64_t sumUs = 0;
+  uint32_t maxUs = 0;
+
+  void record(uint32_t cycles) {
+    uint32_t us = cycles / (F_CPU / 1000000L);
+    uint8_t k = us <= 1 ? 0 : 32 - __builtin_clz(us - 1);
+    buckets[k < PERF_BUCKETS ? k : PERF_BUCKETS]++;
+    count++;
+    sumUs += us;
+    if (us > maxUs) maxUs = us;
+  }
+};
+
+// Times the enclosing scope into a histogram
+class PerfScope {
+ public:
+  explicit PerfScope(PerfHistogram& h) : h_(h), start_(ESP.getCycleCount()) {}
+  ~PerfScope() { h_.record(ESP.getCycleCount() - start_); }
+
+ private:
+  PerfHistogram& h_;
+  uint32_t start_;
+};
+
+class MetricsWriter {
+ public:
+  explicit MetricsWriter(ESP8266WebServer& server) : server_(server) {
+    server_.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server_.send(200, "text/plain; version=0.0.4", "");
+  }
+
+  ~MetricsWriter() {
+    if (len_) server_.sendContent(buf_, len_);
+    server_.sendContent("");
+  }
+
+  // # HELP and # TYPE lines, once per metric family
+  void family(const char* name, const char* type, const char* help) {
+    print("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  }
+
+  // One sample; labels is the text between the braces, or nullptr
+  void sample(const char* name, const char* labels, uint32_t value) {
+    if (labels) print("%s{%s} %u\n", name, labels, (unsigned)value);
+    else print("%s %u\n", name, (unsigned)value);
+  }
+  void sample(const char* name, const char* labels, float value) {
+    if (labels) print("%s{%s} %g\n", name, labels, value);
+    else print("%s %g\n", name, value);
+  }
+
+  // Family header plus a single unlabelled sample
+  template <typename T>
+  void metric(const char* name, const char* type, const char* help, T value) {
+    family(name, type, help);
+    sample(name, nullptr, value);
+  }
+
+  // _bucket/_sum/_count lines in seconds (the family header is the caller's)
+  void histogram(const char* name, const char* labels, const PerfHistogram& h) {
+    const char* sep = labels ? "," : "";
+    if (!labels) labels = "";
+    uint32_t cumulative = 0;
+    for (uint8_t k = 0; k < PERF_BUCKETS; k++) {
+      cumulative += h.buckets[k];
+      print("%s_bucket{%s%sle=\"%g\"} %u\n", name, labels, sep, (1UL << k) * 1e-6, (unsigned)cumulative);
+    }
+    print("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, labels, sep, (unsigned)h.count);
+    const char* open = *labels ? "{" : "";
+    const char* close = *labels ? "}" : "";
+    print("%s_sum%s%s%s %.6f\n", name, open, labels, close, h.sumUs * 1e-6);
+    print("%s_count%s%s%s %u\n", name, open, labels, close, (unsigned)h.count);
+  }
+
+ private:
+  void print(const char* fmt, ...) {
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+      va_list args;
+      va_start(args, fmt);
+      int n = vsnprintf(buf_ + len_, sizeof(buf_) - len_, fmt, args);
+      va_end(args);
+      if (n < 0) return;
+      if (len_ + n < sizeof(buf_)) {
+        len_ += n;
+        return;
+      }
+      // Didn't fit: send what we have and format again into the empty buffer
+      if (len_) server_.sendContent(buf_, len_);
+      len_ = 0;
+    }
+  }
+
+  ESP8266WebServer& server_;
+  char buf_[512];
+  size_t len_ = 0;
+};
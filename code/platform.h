@@ -0,0 +1,146 @@
+#pragma once
+
+// ==========================================
+// TARGET BOARD (ESP8266 OR ESP32)
+// ==========================================
+// The firmware is written against the ESP8266 Arduino core. Built for an
+// ESP32 (Arduino core 3.x), this header maps the few calls that differ, so
+// the rest of the code keeps the ESP8266 names: ESP8266WebServer, the
+// REASON_* reset codes and one RTC memory layout.
+//
+// SILO_DUAL_CORE is 1 on the ESP32. The control side and the network side
+// then run as two FreeRTOS tasks, one per core (see code.ino and
+// core_link.h). Standalone, always-on silos only: ESP-NOW roles, the sleep
+// modes and OTA updates stay ESP8266 features.
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <WiFi.h>
+#include <WebServer.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define SILO_DUAL_CORE 1
+
+typedef WebServer ESP8266WebServer;
+
+// The ESP8266 reset codes (user_interface.h), which the reset log stores
+#define REASON_DEFAULT_RST 0
+#define REASON_WDT_RST 1
+#define REASON_EXCEPTION_RST 2
+#define REASON_SOFT_WDT_RST 3
+#define REASON_SOFT_RESTART 4
+#define REASON_DEEP_SLEEP_AWAKE 5
+#define REASON_EXT_SYS_RST 6
+
+#else
+
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+
+#define SILO_DUAL_CORE 0
+
+#endif
+
+#define PLATFORM_RTC_BLOCKS 128      // RTC user memory, 4-byte blocks
+
+struct PlatformReset {
+  uint32_t reason;                   // REASON_*
+  uint32_t exccause;                 // Exception resets only (ESP8266)
+  uint32_t epc1;
+};
+
+#if SILO_DUAL_CORE
+
+// Survives resets, panics and deep sleep like the ESP8266's RTC user
+// memory; random after power-up, like it too
+static RTC_NOINIT_ATTR uint32_t platformRtcMemory[PLATFORM_RTC_BLOCKS];
+
+inline PlatformReset platformReset() {
+  switch (esp_reset_reason()) {
+    case ESP_RST_INT_WDT:
+    case ESP_RST_WDT:       return { REASON_WDT_RST, 0, 0 };
+    case ESP_RST_PANIC:     return { REASON_EXCEPTION_RST, 0, 0 };
+    case ESP_RST_TASK_WDT:  return { REASON_SOFT_WDT_RST, 0, 0 };
+    case ESP_RST_SW:        return { REASON_SOFT_RESTART, 0, 0 };
+    case ESP_RST_DEEPSLEEP: return { REASON_DEEP_SLEEP_AWAKE, 0, 0 };
+    case ESP_RST_EXT:       return { REASON_EXT_SYS_RST, 0, 0 };
+    default:                return { REASON_DEFAULT_RST, 0, 0 };  // Power-on, brownout
+  }
+}
+
+// Same wording as the ESP8266's ESP.getResetReason()
+inline String platformResetText() {
+  switch (esp_reset_reason()) {
+    case ESP_RST_INT_WDT:
+    case ESP_RST_WDT:       return "Hardware Watchdog";
+    case ESP_RST_PANIC:     return "Exception";
+    case ESP_RST_TASK_WDT:  return "Software Watchdog";
+    case ESP_RST_SW:        return "Software/System restart";
+    case ESP_RST_DEEPSLEEP: return "Deep-Sleep Wake";
+    case ESP_RST_EXT:       return "External System";
+    case ESP_RST_BROWNOUT:  return "Brownout";
+    default:                return "Power On";
+  }
+}
+
+inline bool platformRtcRead(uint32_t block, uint32_t* data, size_t size) {
+  memcpy(data, platformRtcMemory + block, size);
+  return true;
+}
+
+inline bool platformRtcWrite(uint32_t block, const uint32_t* data, size_t size) {
+  memcpy(platformRtcMemory + block, data, size);
+  return true;
+}
+
+// The low three MAC bytes, like the ESP8266 chip ID
+inline uint32_t platformChipId() { return (uint32_t)(ESP.getEfuseMac() >> 24) & 0xFFFFFF; }
+inline uint32_t platformMaxFreeBlock() { return ESP.getMaxAllocHeap(); }
+inline uint32_t platformHeapFragmentation() {
+  uint32_t free = ESP.getFreeHeap();
+  return free ? 100 - (uint64_t)ESP.getMaxAllocHeap() * 100 / free : 0;
+}
+
+// lwIP sockets don't report free send buffer. A write that doesn't fit
+// waits for the ACKs, which only holds up the network core.
+inline int platformWriteRoom(WiFiClient& client) { return client.connected() ? 1436 : 0; }
+
+inline void platformRadioOff() { WiFi.mode(WIFI_OFF); }
+inline void platformRadioOn() { WiFi.mode(WIFI_STA); }
+inline void platformDeepSleep(uint64_t us, bool) { ESP.deepSleep(us); }
+
+#else
+
+inline PlatformReset platformReset() {
+  const rst_info* info = ESP.getResetInfoPtr();
+  return { info->reason, info->exccause, info->epc1 };
+}
+
+inline String platformResetText() { return ESP.getResetReason(); }
+
+inline bool platformRtcRead(uint32_t block, uint32_t* data, size_t size) {
+  return ESP.rtcUserMemoryRead(block, data, size);
+}
+
+inline bool platformRtcWrite(uint32_t block, const uint32_t* data, size_t size) {
+  return ESP.rtcUserMemoryWrite(block, (uint32_t*)data, size);
+}
+
+inline uint32_t platformChipId() { return ESP.getChipId(); }
+inline uint32_t platformMaxFreeBlock() { return ESP.getMaxFreeBlockSize(); }
+inline uint32_t platformHeapFragmentation() { return ESP.getHeapFragmentation(); }
+inline int platformWriteRoom(WiFiClient& client) { return client.availableForWrite(); }
+inline void platformRadioOff() { WiFi.forceSleepBegin(); }
+inline void platformRadioOn() { WiFi.forceSleepWake(); }
+
+// radio: calibrate and enable RF on the wake; otherwise it stays off
+inline void platformDeepSleep(uint64_t us, bool radio) {
+  ESP.deepSleep(us, radio ? WAKE_RF_DEFAULT : WAKE_RF_DISABLED);
+}
+
+#endif
@@ -0,0 +1,237 @@
+#pragma once
+
+// ==========================================
+// LOW-POWER MODES
+// ==========================================
+// POWER_MODE selects how the node spends the time between samples:
+//
+//   POWER_ALWAYS_ON    CPU and radio always on (default). The dashboard is
+//                      always reachable.
+//   POWER_MODEM_SLEEP  The firmware runs as usual, but the radio is off
+//                      between upload windows. It comes up every
+//                      POWER_FLUSH_PERIOD_MS, or at once when an alert is
+//                      queued, drains ThingSpeak and Telegram, and goes off
+//                      again. Gas, PIR, fan and buzzer keep their normal
+//                      timing; the dashboard only answers during a window.
+//   POWER_DEEP_SLEEP   The node deep-sleeps between samples (wire D0 to
+//                      RST). A timer wake reads the sensors with the radio
+//                      disabled, adds the sample to an RTC memory
+//                      accumulator and sleeps again. The full firmware
+//                      boots, radio on, only to flush a full accumulator or
+//                      when a sample needs attention (gas near the alarm,
+//                      humidity that wants the fan, motion). It stays up
+//                      while an alarm or the fan is active.
+//
+// Light sleep is not used: forced light sleep stops the clock behind
+// millis(), which every filter and timer here runs on, and automatic light
+// sleep only engages in idle gaps far longer than our 5-50 ms task periods.
+//
+// Current is estimated, not measured: the time spent in each state is
+// weighted by the POWER_MA_* figures below (datasheet values for a bare
+// ESP-12E; replace them with bench readings of your own board). The sensor
+// load is reported separately because the MQ-2 heater alone (~150 mA at
+// 5 V) outweighs anything the ESP8266 can save.
+
+#include <Arduino.h>
+#include "rtc_store.h"
+#include "sample_history.h"
+#include "gas_channel.h"
+
+#define POWER_ALWAYS_ON 0
+#define POWER_MODEM_SLEEP 1
+#define POWER_DEEP_SLEEP 2
+
+#ifndef POWER_MODE
+#define POWER_MODE POWER_ALWAYS_ON
+#endif
+
+#define POWER_FLUSH_PERIOD_MS 600000 // Modem sleep: radio window at most this often
+#define POWER_RADIO_MIN_MS 15000     // Shortest radio window (NTP, a dashboard glance)
+#define POWER_RADIO_MAX_MS 60000     // Longest, when the network won't cooperate
+#define POWER_RETRY_WAKES 40         // Deep sleep: quick wakes after a failed flush (~10 min)
+#define POWER_RTC_SAMPLES 30         // Deep sleep: accumulator (7.5 min; <= UPLOAD_BATCH_MAX)
+
+#define POWER_MA_RADIO 75.0f         // Awake, associated, idle listening
+#define POWER_MA_CPU 16.0f           // Awake, radio off (modem sleep)
+#define POWER_MA_DEEP 0.02f          // Deep sleep (NodeMCU boards add ~10 mA for USB/LDO)
+#define POWER_MA_SENSORS 152.0f      // MQ-2 heater + DHT11 + PIR (fan relay not included)
+
+#define RTC_SLOT_POWER 40            // PowerState, 74 blocks
+
+// Same fixed point as SampleHistory
+struct PowerSample {
+  int16_t temp;
+  uint8_t hum;
+  uint8_t motion;
+  uint16_t gas;
+  uint16_t gasFiltered;
+};
+
+struct PowerState {
+  uint64_t radioMs;      // Awake with the radio on
+  uint64_t cpuMs;        // Awake with the radio off
+  uint64_t sleepMs;      // Deep sleep (as requested from the timer)
+  uint32_t wakes;        // Deep-sleep wakes
+  uint32_t fullWakes;    // ...that booted the full firmware
+  int32_t gasEma;        // GasChannel filter, Q4
+  int32_t gasBaseline;
+  uint32_t dropped;      // Samples lost because the accumulator was full
+  uint16_t count;        // Samples held in samples[]
+  uint8_t flags;         // POWER_FLAG_*
+  uint8_t retryWakes;    // Quick wakes left before the next flush attempt
+  PowerSample samples[POWER_RTC_SAMPLES];
+};
+
+#define POWER_FLAG_GAS_WARM 0x01     // MQ-2 heater has been on for GAS_WARMUP_MS
+#define POWER_FLAG_GAS_ALARM 0x02
+#define POWER_FLAG_FULL_WAKE 0x04    // The next wake boots the full firmware
+
+static_assert(RTC_SLOT_POWER + sizeof(RtcSlot<PowerState>) / 4 <= RTC_USER_BLOCKS,
+              "PowerState does not fit in RTC user memory");
+
+class PowerManager {
+ public:
+  // Load the state kept across deep sleep. Returns true when this boot is a
+  // deep-sleep wake (as opposed to power-up, reset or a new flash).
+  bool begin() {
+    if (POWER_MODE != POWER_DEEP_SLEEP) return false;
+    if (!rtcLoad(RTC_SLOT_POWER, state_)) {
+      state_ = PowerState();
+      return false;
+    }
+    if (platformReset().reason != REASON_DEEP_SLEEP_AWAKE) return false;
+    state_.wakes++;
+    if (fullWake()) state_.fullWakes++;
+    return true;
+  }
+
+  // Does this wake boot the full firmware? (Decided before the last sleep.)
+  bool fullWake() const { return state_.flags & POWER_FLAG_FULL_WAKE; }
+
+  // Add the time since the last call to the radio-on or radio-off total
+  void account(bool radioOn) {
+    uint32_t now = millis();
+    (radioOn ? state_.radioMs : state_.cpuMs) += now - lastMs_;
+    lastMs_ = now;
+  }
+
+  // Estimated average ESP8266 current since power-up, in mA
+  float averageMa() const {
+    float total = (float)(state_.radioMs + state_.cpuMs + state_.sleepMs);
+    if (total <= 0) return 0;
+    return (state_.radioMs * POWER_MA_RADIO + state_.cpuMs * POWER_MA_CPU +
+            state_.sleepMs * POWER_MA_DEEP) / total;
+  }
+
+  // Share of the time the radio was on, in percent
+  float radioPct() const {
+    float total = (float)(state_.radioMs + state_.cpuMs + state_.sleepMs);
+    return total > 0 ? state_.radioMs * 100.0f / total : 0;
+  }
+
+  // ---- RTC sample accumulator (deep sleep) ----
+
+  uint16_t samples() const { return state_.count; }
+  bool full() const { return state_.count >= POWER_RTC_SAMPLES; }
+
+  // Append a sample; the oldest one is dropped when full
+  void addSample(float temp, float hum, int gas, int gasFiltered, uint8_t motion) {
+    if (full()) {
+      memmove(state_.samples, state_.samples + 1, sizeof(PowerSample) * (POWER_RTC_SAMPLES - 1));
+      state_.count--;
+      state_.dropped++;
+    }
+    PowerSample& s = state_.samples[state_.count++];
+    s.temp = isnan(temp) ? HISTORY_TEMP_NONE
+                         : (int16_t)constrain(lroundf(temp * 100.0f), -32767L, 32767L);
+    s.hum = isnan(hum) ? HISTORY_HUM_NONE : (uint8_t)constrain(lroundf(hum * 2.0f), 0L, 200L);
+    s.motion = motion;
+    s.gas = (uint16_t)constrain(gas, 0, 65535);
+    s.gasFiltered = (uint16_t)constrain(gasFiltered, 0, 65535);
+  }
+
+  // Full wake: move the accumulated samples into the history, oldest first.
+  // They were taken SAMPLE_PERIOD_MS apart, which is what the history
+  // assumes when it counts timestamps back from the newest.
+  void replay(SampleHistory& history) {
+    for (uint16_t i = 0; i < state_.count; i++) {
+      const PowerSample& s = state_.samples[i];
+      history.push(millis(), s.temp == HISTORY_TEMP_NONE ? NAN : s.temp / 100.0f,
+                   s.hum == HISTORY_HUM_NONE ? NAN : s.hum / 2.0f,
+                   s.gas, s.gasFiltered, s.motion);
+    }
+    state_.count = 0;
+  }
+
+  // Before sleeping from a full wake: keep whatever ThingSpeak hasn't
+  // accepted (seq >= firstUnsent), newest samples first if it doesn't fit.
+  // A failed flush holds off the next attempt for POWER_RETRY_WAKES.
+  void stash(const SampleHistory& history, uint32_t firstUnsent, bool flushed) {
+    uint32_t unsent = history.nextSeq() - firstUnsent;
+    uint32_t keep = unsent < POWER_RTC_SAMPLES ? unsent : POWER_RTC_SAMPLES;
+    state_.dropped += unsent - keep;
+    state_.count = 0;
+    for (uint32_t seq = history.nextSeq() - keep; seq < history.nextSeq(); seq++) {
+      PowerSample& s = state_.samples[state_.count++];
+      s.temp = history.tempCentiAt(seq);
+      s.hum = history.humHalfAt(seq);
+      s.motion = history.motionAt(seq);
+      s.gas = history.gasAt(seq);
+      s.gasFiltered = history.gasFilteredAt(seq);
+    }
+    state_.retryWakes = flushed ? 0 : POWER_RETRY_WAKES;
+  }
+
+  // A full accumulator flushes, unless the last flush failed recently
+  bool flushDue() {
+    if (state_.retryWakes) {
+      state_.retryWakes--;
+      return false;
+    }
+    return state_.count + 1 >= POWER_RTC_SAMPLES;
+  }
+
+  void saveGas(const GasChannel& gas) {
+    state_.gasEma = gas.emaQ4();
+    state_.gasBaseline = gas.baselineQ4();
+    state_.flags &= ~(POWER_FLAG_GAS_ALARM | POWER_FLAG_GAS_WARM);
+    if (gas.alarm()) state_.flags |= POWER_FLAG_GAS_ALARM;
+    // Each wake restarts millis(), so warm-up is judged on the total time
+    if (!gas.warmingUp() || state_.radioMs + state_.cpuMs + state_.sleepMs >= GAS_WARMUP_MS)
+      state_.flags |= POWER_FLAG_GAS_WARM;
+  }
+
+  // Returns false if there is nothing to restore (first boot after power-up)
+  bool restoreGas(GasChannel& gas) const {
+    if (state_.wakes == 0) return false;
+    gas.restore(state_.gasEma, state_.gasBaseline, state_.flags & POWER_FLAG_GAS_ALARM,
+                state_.flags & POWER_FLAG_GAS_WARM);
+    return true;
+  }
+
+  // Deep sleep for ms. fullWakeNext = the next wake needs the radio and the
+  // full firmware; otherwise the RF section stays off (no calibration).
+  // Does not return.
+  void sleep(uint32_t ms, bool radioOn, bool fullWakeNext) {
+    account(radioOn);
+    state_.sleepMs += ms;
+    state_.flags &= ~POWER_FLAG_FULL_WAKE;
+    if (fullWakeNext) state_.flags |= POWER_FLAG_FULL_WAKE;
+    rtcSave(RTC_SLOT_POWER, state_);
+    platformDeepSleep((uint64_t)ms * 1000, fullWakeNext);
+  }
+
+  const PowerState& state() const { return state_; }
+
+  const char* modeName() const {
+    switch (POWER_MODE) {
+      case POWER_MODEM_SLEEP: return "modem-sleep";
+      case POWER_DEEP_SLEEP: return "deep-sleep";
+      default: return "always-on";
+    }
+  }
+
+ private:
+  PowerState state_ = {};
+  uint32_t lastMs_ = 0;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+// ==========================================
+// GRAIN PROBE DRIVERS
+// ==========================================
+// ProbeBus drivers for probe_set.h. None of them waits for a conversion:
+// start() only sends the command and says how long the sensors need.
+//   DhtProbeBus     one DHT11/22 per pin. The DHT can't convert ahead of
+//                   time; the read is the 5 ms bit-banged transfer.
+//   Sht3xProbeBus   up to two SHT3x (0x44, 0x45) on an I2C bus. Single
+//                   shot, high repeatability, no clock stretching: 15 ms.
+//   Ds18b20ProbeBus a OneWire string of DS18B20s. One Convert T to all of
+//                   them at once (skip ROM), then each scratchpad is read
+//                   by ROM code: 750 ms at the default 12 bits.
+// Results are CRC-checked where the sensor sends a CRC (SHT3x, DS18B20).
+//
+// DS18B20 indices are in the order the ROM search finds the sensors, which
+// depends only on their ROM codes. /tasks prints each probe's ROM code, so
+// the table in code.ino can be matched to the depths on the string.
+
+#include <Arduino.h>
+#include <DHT.h>
+#include <OneWire.h>
+#include <Wire.h>
+#include "probe_set.h"
+
+#define SHT3X_CONVERSION_MS 16
+#define DS18B20_CONVERSION_MS 750    // 12-bit resolution
+#define DS18B20_POWER_ON 0x0550      // 85.0 C: read before any conversion finished
+
+class DhtProbeBus : public ProbeBus {
+ public:
+  explicit DhtProbeBus(DHT& dht) : dht_(dht) {}
+  const char* kind() const override { return "dht"; }
+  void begin() override { dht_.begin(); }
+  uint16_t start() override { return 0; }
+  bool read(uint8_t, ProbeReading& out) override {
+    if (!dht_.read(true)) return false;
+    out.temp = dht_.readTemperature(); // Cached by read() above
+    out.hum = dht_.readHumidity();
+    return !isnan(out.temp) && !isnan(out.hum);
+  }
+
+ private:
+  DHT& dht_;
+};
+
+class Sht3xProbeBus : public ProbeBus {
+ public:
+  static constexpr uint8_t kAddresses[2] = { 0x44, 0x45 };  // ADDR pin low / high
+
+  explicit Sht3xProbeBus(TwoWire& wire) : wire_(wire) {}
+  const char* kind() const override { return "sht3x"; }
+
+  uint16_t start() override {
+    for (uint8_t i = 0; i < 2; i++) {
+      wire_.beginTransmission(kAddresses[i]);
+      wire_.write(0x24);  // Single shot, high repeatability, no clock stretching
+      wire_.write(0x00);
+      started_[i] = wire_.endTransmission() == 0;  // Absent sensors don't ACK
+    }
+    return SHT3X_CONVERSION_MS;
+  }
+
+  bool read(uint8_t index, ProbeReading& out) override {
+    if (index > 1 || !started_[index]) return false;
+    uint8_t b[6];
+    if (wire_.requestFrom(kAddresses[index], (uint8_t)6) != 6) return false;
+    for (uint8_t& x : b) x = wire_.read();
+    if (crc8(b) != b[2] || crc8(b + 3) != b[5]) return false;
+    out.temp = -45.0f + 175.0f * ((b[0] << 8) | b[1]) / 65535.0f;
+    out.hum = 100.0f * ((b[3] << 8) | b[4]) / 65535.0f;
+    return true;
+  }
+
+ private:
+  // Sensirion CRC-8 over one 16-bit word: poly 0x31, init 0xFF
+  static uint8_t crc8(const uint8_t* p) {
+    uint8_t crc = 0xFF;
+    for (uint8_t i = 0; i < 2; i++) {
+      crc ^= p[i];
+      for (uint8_t bit = 0; bit < 8; bit++) crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+  }
+
+  TwoWire& wire_;
+  bool started_[2] = {};
+};
+
+class Ds18b20ProbeBus : public ProbeBus {
+ public:
+  explicit Ds18b20ProbeBus(OneWire& ow) : ow_(ow) {}
+  const char* kind() const override { return "ds18b20"; }
+
+  // Find the sensors on the string
+  void begin() override {
+    uint8_t rom[8];
+    found_ = 0;
+    ow_.reset_search();
+    while (found_ < PROBE_MAX && ow_.search(rom)) {
+      if (rom[0] != 0x28 || OneWire::crc8(rom, 7) != rom[7]) continue;  // Not a DS18B20
+      memcpy(roms_[found_++], rom, 8);
+    }
+  }
+
+  uint16_t start() override {
+    if (!found_ || !ow_.reset()) return 0;
+    ow_.skip();
+    ow_.write(0x44, 1);  // Convert T on every sensor; keep the bus powered (parasite mode)
+    return DS18B20_CONVERSION_MS;
+  }
+
+  bool read(uint8_t index, ProbeReading& out) override {
+    if (index >= found_ || !ow_.reset()) return false;
+    ow_.select(roms_[index]);
+    ow_.write(0xBE);     // Read scratchpad
+    uint8_t b[9];
+    ow_.read_bytes(b, sizeof(b));
+    if (OneWire::crc8(b, 8) != b[8]) return false;
+    int16_t raw = (int16_t)((b[1] << 8) | b[0]);
+    if (raw == DS18B20_POWER_ON) return false;
+    out.temp = raw / 16.0f;
+    return true;
+  }
+
+  uint8_t found() const { return found_; }
+  const uint8_t* rom(uint8_t index) const { return index < found_ ? roms_[index] : nullptr; }
+
+ private:
+  OneWire& ow_;
+  uint8_t roms_[PROBE_MAX][8];
+  uint8_t found_ = 0;
+};
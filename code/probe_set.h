@@ -0,0 +1,180 @@
+#pragma once
+
+// ==========================================
+// GRAIN PROBES (PORTABLE CORE)
+// ==========================================
+// The headspace DHT (dht_sampler.h) only sees the air above the grain, but
+// spoilage starts in the mass. Probes at several depths are listed in a
+// table in code.ino. Each row names a probe, its depth and its place on a
+// bus. A ProbeBus driver (probe_drivers.h) runs one physical bus: a DHT
+// pin, an I2C bus of SHT3x sensors, or a OneWire string of DS18B20s.
+//
+// Every cycle, ProbeSet starts a conversion on each bus at once, then
+// reads each probe when its bus says the result is ready, one read per
+// poll(). The sensors convert in parallel and nothing waits, so a cycle
+// takes about as long as the slowest bus (750 ms for a DS18B20), not the
+// sum of all of them. /tasks shows both numbers.
+//
+// Probe values are tracked like the headspace DHT: consecutive failures
+// and the age of the last good reading make a probe stale, and a stale
+// probe is ignored by the alarm rules and recorded as missing.
+
+#include <Arduino.h>
+
+#ifndef GRAIN_PROBES
+#define GRAIN_PROBES 0               // Rows in the probe table in code.ino; 0 = headspace DHT only
+#endif
+
+#define PROBE_MAX 6                  // History keeps 3 bytes per probe per sample (3 KB each)
+#define PROBE_MAX_BUSES 4
+#define PROBE_CYCLE_MS 5000          // How often all probes are read
+#define PROBE_STALE_FAILURES 3       // Failed reads in a row before "stale"
+#define PROBE_STALE_MS 30000         // ...or no good read for this long
+
+static_assert(GRAIN_PROBES <= PROBE_MAX, "too many grain probes; raise PROBE_MAX (RAM: see sample_history.h)");
+
+// NaN = not measured (a DS18B20 has no humidity)
+struct ProbeReading {
+  float temp = NAN;
+  float hum = NAN;
+};
+
+// One physical bus. Conversions on a bus start together.
+class ProbeBus {
+ public:
+  virtual ~ProbeBus() {}
+  virtual const char* kind() const = 0;
+  virtual void begin() {}
+  // Start a conversion on every sensor of the bus. Returns the ms until
+  // all results can be read.
+  virtual uint16_t start() = 0;
+  // Fetch sensor `index` of this bus. False on a bus or CRC error.
+  virtual bool read(uint8_t index, ProbeReading& out) = 0;
+};
+
+// One row of the probe table
+struct Probe {
+  const char* name;      // /tasks and the /metrics label
+  uint16_t depthCm;      // Below the grain surface
+  ProbeBus* bus;
+  uint8_t index;         // Sensor on that bus
+};
+
+class ProbeSet {
+ public:
+  ProbeSet(const Probe* probes, uint8_t count) : probes_(probes), count_(count > PROBE_MAX ? PROBE_MAX : count) {
+    for (uint8_t i = 0; i < count_; i++) {
+      uint8_t b = 0;
+      while (b < busCount_ && buses_[b] != probes_[i].bus) b++;
+      if (b == busCount_ && busCount_ < PROBE_MAX_BUSES) buses_[busCount_++] = probes_[i].bus;
+      busOf_[i] = b < busCount_ ? b : 0;
+    }
+  }
+
+  void begin() {
+    for (uint8_t b = 0; b < busCount_; b++) buses_[b]->begin();
+  }
+
+  // Starts a cycle when one is due, then reads at most one probe whose
+  // result is ready. Returns true when a cycle finished.
+  bool poll(uint32_t now) {
+    if (!pending_) {
+      if (cycles && now - cycleStartMs_ < PROBE_CYCLE_MS) return false;
+      cycleStartMs_ = now;
+      uint32_t serial = 0;
+      for (uint8_t b = 0; b < busCount_; b++) {
+        uint16_t ms = buses_[b]->start();
+        readyMs_[b] = now + ms;
+        serial += ms;
+      }
+      sequentialMs = serial;
+      for (uint8_t i = 0; i < count_; i++) pending_ |= 1 << i;
+      return false;
+    }
+
+    for (uint8_t i = 0; i < count_; i++) {
+      if (!(pending_ & (1 << i)) || (int32_t)(now - readyMs_[busOf_[i]]) < 0) continue;
+      pending_ &= ~(1 << i);
+      collect(i, now);
+      break;
+    }
+    if (pending_) return false;
+    lastCycleMs = now - cycleStartMs_;
+    if (lastCycleMs > maxCycleMs) maxCycleMs = lastCycleMs;
+    cycles++;
+    return true;
+  }
+
+  uint8_t count() const { return count_; }
+  const Probe& probe(uint8_t i) const { return probes_[i]; }
+  const ProbeReading& reading(uint8_t i) const { return state_[i].value; }
+
+  bool stale(uint8_t i, uint32_t now) const {
+    const State& s = state_[i];
+    return !s.hasReading || s.consecutiveFailures >= PROBE_STALE_FAILURES ||
+           now - s.lastGoodMs > PROBE_STALE_MS;
+  }
+
+  // Hottest and wettest probe that isn't stale, NaN if none measures it
+  float hottest(uint32_t now) const { return extreme(now, &ProbeReading::temp); }
+  float wettest(uint32_t now) const { return extreme(now, &ProbeReading::hum); }
+
+  uint32_t reads(uint8_t i) const { return state_[i].reads; }
+  uint32_t failures(uint8_t i) const { return state_[i].failures; }
+  uint32_t lastReadUs(uint8_t i) const { return state_[i].lastReadUs; }
+
+  // Stats
+  uint32_t cycles = 0;
+  uint32_t lastCycleMs = 0;   // Start to last read, all buses in parallel
+  uint32_t maxCycleMs = 0;
+  uint32_t sequentialMs = 0;  // Conversion times added up: a cycle one bus after another
+
+ private:
+  struct State {
+    ProbeReading value;
+    uint32_t lastGoodMs = 0;
+    uint32_t reads = 0;
+    uint32_t failures = 0;
+    uint32_t lastReadUs = 0;
+    uint8_t consecutiveFailures = 0;
+    bool hasReading = false;
+  };
+
+  void collect(uint8_t i, uint32_t now) {
+    State& s = state_[i];
+    ProbeReading r;
+    uint32_t started = micros();
+    bool ok = probes_[i].bus->read(probes_[i].index, r);
+    s.lastReadUs = micros() - started;
+    s.reads++;
+    if (!ok || (isnan(r.temp) && isnan(r.hum))) {
+      s.failures++;
+      if (s.consecutiveFailures < 255) s.consecutiveFailures++;
+      return;
+    }
+    s.value = r;
+    s.lastGoodMs = now;
+    s.hasReading = true;
+    s.consecutiveFailures = 0;
+  }
+
+  float extreme(uint32_t now, float ProbeReading::*field) const {
+    float best = NAN;
+    for (uint8_t i = 0; i < count_; i++) {
+      float v = state_[i].value.*field;
+      if (stale(i, now) || isnan(v)) continue;
+      if (isnan(best) || v > best) best = v;
+    }
+    return best;
+  }
+
+  const Probe* probes_;
+  uint8_t count_;
+  ProbeBus* buses_[PROBE_MAX_BUSES] = {};
+  uint8_t busCount_ = 0;
+  uint8_t busOf_[PROBE_MAX] = {};
+  uint32_t readyMs_[PROBE_MAX_BUSES] = {};
+  State state_[PROBE_MAX];
+  uint32_t cycleStartMs_ = 0;
+  uint8_t pending_ = 0;       // Probes still to read this cycle (bit per probe)
+};
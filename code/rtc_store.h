@@ -0,0 +1,58 @@
+#pragma once
+
+// ==========================================
+// RTC USER MEMORY SLOTS
+// ==========================================
+// The ESP8266 keeps 512 bytes of RTC user memory across resets and deep
+// sleep (not across power loss). It is addressed in 4-byte blocks; the
+// first 32 blocks belong to the OTA bootloader. Each slot below holds one
+// struct behind a CRC32, so the random contents after power-up are
+// rejected instead of being trusted. The ESP32 build keeps the same
+// blocks in RTC slow memory (platform.h).
+
+#include <Arduino.h>
+#include "platform.h"
+
+#define RTC_USER_BLOCKS PLATFORM_RTC_BLOCKS
+#define RTC_SLOT_WIFI 32             // WifiCache (wifi_manager.h), 7 blocks
+
+// Plain bitwise CRC32 (IEEE); the structs are tiny
+inline uint32_t rtcCrc(const void* data, size_t len, uint32_t crc = 0) {
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320UL & -(crc & 1));
+  }
+  return ~crc;
+}
+
+template <typename T>
+struct RtcSlot {
+  uint32_t crc;
+  T value;
+};
+
+// layout: for structs whose meaning can change at the same size; a slot
+// saved under another layout is rejected like a bad CRC
+template <typename T>
+bool rtcLoad(uint32_t block, T& out, uint32_t layout = 0) {
+  static_assert(sizeof(T) % 4 == 0, "RTC slots must be a whole number of 4-byte blocks");
+  RtcSlot<T> slot;
+  if (block + sizeof(slot) / 4 > RTC_USER_BLOCKS) return false;
+  if (!platformRtcRead(block, (uint32_t*)&slot, sizeof(slot))) return false;
+  // The size is mixed in so a slot is never mistaken for a different struct
+  if (slot.crc != rtcCrc(&slot.value, sizeof(T), sizeof(T) ^ layout)) return false;
+  out = slot.value;
+  return true;
+}
+
+template <typename T>
+bool rtcSave(uint32_t block, const T& value, uint32_t layout = 0) {
+  static_assert(sizeof(T) % 4 == 0, "RTC slots must be a whole number of 4-byte blocks");
+  RtcSlot<T> slot;
+  if (block + sizeof(slot) / 4 > RTC_USER_BLOCKS) return false;
+  slot.value = value;
+  slot.crc = rtcCrc(&slot.value, sizeof(T), sizeof(T) ^ layout);
+  return platformRtcWrite(block, (const uint32_t*)&slot, sizeof(slot));
+}
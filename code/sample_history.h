@@ -0,0 +1,145 @@
+#pragma once
+
+// ==========================================
+// IN-RAM SAMPLE HISTORY (RING BUFFER)
+// ==========================================
+// One sample every SAMPLE_PERIOD_MS, stored as struct-of-arrays in
+// fixed point so several hours fit in a few KB:
+//   temperature  int16   centi-degrees C
+//   humidity     uint8   half-percent steps (0..200)
+//   gas          uint16  raw MQ-2 ADC value (burst median)
+//   gasFiltered  uint16  filtered MQ-2 value (see gas_channel.h)
+//   motion       4 bits  PIR events during the sample period (saturates at 15)
+// That is 7.5 bytes per sample (~7.7 KB for 1024 samples = 4.3 h).
+// Each grain probe (probe_set.h, GRAIN_PROBES) adds its temperature and
+// humidity in the same units, 3 bytes per sample (3 KB per probe).
+// A missing reading (NaN, e.g. a stale DHT) is stored as HISTORY_TEMP_NONE /
+// HISTORY_HUM_NONE and decoded back to NaN.
+//
+// Every sample gets a sequence number that keeps counting up, so readers
+// (the uploader, /history, analytics) can walk the buffer with their own
+// cursor and detect when old samples have been overwritten. Timestamps are
+// implicit: samples are SAMPLE_PERIOD_MS apart, counted back from the newest.
+
+#include <Arduino.h>
+#include "probe_set.h"               // GRAIN_PROBES
+
+#define SAMPLE_PERIOD_MS 15000       // How often a sample is recorded
+#define HISTORY_CAPACITY 1024        // Samples kept (~4.3 hours at 15 s)
+#define HISTORY_TEMP_NONE INT16_MIN
+#define HISTORY_HUM_NONE 0xFF
+
+struct HistorySample {
+  uint32_t seq;
+  uint32_t ms;     // millis() when captured (derived)
+  float temp;
+  float hum;
+  uint16_t gas;
+  uint16_t gasFiltered;
+  uint8_t motion;  // Motion events in this sample's period
+};
+
+class SampleHistory {
+ public:
+  void push(uint32_t ms, float temp, float hum, int gas, int gasFiltered, uint8_t motionEvents) {
+    uint16_t i = nextSeq_ % HISTORY_CAPACITY;
+    temp_[i] = encodeTemp(temp);
+    hum_[i] = encodeHum(hum);
+    for (int p = 0; p < GRAIN_PROBES; p++) {
+      probeTemp_[i * GRAIN_PROBES + p] = HISTORY_TEMP_NONE;
+      probeHum_[i * GRAIN_PROBES + p] = HISTORY_HUM_NONE;
+    }
+    gas_[i] = (uint16_t)constrain(gas, 0, 65535);
+    gasFiltered_[i] = (uint16_t)constrain(gasFiltered, 0, 65535);
+    uint8_t m = motionEvents > 15 ? 15 : motionEvents;
+    uint8_t shift = (i & 1) * 4;
+    motion_[i >> 1] = (motion_[i >> 1] & ~(0x0F << shift)) | (m << shift);
+    newestMs_ = ms;
+    nextSeq_++;
+  }
+
+  // Grain probe values of the newest sample; probes not recorded stay missing
+  void recordProbe(uint8_t probe, float temp, float hum) {
+    if (!hasProbe(probe) || !nextSeq_) return;
+    uint16_t i = (nextSeq_ - 1) % HISTORY_CAPACITY;
+    probeTemp_[i * GRAIN_PROBES + probe] = encodeTemp(temp);
+    probeHum_[i * GRAIN_PROBES + probe] = encodeHum(hum);
+  }
+
+  uint16_t size() const { return nextSeq_ < HISTORY_CAPACITY ? nextSeq_ : HISTORY_CAPACITY; }
+  bool empty() const { return nextSeq_ == 0; }
+
+  // Sequence numbers currently held: [oldestSeq(), nextSeq())
+  uint32_t nextSeq() const { return nextSeq_; }
+  uint32_t oldestSeq() const { return nextSeq_ - size(); }
+  bool contains(uint32_t seq) const { return seq >= oldestSeq() && seq < nextSeq_; }
+
+  uint32_t msAt(uint32_t seq) const { return newestMs_ - (nextSeq_ - 1 - seq) * SAMPLE_PERIOD_MS; }
+
+  bool get(uint32_t seq, HistorySample& out) const {
+    if (!contains(seq)) return false;
+    uint16_t i = seq % HISTORY_CAPACITY;
+    out.seq = seq;
+    out.ms = msAt(seq);
+    out.temp = temp_[i] == HISTORY_TEMP_NONE ? NAN : temp_[i] / 100.0f;
+    out.hum = hum_[i] == HISTORY_HUM_NONE ? NAN : hum_[i] / 2.0f;
+    out.gas = gas_[i];
+    out.gasFiltered = gasFiltered_[i];
+    out.motion = motionAt(seq);
+    return true;
+  }
+
+  // Raw fixed-point access for encoders and analytics
+  int16_t tempCentiAt(uint32_t seq) const { return temp_[seq % HISTORY_CAPACITY]; }
+  uint8_t humHalfAt(uint32_t seq) const { return hum_[seq % HISTORY_CAPACITY]; }
+  uint16_t gasAt(uint32_t seq) const { return gas_[seq % HISTORY_CAPACITY]; }
+  uint16_t gasFilteredAt(uint32_t seq) const { return gasFiltered_[seq % HISTORY_CAPACITY]; }
+  uint8_t motionAt(uint32_t seq) const {
+    uint16_t i = seq % HISTORY_CAPACITY;
+    return (motion_[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+  }
+  int16_t probeTempCentiAt(uint32_t seq, uint8_t probe) const {
+    return hasProbe(probe) ? probeTemp_[seq % HISTORY_CAPACITY * GRAIN_PROBES + probe] : HISTORY_TEMP_NONE;
+  }
+  uint8_t probeHumHalfAt(uint32_t seq, uint8_t probe) const {
+    return hasProbe(probe) ? probeHum_[seq % HISTORY_CAPACITY * GRAIN_PROBES + probe] : HISTORY_HUM_NONE;
+  }
+
+  // Hottest / wettest grain probe of a sample, NONE if no probe measured it
+  int16_t grainTempCentiMaxAt(uint32_t seq) const {
+    int16_t best = HISTORY_TEMP_NONE;
+    for (int p = 0; p < GRAIN_PROBES; p++) {
+      int16_t v = probeTempCentiAt(seq, p);
+      if (v != HISTORY_TEMP_NONE && (best == HISTORY_TEMP_NONE || v > best)) best = v;
+    }
+    return best;
+  }
+  uint8_t grainHumHalfMaxAt(uint32_t seq) const {
+    uint8_t best = HISTORY_HUM_NONE;
+    for (int p = 0; p < GRAIN_PROBES; p++) {
+      uint8_t v = probeHumHalfAt(seq, p);
+      if (v != HISTORY_HUM_NONE && (best == HISTORY_HUM_NONE || v > best)) best = v;
+    }
+    return best;
+  }
+
+ private:
+  static bool hasProbe(int probe) { return probe < GRAIN_PROBES; }
+
+  static int16_t encodeTemp(float temp) {
+    return isnan(temp) ? HISTORY_TEMP_NONE : (int16_t)constrain(lroundf(temp * 100.0f), -32767L, 32767L);
+  }
+  static uint8_t encodeHum(float hum) {
+    return isnan(hum) ? HISTORY_HUM_NONE : (uint8_t)constrain(lroundf(hum * 2.0f), 0L, 200L);
+  }
+
+  int16_t temp_[HISTORY_CAPACITY];
+  uint8_t hum_[HISTORY_CAPACITY];
+  uint16_t gas_[HISTORY_CAPACITY];
+  uint16_t gasFiltered_[HISTORY_CAPACITY];
+  uint8_t motion_[(HISTORY_CAPACITY + 1) / 2];
+  int16_t probeTemp_[GRAIN_PROBES ? HISTORY_CAPACITY * GRAIN_PROBES : 1];
+  uint8_t probeHum_[GRAIN_PROBES ? HISTORY_CAPACITY * GRAIN_PROBES : 1];
+  uint32_t nextSeq_ = 0;
+  uint32_t newestMs_ = 0;
+};
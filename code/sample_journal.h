@@ -0,0 +1,386 @@
+#pragma once
+
+// ==========================================
+// FLASH SAMPLE JOURNAL (LITTLEFS)
+// ==========================================
+// Every history sample is also appended to an append-only journal on
+// LittleFS, so an outage longer than the RAM history (or a power cycle)
+// no longer loses data:
+//   - records are fixed-size 16-byte binaries, collected in RAM and written
+//     one 256-byte page (JOURNAL_PAGE_RECORDS) at a time, which keeps
+//     flash wear and write latency down,
+//   - the journal is split into segment files of JOURNAL_SEGMENT_RECORDS;
+//     once there are more than JOURNAL_MAX_SEGMENTS, the oldest segment is
+//     deleted,
+//   - a small state file stores the boot counter, the last sample accepted
+//     by ThingSpeak and the read position, so the backlog is found again
+//     after a reboot.
+//
+// Samples are identified by (boot, seq): a boot counter kept in flash plus
+// the history sequence number. Records only store seconds since boot; the
+// wall-clock time of each boot is logged once NTP has synced, and old
+// records are sent to ThingSpeak with absolute timestamps. Records from a
+// boot that never got the time can't be placed and are skipped.
+//
+// The unflushed page (up to 4 minutes of samples) is lost on power failure;
+// the RAM history still holds it as long as the power stays on.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <time.h>
+#include "platform.h"
+#include "sample_history.h"
+
+#define JOURNAL_DIR "/journal"
+#define JOURNAL_PAGE_RECORDS 16       // 16 x 16 B = one 256-byte flash page per write
+#define JOURNAL_SEGMENT_RECORDS 512   // 8 KB per segment file (~2 h at 15 s)
+#define JOURNAL_MAX_SEGMENTS 64       // ~512 KB of flash, ~5.7 days at 15 s
+#define JOURNAL_SCAN_MAX 128          // Records read per readBacklog() call
+#define JOURNAL_EPOCH_MIN 1600000000UL // time() above this means NTP has synced
+
+struct JournalRecord {
+  uint32_t seq;      // History sequence number within its boot
+  uint32_t timeS;    // Seconds since boot when captured
+  uint16_t boot;     // Boot counter
+  int16_t temp;      // centi-degrees C, HISTORY_TEMP_NONE if missing
+  uint32_t packed;   // gas:10 | gasFiltered:10 | hum:8 | motion:4
+
+  uint16_t gas() const { return packed & 0x3FF; }
+  uint16_t gasFiltered() const { return (packed >> 10) & 0x3FF; }
+  uint8_t hum() const { return (packed >> 20) & 0xFF; }  // Half-%, HISTORY_HUM_NONE if missing
+  uint8_t motion() const { return packed >> 28; }
+};
+static_assert(sizeof(JournalRecord) == 16, "journal records must stay 16 bytes");
+
+class SampleJournal {
+ public:
+  enum Backlog {
+    BACKLOG_NONE,        // Everything older than the RAM history has been sent
+    BACKLOG_READY,       // Records returned
+    BACKLOG_SCANNING,    // Still skipping sent records; call again
+    BACKLOG_NEED_CLOCK,  // Current-boot records wait for NTP
+  };
+
+  // Mount LittleFS, find the segments and bump the boot counter.
+  bool begin() {
+    if (!LittleFS.begin()) {
+      Serial.println("Journal: LittleFS mount failed, journal disabled");
+      return false;
+    }
+    LittleFS.mkdir(JOURNAL_DIR);
+
+    uint32_t first = UINT32_MAX, last = 0, lastSize = 0;
+    auto found = [&](const char* name, uint32_t size) {
+      char* end;
+      uint32_t seg = strtoul(name, &end, 16);
+      if (strcmp(end, ".bin") != 0) return;
+      if (seg < first) first = seg;
+      if (seg >= last) {
+        last = seg;
+        lastSize = size;
+      }
+    };
+#if SILO_DUAL_CORE
+    File dir = LittleFS.open(JOURNAL_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) found(f.name(), f.size());
+#else
+    Dir dir = LittleFS.openDir(JOURNAL_DIR);
+    while (dir.next()) found(dir.fileName().c_str(), dir.fileSize());
+#endif
+    if (first == UINT32_MAX) {
+      first = last = 1;
+    }
+    firstSeg_ = first;
+    lastSeg_ = last;
+    lastCount_ = lastSize / sizeof(JournalRecord);
+    // A torn last record would misalign every later append
+    if (lastSize % sizeof(JournalRecord)) lastCount_ = JOURNAL_SEGMENT_RECORDS;
+
+    State st;
+    File f = LittleFS.open(JOURNAL_DIR "/state", "r");
+    if (f && f.read((uint8_t*)&st, sizeof(st)) == sizeof(st) && st.magic == kMagic) {
+      boot_ = st.boot + 1;
+      sentBoot_ = st.sentBoot;
+      sentSeq_ = st.sentSeq;
+      readSeg_ = st.readSeg;
+      readIdx_ = st.readIdx;
+    }
+    if (f) f.close();
+    if (boot_ == 0) boot_ = 1;
+    if (readSeg_ < firstSeg_ || readSeg_ > lastSeg_) {
+      readSeg_ = firstSeg_;
+      readIdx_ = 0;
+    }
+    ready_ = true;
+    saveState();
+    Serial.printf("Journal: boot %u, segments %u..%u\n",
+                  (unsigned)boot_, (unsigned)firstSeg_, (unsigned)lastSeg_);
+    return true;
+  }
+
+  bool ready() const { return ready_; }
+  uint16_t boot() const { return boot_; }
+
+  // Log the wall-clock time of this boot once NTP has synced.
+  void poll() {
+    if (!ready_ || bootEpoch_) return;
+    time_t now = time(nullptr);
+    if (now < (time_t)JOURNAL_EPOCH_MIN) return;
+    bootEpoch_ = (uint32_t)now - millis() / 1000;
+    EpochEntry e = { boot_, 0, bootEpoch_ };
+    File f = LittleFS.open(JOURNAL_DIR "/epochs", "a");
+    if (f) {
+      f.write((const uint8_t*)&e, sizeof(e));
+      f.close();
+    }
+  }
+
+  // Journal the history sample `seq`, captured at millis() `ms`.
+  void append(const SampleHistory& history, uint32_t seq, uint32_t ms) {
+    if (!ready_) return;
+    JournalRecord& r = page_[pageCount_++];
+    r.seq = seq;
+    r.timeS = ms / 1000;
+    r.boot = boot_;
+    r.temp = history.tempCentiAt(seq);
+    uint32_t gas = history.gasAt(seq) > 1023 ? 1023 : history.gasAt(seq);
+    uint32_t filtered = history.gasFilteredAt(seq) > 1023 ? 1023 : history.gasFilteredAt(seq);
+    r.packed = gas | filtered << 10 | (uint32_t)history.humHalfAt(seq) << 20 |
+               (uint32_t)history.motionAt(seq) << 28;
+    records++;
+    if (pageCount_ == JOURNAL_PAGE_RECORDS) flush();
+  }
+
+  // Write the RAM page out (normally called by append() when it's full).
+  void flush() {
+    if (!ready_ || pageCount_ == 0) return;
+    uint8_t done = 0;
+    while (done < pageCount_) {
+      if (lastCount_ >= JOURNAL_SEGMENT_RECORDS) rotate();
+      uint16_t room = JOURNAL_SEGMENT_RECORDS - lastCount_;
+      uint8_t n = pageCount_ - done < room ? pageCount_ - done : room;
+      char path[32];
+      File f = LittleFS.open(segmentPath(path, lastSeg_), "a");
+      size_t want = n * sizeof(JournalRecord);
+      size_t wrote = f ? f.write((const uint8_t*)&page_[done], want) : 0;
+      if (f) f.close();
+      if (wrote != want) {
+        writeErrors++;
+        lastCount_ = JOURNAL_SEGMENT_RECORDS; // Continue in a fresh segment
+        break;
+      }
+      lastCount_ += n;
+      done += n;
+    }
+    if (done == pageCount_) {
+      flushedBoot_ = boot_;
+      flushedSeq_ = page_[pageCount_ - 1].seq;
+      pagesWritten++;
+    }
+    pageCount_ = 0; // On a write error the RAM history still has them
+    saveState();
+  }
+
+  // ---- Upload bookkeeping ----
+
+  // ThingSpeak accepted this boot's samples up to `seq` (from the history).
+  void markSent(uint32_t seq) {
+    sentBoot_ = boot_;
+    sentSeq_ = seq;
+    // Everything on flash is sent: skip the read position to the end
+    if (flushedBoot_ == boot_ && flushedSeq_ <= seq) {
+      readSeg_ = lastSeg_;
+      readIdx_ = lastCount_;
+    }
+  }
+
+  // First history sample of this boot that ThingSpeak doesn't have yet
+  uint32_t nextUnsentSeq() const { return sentBoot_ == boot_ ? sentSeq_ + 1 : 0; }
+
+  // Collect up to `max` unsent records that the RAM history can no longer
+  // supply (older boots, or this boot before `firstLiveSeq`). The records
+  // stay unsent until consumeBacklog().
+  Backlog readBacklog(JournalRecord* out, uint8_t max, uint32_t firstLiveSeq, uint8_t& n) {
+    n = 0;
+    if (!ready_) return BACKLOG_NONE;
+    Backlog result = BACKLOG_NONE;
+    uint32_t seg = readSeg_, idx = readIdx_, count = 0;
+    uint16_t scanned = 0;
+    File f;
+    bool opened = false;
+
+    while (n < max) {
+      if (scanned >= JOURNAL_SCAN_MAX) {
+        result = BACKLOG_SCANNING;
+        break;
+      }
+      if (!opened) {
+        char path[32];
+        f = LittleFS.open(segmentPath(path, seg), "r");
+        count = f ? f.size() / sizeof(JournalRecord) : 0;
+        if (f) f.seek(idx * sizeof(JournalRecord), SeekSet);
+        opened = true;
+      }
+      if (idx >= count) {
+        if (seg >= lastSeg_) break;
+        if (f) f.close();
+        opened = false;
+        seg++;
+        idx = 0;
+        if (n == 0) setReadPos(seg, idx);
+        continue;
+      }
+      JournalRecord r;
+      if (f.read((uint8_t*)&r, sizeof(r)) != sizeof(r)) {
+        readErrors++;
+        break;
+      }
+      scanned++;
+      if (isSent(r)) {
+        idx++;
+        if (n == 0) setReadPos(seg, idx);
+        continue;
+      }
+      if (r.boot == boot_ && r.seq >= firstLiveSeq) break; // The history has the rest
+      uint32_t epoch;
+      if (!epochOf(r.boot, epoch)) {
+        if (r.boot == boot_) {
+          result = BACKLOG_NEED_CLOCK;
+          break;
+        }
+        if (n) break;
+        unplaceable++; // Old boot that never learned the time
+        idx++;
+        setReadPos(seg, idx);
+        continue;
+      }
+      out[n++] = r;
+      idx++;
+    }
+    if (f) f.close();
+    if (n) {
+      batchSeg_ = seg;
+      batchIdx_ = idx;
+      batchBoot_ = out[n - 1].boot;
+      batchSeq_ = out[n - 1].seq;
+      return BACKLOG_READY;
+    }
+    return result;
+  }
+
+  // The records from the last readBacklog() were accepted.
+  void consumeBacklog() {
+    setReadPos(batchSeg_, batchIdx_);
+    sentBoot_ = batchBoot_;
+    sentSeq_ = batchSeq_;
+    saveState();
+  }
+
+  // Wall-clock time of a boot, once known
+  bool epochOf(uint16_t boot, uint32_t& epoch) {
+    if (boot == boot_) {
+      epoch = bootEpoch_;
+      return bootEpoch_ != 0;
+    }
+    if (boot != cacheBoot_) {
+      cacheBoot_ = boot;
+      cacheEpoch_ = 0;
+      File f = LittleFS.open(JOURNAL_DIR "/epochs", "r");
+      EpochEntry e;
+      while (f && f.read((uint8_t*)&e, sizeof(e)) == sizeof(e)) {
+        if (e.boot == boot) cacheEpoch_ = e.epoch;
+      }
+      if (f) f.close();
+    }
+    epoch = cacheEpoch_;
+    return cacheEpoch_ != 0;
+  }
+
+  uint32_t segments() const { return lastSeg_ - firstSeg_ + 1; }
+
+  // Stats
+  uint32_t records = 0;       // Appended this boot
+  uint32_t pagesWritten = 0;
+  uint32_t writeErrors = 0;
+  uint32_t readErrors = 0;
+  uint32_t rotatedUnsent = 0; // Records deleted by rotation before upload
+  uint32_t unplaceable = 0;   // Old records skipped for lack of a timestamp
+
+ private:
+  static constexpr uint32_t kMagic = 0x314A5353; // "SSJ1"
+
+  struct State {
+    uint32_t magic;
+    uint16_t boot;
+    uint16_t sentBoot;
+    uint32_t sentSeq;
+    uint32_t readSeg;
+    uint32_t readIdx;
+  };
+
+  struct EpochEntry {
+    uint16_t boot;
+    uint16_t reserved;
+    uint32_t epoch;
+  };
+
+  static const char* segmentPath(char* buf, uint32_t seg) {
+    snprintf(buf, 32, JOURNAL_DIR "/%08x.bin", (unsigned)seg);
+    return buf;
+  }
+
+  bool isSent(const JournalRecord& r) const {
+    return r.boot < sentBoot_ || (r.boot == sentBoot_ && r.seq <= sentSeq_);
+  }
+
+  void setReadPos(uint32_t seg, uint32_t idx) {
+    readSeg_ = seg;
+    readIdx_ = idx;
+  }
+
+  // Start a new segment and delete the oldest ones beyond the limit
+  void rotate() {
+    lastSeg_++;
+    lastCount_ = 0;
+    while (lastSeg_ - firstSeg_ + 1 > JOURNAL_MAX_SEGMENTS) {
+      char path[32];
+      LittleFS.remove(segmentPath(path, firstSeg_));
+      if (readSeg_ == firstSeg_) {
+        rotatedUnsent += JOURNAL_SEGMENT_RECORDS > readIdx_ ? JOURNAL_SEGMENT_RECORDS - readIdx_ : 0;
+        setReadPos(firstSeg_ + 1, 0);
+      }
+      firstSeg_++;
+    }
+  }
+
+  void saveState() {
+    State st = { kMagic, boot_, sentBoot_, sentSeq_, readSeg_, readIdx_ };
+    File f = LittleFS.open(JOURNAL_DIR "/state", "w");
+    if (!f) return;
+    f.write((const uint8_t*)&st, sizeof(st));
+    f.close();
+  }
+
+  bool ready_ = false;
+  uint16_t boot_ = 0;
+  uint32_t bootEpoch_ = 0;
+
+  JournalRecord page_[JOURNAL_PAGE_RECORDS];
+  uint8_t pageCount_ = 0;
+
+  uint32_t firstSeg_ = 1, lastSeg_ = 1;
+  uint32_t lastCount_ = 0;     // Records in the last segment
+  uint16_t flushedBoot_ = 0;   // Newest record on flash
+  uint32_t flushedSeq_ = 0;
+
+  uint16_t sentBoot_ = 0;      // Newest sample ThingSpeak has
+  uint32_t sentSeq_ = 0;
+  uint32_t readSeg_ = 1, readIdx_ = 0; // Everything before this is handled
+
+  uint32_t batchSeg_ = 0, batchIdx_ = 0; // End of the last readBacklog() batch
+  uint16_t batchBoot_ = 0;
+  uint32_t batchSeq_ = 0;
+
+  uint16_t cacheBoot_ = 0;
+  uint32_t cacheEpoch_ = 0;
+};
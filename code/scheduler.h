@@ -0,0 +1,90 @@
+#pragma once
+
+// ==========================================
+// COOPERATIVE TASK SCHEDULER
+// ==========================================
+// Each subsystem is a short, non-blocking function with its own period and
+// deadline (how late it may start before it counts as an overrun). Every
+// call to runNext() starts the due task with the earliest deadline, so the
+// gas and alarm paths never queue behind slow housekeeping. When nothing is
+// due the caller may yield. Per-task stats record how often each task ran,
+// how late it started, and how long it took.
+
+#include <Arduino.h>
+
+struct Task {
+  const char* name;
+  uint32_t periodMs;
+  uint32_t deadlineMs;
+  void (*run)();
+
+  // Runtime stats (filled in by the scheduler)
+  uint32_t nextRunMs = 0;
+  uint32_t runs = 0;
+  uint32_t overruns = 0;   // Started later than deadlineMs after it was due
+  uint32_t maxLateMs = 0;
+  uint32_t lastRunUs = 0;
+  uint32_t maxRunUs = 0;
+};
+
+class Scheduler {
+ public:
+  Scheduler(Task* tasks, uint8_t count) : tasks_(tasks), count_(count) {}
+
+  void begin() {
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < count_; i++) tasks_[i].nextRunMs = now;
+  }
+
+  // Run the most urgent due task. Returns false if nothing was due.
+  bool runNext() {
+    uint32_t now = millis();
+    Task* pick = nullptr;
+    int32_t pickSlack = 0;
+
+    for (uint8_t i = 0; i < count_; i++) {
+      Task& t = tasks_[i];
+      if ((int32_t)(now - t.nextRunMs) < 0) continue;
+      // Time left before this task blows its deadline
+      int32_t slack = (int32_t)(t.nextRunMs + t.deadlineMs - now);
+      if (!pick || slack < pickSlack) {
+        pick = &t;
+        pickSlack = slack;
+      }
+    }
+    if (!pick) return false;
+
+    uint32_t late = now - pick->nextRunMs;
+    if (late > pick->maxLateMs) pick->maxLateMs = late;
+    if (late > pick->deadlineMs) pick->overruns++;
+
+    uint32_t start = micros();
+    pick->run();
+    pick->lastRunUs = micros() - start;
+    if (pick->lastRunUs > pick->maxRunUs) pick->maxRunUs = pick->lastRunUs;
+    pick->runs++;
+
+    // Fixed rate, but don't try to catch up on missed periods in a burst
+    pick->nextRunMs += pick->periodMs;
+    if ((int32_t)(millis() - pick->nextRunMs) > 0) pick->nextRunMs = millis() + pick->periodMs;
+    return true;
+  }
+
+  // Milliseconds until the next task is due (0 if one is due now)
+  uint32_t idleMs() const {
+    uint32_t now = millis();
+    int32_t soonest = INT32_MAX;
+    for (uint8_t i = 0; i < count_; i++) {
+      int32_t wait = (int32_t)(tasks_[i].nextRunMs - now);
+      if (wait < soonest) soonest = wait;
+    }
+    return soonest > 0 ? soonest : 0;
+  }
+
+  uint8_t count() const { return count_; }
+  const Task& task(uint8_t i) const { return tasks_[i]; }
+
+ private:
+  Task* tasks_;
+  uint8_t count_;
+};
@@ -0,0 +1,484 @@
+#pragma once
+
+// ==========================================
+// ESP-NOW SILO GATEWAY
+// ==========================================
+// The gateway is a normal, WiFi-connected silo monitor that also listens for
+// SiloFrames from the nodes (espnow_link.h). For each node it keeps:
+//   - sequence accounting: frames received, lost (gaps), duplicates
+//     (retransmits whose ACK got lost) and reboots,
+//   - a one-minute aggregate (mean climate, peak gas, motion total, fan
+//     share, worst alert), queued as one ThingSpeak entry per node per
+//     GATEWAY_WINDOW_MS. All nodes share one "site" channel and go out in
+//     bulk_update requests, so a dozen silos cost one request a minute
+//     instead of a dozen every 15 seconds,
+//   - alert dedup: the same alert from the same node is repeated at most
+//     once per GATEWAY_ALERT_COOLDOWN_MS, and the same alert from several
+//     nodes within GATEWAY_COALESCE_MS becomes one Telegram message,
+//   - liveness: a node silent for GATEWAY_OFFLINE_MS raises an alert.
+//
+// Frames arrive in an SDK callback outside loop(). The callback only copies
+// them into a single-producer/single-consumer ring, the same scheme as the
+// PIR edge queue; poll() does the rest.
+//
+// Site channel fields: 1 temperature (mean), 2 humidity (mean), 3 raw gas
+// (peak), 4 motion events, 5 filtered gas (mean), 6 fan on share (%),
+// 7 node ID, 8 worst alert code (SiloAlert).
+
+#include "espnow_link.h"
+#include "http_response.h"
+#include "telegram_notifier.h"
+#include "thingspeak_uploader.h" // THINGSPEAK_HOST
+
+// ESP-NOW here is the ESP8266 SDK's, like on the node side
+#if !SILO_DUAL_CORE
+#include <espnow.h>
+
+#define GATEWAY_MAX_NODES 48
+#define GATEWAY_RX_QUEUE 32          // Frames buffered between callback and poll()
+#define GATEWAY_WINDOW_MS 60000      // One site entry per node per window
+#define GATEWAY_QUEUE_LEN 192        // Entries waiting for upload (4 windows of 48 nodes)
+#define GATEWAY_BATCH_MAX 96         // Entries per bulk_update request
+#define GATEWAY_COALESCE_MS 2000     // Same alert from several silos -> one message
+#define GATEWAY_ALERT_COOLDOWN_MS 60000 // Per node and alert code
+#define GATEWAY_OFFLINE_MS 60000     // Silent this long (4 samples) = offline
+#define GATEWAY_TIMEOUT_MS 5000
+#define GATEWAY_BACKOFF_MIN_MS 15000 // ThingSpeak allows one bulk update per 15 s
+#define GATEWAY_BACKOFF_MAX_MS 300000
+#define SITE_ENTRY_MAX 192           // One formatted site entry
+
+static_assert(GATEWAY_MAX_NODES <= 64, "alert coalescing uses a 64-bit node mask");
+
+struct SiloNodeState {
+  uint8_t id = 0;              // 0 = free slot
+  uint8_t mac[6] = {};
+  bool offline = false;
+  uint16_t lastSeq = 0;
+  uint32_t frames = 0;         // Accepted frames
+  uint32_t lost = 0;           // Sequence gaps
+  uint32_t duplicates = 0;     // Repeated or out-of-date sequence numbers
+  uint32_t reboots = 0;
+  uint32_t lastSeenMs = 0;
+  SiloFrame latest = {};
+
+  uint8_t lastAlert = SILO_ALERT_NONE;
+  uint32_t lastAlertMs = 0;
+
+  // Current window
+  int32_t tempSum = 0;         // centi-C
+  uint16_t humSum = 0;         // half-%
+  uint8_t climateCount = 0;
+  uint8_t samples = 0;
+  uint16_t gasPeak = 0;
+  uint32_t gasFilteredSum = 0;
+  uint8_t motion = 0;
+  uint8_t fanSamples = 0;
+  uint8_t worstAlert = SILO_ALERT_NONE;
+
+  // Frames that should have arrived, for a loss percentage
+  uint32_t expected() const { return frames + lost; }
+};
+
+class SiloGateway {
+ public:
+  // alertText[code] is the Telegram text for each SiloAlert ("" = silent)
+  SiloGateway(TelegramNotifier& telegram, const char* const* alertText,
+              const char* channelId, const char* writeKey)
+    : telegram_(telegram), alertText_(alertText), channelId_(channelId), writeKey_(writeKey) {}
+
+  // After the WiFi manager has put the radio in STA mode
+  void begin() {
+    instance_ = this;
+    // Modem sleep would miss frames between beacons
+    WiFi.setSleepMode(WIFI_NONE_SLEEP);
+    ready_ = esp_now_init() == 0;
+    if (!ready_) {
+      Serial.println("ESP-NOW init failed");
+      return;
+    }
+    esp_now_set_self_role(ESP_NOW_ROLE_SLAVE);
+    esp_now_register_recv_cb(onReceive);
+    windowStartMs_ = millis();
+    Serial.print("ESP-NOW gateway MAC: ");
+    Serial.println(WiFi.macAddress());
+  }
+
+  void poll() {
+    if (!ready_) return;
+    uint32_t now = millis();
+
+    while (rxTail_ != rxHead_) {
+      const volatile RxFrame& slot = rx_[rxTail_ % GATEWAY_RX_QUEUE];
+      RxFrame f;
+      memcpy(&f, (const void*)&slot, sizeof(f));
+      rxTail_ = rxTail_ + 1;
+      handleFrame(f, now);
+    }
+
+    if (now - windowStartMs_ >= GATEWAY_WINDOW_MS) {
+      windowStartMs_ += GATEWAY_WINDOW_MS;
+      closeWindow(now);
+    }
+    checkLiveness(now);
+    flushAlerts(now);
+    pollUpload(now);
+  }
+
+  uint8_t nodeCount() const { return nodeCount_; }
+  const SiloNodeState& node(uint8_t i) const { return nodes_[i]; }
+  uint16_t queued() const { return queueCount_; }
+
+  // Stats
+  uint32_t frames = 0;         // Valid frames received
+  uint32_t badFrames = 0;      // Wrong size, magic or version
+  volatile uint32_t rxOverflows = 0; // Frames lost because poll() fell behind
+  uint32_t rejected = 0;       // Frames from nodes beyond GATEWAY_MAX_NODES
+  uint32_t entriesDropped = 0; // Site entries lost to a full upload queue
+  uint32_t uploaded = 0;       // Site entries accepted by ThingSpeak
+  uint32_t posts = 0;
+  uint32_t failures = 0;
+  uint32_t alertsSent = 0;     // Telegram messages queued for nodes
+  uint32_t alertsMerged = 0;   // Node alerts folded into another message
+
+ private:
+  struct RxFrame {
+    uint8_t mac[6];
+    SiloFrame frame;
+  };
+
+  struct SiteEntry {
+    uint32_t ms;           // Window end
+    int16_t temp;          // centi-C mean, HISTORY_TEMP_NONE if none
+    uint16_t gas;          // Peak raw
+    uint16_t gasFiltered;  // Mean
+    uint8_t node;
+    uint8_t hum;           // half-% mean, HISTORY_HUM_NONE if none
+    uint8_t motion;
+    uint8_t fanPct;
+    uint8_t alert;
+    uint8_t samples;
+  };
+
+  struct PendingAlert {
+    uint64_t nodes = 0;    // Bit per node slot
+    uint32_t sinceMs = 0;
+  };
+
+  enum State { IDLE, CONNECT, SEND, READ_RESPONSE, BACKOFF };
+
+  // SDK callback: validate and copy, nothing else
+  static void onReceive(uint8_t* mac, uint8_t* data, uint8_t len) {
+    SiloGateway* self = instance_;
+    const SiloFrame* f = (const SiloFrame*)data;
+    if (len != sizeof(SiloFrame) || f->magic != SILO_FRAME_MAGIC ||
+        f->version != SILO_FRAME_VERSION || f->node == 0) {
+      self->badFrames++;
+      return;
+    }
+    uint32_t head = self->rxHead_;
+    if (head - self->rxTail_ >= GATEWAY_RX_QUEUE) {
+      self->rxOverflows = self->rxOverflows + 1;
+      return;
+    }
+    volatile RxFrame& slot = self->rx_[head % GATEWAY_RX_QUEUE];
+    memcpy((void*)slot.mac, mac, 6);
+    memcpy((void*)&slot.frame, data, sizeof(SiloFrame));
+    self->rxHead_ = head + 1;
+  }
+
+  int8_t findNode(uint8_t id) {
+    for (uint8_t i = 0; i < nodeCount_; i++)
+      if (nodes_[i].id == id) return i;
+    if (nodeCount_ == GATEWAY_MAX_NODES) return -1;
+    nodes_[nodeCount_].id = id;
+    Serial.printf("ESP-NOW: new silo node %u\n", (unsigned)id);
+    return nodeCount_++;
+  }
+
+  void handleFrame(const RxFrame& rx, uint32_t now) {
+    const SiloFrame& f = rx.frame;
+    int8_t idx = findNode(f.node);
+    if (idx < 0) {
+      rejected++;
+      return;
+    }
+    SiloNodeState& n = nodes_[idx];
+
+    bool known = n.frames > 0;
+    uint16_t gap = f.seq - n.lastSeq;
+    if (f.flags & SILO_FLAG_BOOT) {
+      if (known) n.reboots++;
+    } else if (known) {
+      if (gap == 0 || gap >= 0x8000) {
+        n.duplicates++;
+        return;
+      }
+      n.lost += gap - 1;
+    }
+    n.lastSeq = f.seq;
+    n.frames++;
+    frames++;
+    n.lastSeenMs = now;
+    n.latest = f;
+    memcpy(n.mac, rx.mac, sizeof(n.mac));
+    if (n.offline) {
+      n.offline = false;
+      Serial.printf("ESP-NOW: silo node %u back online\n", (unsigned)n.id);
+    }
+
+    // Alert frames repeat the current readings; count each sample once
+    if (!(f.flags & SILO_FLAG_ALERT)) {
+      if (n.samples < 255) n.samples++;
+      if (f.temp != HISTORY_TEMP_NONE && f.hum != HISTORY_HUM_NONE && n.climateCount < 255) {
+        n.tempSum += f.temp;
+        n.humSum += f.hum;
+        n.climateCount++;
+      }
+      if (f.gas > n.gasPeak) n.gasPeak = f.gas;
+      n.gasFilteredSum += f.gasFiltered;
+      n.motion = n.motion + f.motion > 255 ? 255 : n.motion + f.motion;
+      if (f.flags & SILO_FLAG_FAN) n.fanSamples++;
+    }
+    // Lower codes are more urgent
+    if (f.alert != SILO_ALERT_NONE && (n.worstAlert == SILO_ALERT_NONE || f.alert < n.worstAlert))
+      n.worstAlert = f.alert;
+    if (f.alert != SILO_ALERT_NONE && f.alert < SILO_ALERT_COUNT) raise(idx, f.alert, now);
+  }
+
+  void raise(uint8_t idx, uint8_t code, uint32_t now) {
+    SiloNodeState& n = nodes_[idx];
+    if (!alertText_[code][0]) return;
+    if (n.lastAlert == code && n.lastAlertMs && now - n.lastAlertMs < GATEWAY_ALERT_COOLDOWN_MS) return;
+    n.lastAlert = code;
+    n.lastAlertMs = now;
+    PendingAlert& p = pending_[code];
+    if (p.nodes) alertsMerged++;
+    else p.sinceMs = now;
+    p.nodes |= 1ULL << idx;
+  }
+
+  // "<text> (silos 3, 7, +2 more)", cut at a whole node ID
+  void flushAlerts(uint32_t now) {
+    for (uint8_t code = 1; code < SILO_ALERT_COUNT; code++) {
+      PendingAlert& p = pending_[code];
+      if (!p.nodes || now - p.sinceMs < GATEWAY_COALESCE_MS) continue;
+      char msg[TELEGRAM_MSG_MAX];
+      uint8_t total = 0;
+      for (uint8_t i = 0; i < nodeCount_; i++) total += (p.nodes >> i) & 1;
+      int len = snprintf(msg, sizeof(msg), "%s (silo%s", alertText_[code], total > 1 ? "s" : "");
+      uint8_t listed = 0;
+      for (uint8_t i = 0; i < nodeCount_ && len < (int)sizeof(msg); i++) {
+        if (!((p.nodes >> i) & 1)) continue;
+        char id[8];
+        int n = snprintf(id, sizeof(id), "%s %u", listed ? "," : "", (unsigned)nodes_[i].id);
+        // Leave room for ", +NN more)"
+        if (len + n + 12 >= (int)sizeof(msg)) break;
+        memcpy(msg + len, id, n + 1);
+        len += n;
+        listed++;
+      }
+      if (listed < total) len += snprintf(msg + len, sizeof(msg) - len, ", +%u more", (unsigned)(total - listed));
+      snprintf(msg + len, sizeof(msg) - len, ")");
+      telegram_.enqueue(msg);
+      alertsSent++;
+      p.nodes = 0;
+    }
+  }
+
+  void checkLiveness(uint32_t now) {
+    for (uint8_t i = 0; i < nodeCount_; i++) {
+      SiloNodeState& n = nodes_[i];
+      if (n.offline || !n.frames || now - n.lastSeenMs < GATEWAY_OFFLINE_MS) continue;
+      n.offline = true;
+      Serial.printf("ESP-NOW: silo node %u offline\n", (unsigned)n.id);
+      raise(i, SILO_ALERT_OFFLINE, now);
+    }
+  }
+
+  void closeWindow(uint32_t now) {
+    for (uint8_t i = 0; i < nodeCount_; i++) {
+      SiloNodeState& n = nodes_[i];
+      if (!n.samples) continue;
+      if (queueCount_ == GATEWAY_QUEUE_LEN) {
+        // Keep the newest data; never touch entries that are on the wire
+        if (inFlight_ >= queueCount_) {
+          entriesDropped++;
+        } else {
+          for (uint16_t k = inFlight_; k + 1 < queueCount_; k++)
+            queue_[(queueHead_ + k) % GATEWAY_QUEUE_LEN] = queue_[(queueHead_ + k + 1) % GATEWAY_QUEUE_LEN];
+          queueCount_--;
+          entriesDropped++;
+        }
+      }
+      if (queueCount_ < GATEWAY_QUEUE_LEN) {
+        SiteEntry& e = queue_[(queueHead_ + queueCount_++) % GATEWAY_QUEUE_LEN];
+        e.ms = now;
+        e.node = n.id;
+        e.temp = n.climateCount ? (int16_t)(n.tempSum / n.climateCount) : HISTORY_TEMP_NONE;
+        e.hum = n.climateCount ? (uint8_t)(n.humSum / n.climateCount) : HISTORY_HUM_NONE;
+        e.gas = n.gasPeak;
+        e.gasFiltered = (uint16_t)(n.gasFilteredSum / n.samples);
+        e.motion = n.motion;
+        e.fanPct = (uint8_t)(n.fanSamples * 100 / n.samples);
+        e.alert = n.worstAlert;
+        e.samples = n.samples;
+      }
+      n.tempSum = n.humSum = n.climateCount = n.samples = 0;
+      n.gasPeak = n.motion = n.fanSamples = 0;
+      n.gasFilteredSum = 0;
+      n.worstAlert = SILO_ALERT_NONE;
+    }
+  }
+
+  // ---- Site channel uploads (same request shape as ThingSpeakUploader) ----
+
+  void pollUpload(uint32_t now) {
+    switch (state_) {
+      case BACKOFF:
+        if ((int32_t)(now - retryAt_) < 0) return;
+        state_ = IDLE;
+        // fall through
+      case IDLE:
+        if (!queueCount_ || WiFi.status() != WL_CONNECTED) return;
+        inFlight_ = queueCount_ < GATEWAY_BATCH_MAX ? queueCount_ : GATEWAY_BATCH_MAX;
+        state_ = client_.connected() ? SEND : CONNECT;
+        return;
+
+      case CONNECT:
+        client_.setTimeout(GATEWAY_TIMEOUT_MS);
+        if (!client_.connect(THINGSPEAK_HOST, 80)) {
+          fail("connect");
+          return;
+        }
+        state_ = SEND;
+        return;
+
+      case SEND:
+        writeRequest();
+        response_.begin(GATEWAY_TIMEOUT_MS);
+        state_ = READ_RESPONSE;
+        return;
+
+      case READ_RESPONSE:
+        switch (response_.poll(client_)) {
+          case HttpResponseReader::PENDING: return;
+          case HttpResponseReader::DONE: finish(); return;
+          case HttpResponseReader::FAILED: fail("no response"); return;
+        }
+        return;
+    }
+  }
+
+  const SiteEntry& entry(uint16_t i) const { return queue_[(queueHead_ + i) % GATEWAY_QUEUE_LEN]; }
+
+  int formatEntry(char* buf, size_t cap, uint16_t i) {
+    const SiteEntry& e = entry(i);
+    uint32_t prevMs = i == 0 ? lastSentMs_ : entry(i - 1).ms;
+    uint32_t deltaS = prevMs ? (e.ms - prevMs) / 1000 : 0;
+    int n = snprintf(buf, cap, "%s{\"delta_t\":%u", i ? "," : "", (unsigned)deltaS);
+    if (e.temp != HISTORY_TEMP_NONE) n += snprintf(buf + n, cap - n, ",\"field1\":%.2f", e.temp / 100.0f);
+    if (e.hum != HISTORY_HUM_NONE) n += snprintf(buf + n, cap - n, ",\"field2\":%.1f", e.hum / 2.0f);
+    n += snprintf(buf + n, cap - n,
+                  ",\"field3\":%u,\"field4\":%u,\"field5\":%u,\"field6\":%u,\"field7\":%u,\"field8\":%u}",
+                  e.gas, e.motion, e.gasFiltered, e.fanPct, e.node, e.alert);
+    return n;
+  }
+
+  // As in ThingSpeakUploader: sized with a ByteCounter pass, then sent
+  void writeRequest() {
+    ByteCounter body;
+    {
+      NetWriter<ByteCounter> sizing(body);
+      writeBody(sizing);
+    }
+    NetWriter<WiFiClient> w(client_);
+    w.textP(PSTR("POST /channels/"));
+    w.text(channelId_);
+    w.textP(PSTR("/bulk_update.json HTTP/1.1\r\n"
+                 "Host: " THINGSPEAK_HOST "\r\n"
+                 "Connection: keep-alive\r\n"
+                 "Content-Type: application/json\r\n"
+                 "Content-Length: "));
+    w.number(body.bytes);
+    w.textP(PSTR("\r\n\r\n"));
+    writeBody(w);
+  }
+
+  template <typename Writer>
+  void writeBody(Writer& w) {
+    w.textP(PSTR("{\"write_api_key\":\""));
+    w.text(writeKey_);
+    w.textP(PSTR("\",\"updates\":["));
+    for (uint16_t i = 0; i < inFlight_; i++) {
+      char* entry = w.reserve(SITE_ENTRY_MAX);
+      w.commit(formatEntry(entry, SITE_ENTRY_MAX, i));
+    }
+    w.textP(PSTR("]}"));
+  }
+
+  void finish() {
+    if (!response_.keepAlive()) client_.stop();
+    int code = response_.code();
+    if (code == 200 || code == 202) {
+      lastSentMs_ = entry(inFlight_ - 1).ms;
+      queueHead_ = (queueHead_ + inFlight_) % GATEWAY_QUEUE_LEN;
+      queueCount_ -= inFlight_;
+      uploaded += inFlight_;
+      posts++;
+      backoffMs_ = 0;
+      // Back-to-back requests would hit ThingSpeak's rate limit
+      retryAt_ = millis() + GATEWAY_BACKOFF_MIN_MS;
+      state_ = BACKOFF;
+      Serial.printf("Site data sent to ThingSpeak! (%u entries)\n", (unsigned)inFlight_);
+    } else {
+      Serial.printf("ThingSpeak (site) Error: %d\n", code);
+      retry();
+    }
+    inFlight_ = 0;
+  }
+
+  void fail(const char* what) {
+    Serial.printf("ThingSpeak (site) Error: %s\n", what);
+    client_.stop();
+    inFlight_ = 0;
+    retry();
+  }
+
+  void retry() {
+    failures++;
+    backoffMs_ = backoffMs_ ? backoffMs_ * 2 : GATEWAY_BACKOFF_MIN_MS;
+    if (backoffMs_ > GATEWAY_BACKOFF_MAX_MS) backoffMs_ = GATEWAY_BACKOFF_MAX_MS;
+    retryAt_ = millis() + backoffMs_;
+    state_ = BACKOFF;
+  }
+
+  static inline SiloGateway* instance_ = nullptr;
+
+  TelegramNotifier& telegram_;
+  const char* const* alertText_;
+  const char* channelId_;
+  const char* writeKey_;
+  bool ready_ = false;
+
+  volatile RxFrame rx_[GATEWAY_RX_QUEUE];
+  volatile uint32_t rxHead_ = 0;  // Written by the callback
+  volatile uint32_t rxTail_ = 0;  // Written by poll()
+
+  SiloNodeState nodes_[GATEWAY_MAX_NODES];
+  uint8_t nodeCount_ = 0;
+  PendingAlert pending_[SILO_ALERT_COUNT];
+  uint32_t windowStartMs_ = 0;
+
+  SiteEntry queue_[GATEWAY_QUEUE_LEN];
+  uint16_t queueHead_ = 0;
+  uint16_t queueCount_ = 0;
+  uint16_t inFlight_ = 0;
+  uint32_t lastSentMs_ = 0;
+
+  WiFiClient client_;
+  HttpResponseReader response_;
+  State state_ = IDLE;
+  uint32_t retryAt_ = 0;
+  uint32_t backoffMs_ = 0;
+};
+#endif
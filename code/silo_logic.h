@@ -0,0 +1,282 @@
+#pragma once
+
+// ==========================================
+// ALARM RULES (PORTABLE CORE)
+// ==========================================
+// What the silo should report, sound and send, given one snapshot of its
+// readings. Pure logic: no pins, no network, and the clock comes in as an
+// argument, so the same code runs in the firmware (applyAlarm) and in the
+// host build under host/, where the benchmark replays recorded data
+// through it.
+//
+// Each alert is one row of ALARM_RULES: its condition, banner, buzzer,
+// Telegram text and timing. Table order is priority, highest first. The
+// highest active rule owns the banner and the buzzer. Every rule has its
+// own notification state, so one alert never holds back another: a motion
+// alert doesn't delay a gas alert that follows it. Adding a rule means
+// adding a SiloAlert code, a condition and a row.
+
+#include <Arduino.h>
+
+// What taskAlarm reports. Also indexes ALERT_TEXT and ALERT_NAME.
+enum SiloAlert : uint8_t {
+  SILO_ALERT_NONE,
+  SILO_ALERT_GAS,
+  SILO_ALERT_HUMIDITY,
+  SILO_ALERT_FERMENTATION,
+  SILO_ALERT_MOTION,
+  SILO_ALERT_SENSOR_FAULT,
+  SILO_ALERT_OFFLINE,                // Raised by the gateway, never sent
+  SILO_ALERT_MOLD_RISK,              // Appended: node frames carry these codes
+  SILO_ALERT_HOTSPOT,
+  SILO_ALERT_COUNT
+};
+
+// Buzzer signatures, driven by taskBuzzer()
+enum BuzzerPattern { BUZZ_OFF, BUZZ_SOLID, BUZZ_SLOW, BUZZ_FAST };
+
+// One snapshot of the sensing pipeline
+struct SiloReadings {
+  float temp;
+  float hum;
+  bool climateOk;        // False while the DHT is stale; temp/hum then hold the last good values
+  uint16_t gas;          // Raw MQ-2 (burst median)
+  uint16_t gasFiltered;
+  float gasSlope;        // Counts per minute
+  bool gasAlarm;         // Filtered gas past the hysteresis threshold
+  bool motion;           // PIR held active
+  bool fermentationRisk; // Anomaly model confirmed
+  bool moldForecast;     // Humidity forecast to reach mold range (mold_forecaster.h)
+  float grainTemp;       // Hottest grain probe (probe_set.h), NaN if none
+  float grainHum;        // Wettest grain probe, NaN if none
+};
+
+// Telegram text per SiloAlert; the gateway sends the same texts for its nodes
+constexpr const char* ALERT_TEXT[SILO_ALERT_COUNT] = {
+  "",
+  "🚨 CRITICAL ALERT: High Gas/Smoke detected in Grain Silo!",
+  "💧 CLIMATE ALERT: Humidity > 60%. Exhaust Fan activated to purge air.",
+  "🌡️ EARLY WARNING: Abnormal gas/climate trend in Grain Silo. Possible early fermentation - inspect soon.",
+  "⚠️ SECURITY ALERT: Motion detected at Grain Silo hatch!",
+  "",  // Sensor fault: the gateway doesn't relay it
+  "📡 LINK ALERT: No data from a silo node for over a minute.",
+  "🍄 MOLD RISK AHEAD: Humidity is forecast to reach mold range within hours. Exhaust Fan started early.",
+  "🔥 HOTSPOT ALERT: Grain is self-heating, well above the headspace temperature. Inspect, aerate or turn the grain.",
+};
+constexpr const char* ALERT_NAME[SILO_ALERT_COUNT] = {
+  "safe", "gas", "humidity", "fermentation", "motion", "sensor-fault", "offline", "mold-forecast", "hotspot",
+};
+
+// Thresholds the conditions read that can change at runtime (MQTT)
+struct AlarmLimits {
+  float humPct;          // Mold risk above this
+};
+
+#define GRAIN_HOTSPOT_RISE_C 8.0f   // A grain probe this much warmer than the headspace: self-heating
+
+// Notification flags
+#define ALARM_NOTIFY_RAISE 0x01      // Telegram when the condition starts
+#define ALARM_NOTIFY_CLEAR 0x02      // Telegram when it ends (only if it was announced)
+#define ALARM_NOTIFY_URGENT 0x04     // Always sent at once, never folded into a digest or muted
+
+struct AlarmRule {
+  SiloAlert code;
+  bool (*when)(const SiloReadings& r, const AlarmLimits& limits);
+  const char* status;    // Dashboard banner; always a string literal
+  BuzzerPattern buzzer;
+  const char* message;   // Telegram text
+  uint8_t notify;        // ALARM_NOTIFY_*
+  uint32_t cooldownMs;   // Least time between two raise messages (a flapping condition)
+  uint32_t repeatMs;     // Reminder while it stays active, 0 = none
+  uint32_t escalateMs;   // One escalation message once active this long, 0 = none
+  float (*measure)(const SiloReadings& r); // Value a digest reports the range of, nullptr = count only
+  const char* unit;
+};
+
+inline bool alarmGas(const SiloReadings& r, const AlarmLimits&) { return r.gasAlarm; }
+inline bool alarmHumidity(const SiloReadings& r, const AlarmLimits& l) {
+  return (r.climateOk && r.hum > l.humPct) || r.grainHum > l.humPct;  // NaN (no probe) compares false
+}
+inline bool alarmHotspot(const SiloReadings& r, const AlarmLimits&) {
+  return r.climateOk && r.grainTemp - r.temp >= GRAIN_HOTSPOT_RISE_C;
+}
+inline bool alarmFermentation(const SiloReadings& r, const AlarmLimits&) { return r.fermentationRisk; }
+inline bool alarmMoldForecast(const SiloReadings& r, const AlarmLimits&) { return r.moldForecast; }
+inline bool alarmMotion(const SiloReadings& r, const AlarmLimits&) { return r.motion; }
+inline bool alarmSensorFault(const SiloReadings& r, const AlarmLimits&) { return !r.climateOk; }
+inline float measureGas(const SiloReadings& r) { return r.gasFiltered; }
+inline float measureHumidity(const SiloReadings& r) { return r.hum; }
+inline float measureWettest(const SiloReadings& r) { return r.grainHum > r.hum ? r.grainHum : r.hum; }
+inline float measureGrainTemp(const SiloReadings& r) { return r.grainTemp; }
+
+// Priority, highest first
+constexpr AlarmRule ALARM_RULES[] = {
+  // Gas/Smoke: fire or spoilage. Always immediate; reminded every 5 min while it lasts
+  { SILO_ALERT_GAS, alarmGas, "SPOILAGE ALERT!", BUZZ_SOLID, ALERT_TEXT[SILO_ALERT_GAS],
+    ALARM_NOTIFY_RAISE | ALARM_NOTIFY_CLEAR | ALARM_NOTIFY_URGENT, 30000, 300000, 0, measureGas, "" },
+  // High humidity in the headspace or at any grain probe: mold risk, slow to change
+  { SILO_ALERT_HUMIDITY, alarmHumidity, "HIGH HUMIDITY ALERT!", BUZZ_SLOW, ALERT_TEXT[SILO_ALERT_HUMIDITY],
+    ALARM_NOTIFY_RAISE | ALARM_NOTIFY_CLEAR, 600000, 3600000, 0, measureWettest, "%" },
+  // Grain probe well above the headspace: respiration heating the mass. Days to act, not minutes
+  { SILO_ALERT_HOTSPOT, alarmHotspot, "GRAIN HOTSPOT", BUZZ_OFF, ALERT_TEXT[SILO_ALERT_HOTSPOT],
+    ALARM_NOTIFY_RAISE | ALARM_NOTIFY_CLEAR, 1800000, 21600000, 0, measureGrainTemp, "°C" },
+  // Slow multi-sensor drift below the hard thresholds. Early warning: notify, don't sound the siren
+  { SILO_ALERT_FERMENTATION, alarmFermentation, "EARLY FERMENTATION", BUZZ_OFF, ALERT_TEXT[SILO_ALERT_FERMENTATION],
+    ALARM_NOTIFY_RAISE | ALARM_NOTIFY_CLEAR, 1800000, 21600000, 0, nullptr, "" },
+  // Humidity forecast to cross the mold line. Early warning while the fan can still prevent it
+  { SILO_ALERT_MOLD_RISK, alarmMoldForecast, "MOLD RISK AHEAD", BUZZ_OFF, ALERT_TEXT[SILO_ALERT_MOLD_RISK],
+    ALARM_NOTIFY_RAISE | ALARM_NOTIFY_CLEAR, 3600000, 0, 0, measureHumidity, "%" },
+  // Motion: intruder/rodent. Each event is news, its end is not
+  { SILO_ALERT_MOTION, alarmMotion, "INTRUDER DETECTED!", BUZZ_FAST, ALERT_TEXT[SILO_ALERT_MOTION],
+    ALARM_NOTIFY_RAISE, 120000, 0, 0, nullptr, "" },
+  // Climate sensor not answering: humidity alarms are blind. Dashboard first, Telegram after 15 min
+  { SILO_ALERT_SENSOR_FAULT, alarmSensorFault, "SENSOR FAULT!", BUZZ_OFF,
+    "🔌 SENSOR FAULT: No reading from the climate sensor. Humidity alarms are blind until it is fixed.",
+    ALARM_NOTIFY_CLEAR, 0, 0, 900000, nullptr, "" },
+};
+#define ALARM_RULE_COUNT (sizeof(ALARM_RULES) / sizeof(ALARM_RULES[0]))
+#define ALARM_MAX_RULES 8
+static_assert(ALARM_RULE_COUNT <= ALARM_MAX_RULES, "raise ALARM_MAX_RULES");
+
+struct AlarmDecision {
+  const char* status;    // Dashboard banner; always a string literal
+  SiloAlert code;
+  BuzzerPattern buzzer;
+};
+
+enum AlarmEventKind : uint8_t { ALARM_RAISED, ALARM_REMINDER, ALARM_ESCALATED, ALARM_CLEARED };
+
+// A notification the caller should send
+struct AlarmEvent {
+  const AlarmRule* rule;
+  AlarmEventKind kind;
+  uint32_t activeMs;     // How long the condition has held (at clear: how long it held)
+};
+
+// Runs every rule once per call and keeps each rule's state: when it
+// started, whether it was announced and when it last sent something.
+// evaluate() returns the decision; the events of that call are then
+// available, in priority order, until the next call.
+class AlarmEngine {
+ public:
+  AlarmEngine(const AlarmRule* rules, uint8_t count)
+      : rules_(rules), count_(count < ALARM_MAX_RULES ? count : ALARM_MAX_RULES) {}
+
+  AlarmDecision evaluate(const SiloReadings& r, const AlarmLimits& limits, uint32_t now) {
+    AlarmDecision d = { "SAFE", SILO_ALERT_NONE, BUZZ_OFF };
+    bool top = false;
+    eventCount_ = 0;
+    for (uint8_t i = 0; i < count_; i++) {
+      const AlarmRule& rule = rules_[i];
+      State& s = state_[i];
+      bool on = rule.when(r, limits);
+      if (on && !top) {
+        d = { rule.status, rule.code, rule.buzzer };
+        top = true;
+      }
+
+      if (on && !s.active) {
+        // Rising edge
+        s.active = true;
+        s.announced = false;
+        s.escalated = false;
+        s.sinceMs = now;
+        if (rule.notify & ALARM_NOTIFY_RAISE) {
+          if (!s.everSent || now - s.lastSentMs >= rule.cooldownMs) {
+            emit(s, rule, ALARM_RAISED, now);
+            raised++;
+          } else {
+            suppressed++;
+          }
+        }
+      } else if (on) {
+        if (rule.escalateMs && !s.escalated && now - s.sinceMs >= rule.escalateMs) {
+          s.escalated = true;
+          emit(s, rule, ALARM_ESCALATED, now);
+          escalated++;
+        } else if (rule.repeatMs && s.announced && now - s.lastSentMs >= rule.repeatMs) {
+          emit(s, rule, ALARM_REMINDER, now);
+          reminders++;
+        }
+      } else if (s.active) {
+        // Falling edge
+        s.active = false;
+        if (s.announced && (rule.notify & ALARM_NOTIFY_CLEAR)) {
+          emit(s, rule, ALARM_CLEARED, now);
+          cleared++;
+        }
+      }
+    }
+    return d;
+  }
+
+  uint8_t eventCount() const { return eventCount_; }
+  const AlarmEvent& event(uint8_t i) const { return events_[i]; }
+
+  // Rule state carried across a reset (boot_state.h): a bit per rule for
+  // active, announced and ever sent, and the time since each rule's last
+  // notification in 10 s steps, so cooldowns and reminders keep their
+  // schedule. A restored episode counts as starting at the restore.
+  struct Memory {
+    uint8_t active = 0;
+    uint8_t announced = 0;
+    uint8_t sent = 0;
+    uint8_t reserved = 0;
+    uint16_t sentAgo10s[ALARM_MAX_RULES] = {};
+  };
+
+  void save(uint32_t now, Memory& m) const {
+    m = Memory();
+    for (uint8_t i = 0; i < count_; i++) {
+      const State& s = state_[i];
+      m.active |= s.active << i;
+      m.announced |= s.announced << i;
+      m.sent |= s.everSent << i;
+      uint32_t ago = (now - s.lastSentMs) / 10000;
+      m.sentAgo10s[i] = ago < UINT16_MAX ? ago : UINT16_MAX;
+    }
+  }
+
+  void restore(const Memory& m, uint32_t now) {
+    for (uint8_t i = 0; i < count_; i++) {
+      State& s = state_[i];
+      s.active = m.active >> i & 1;
+      s.announced = m.announced >> i & 1;
+      s.everSent = m.sent >> i & 1;
+      s.escalated = false;
+      s.sinceMs = now;
+      s.lastSentMs = now - m.sentAgo10s[i] * 10000UL;
+    }
+  }
+
+  // Stats
+  uint32_t raised = 0;
+  uint32_t suppressed = 0;  // Raise messages held back by the rule's cooldown
+  uint32_t reminders = 0;
+  uint32_t escalated = 0;
+  uint32_t cleared = 0;
+
+ private:
+  struct State {
+    bool active = false;
+    bool announced = false;  // This episode was announced (raise or escalation)
+    bool escalated = false;
+    bool everSent = false;
+    uint32_t sinceMs = 0;
+    uint32_t lastSentMs = 0;
+  };
+
+  void emit(State& s, const AlarmRule& rule, AlarmEventKind kind, uint32_t now) {
+    events_[eventCount_++] = { &rule, kind, now - s.sinceMs };
+    if (kind == ALARM_CLEARED) return;
+    s.announced = true;
+    s.everSent = true;
+    s.lastSentMs = now;
+  }
+
+  const AlarmRule* rules_;
+  uint8_t count_;
+  State state_[ALARM_MAX_RULES];
+  AlarmEvent events_[ALARM_MAX_RULES];  // At most one per rule and call
+  uint8_t eventCount_ = 0;
+};
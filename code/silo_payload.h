@@ -0,0 +1,213 @@
+#pragma once
+
+// ==========================================
+// WIRE FORMATS & UPLOAD PAYLOADS (PORTABLE CORE)
+// ==========================================
+// The 16-byte SiloFrame (ESP-NOW node -> gateway, and the MQTT payload),
+// the ThingSpeak field list shared by the live, backfill and window
+// uploads, and the Telegram sendMessage request. They are built from the
+// fixed-point values the history stores, with no network code here, so the
+// host build (host/) can format and time them.
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "net_writer.h"
+#include "sample_history.h"
+#include "silo_logic.h"
+#include "window_stats.h"
+
+#define SILO_FRAME_MAGIC 0x53        // 'S'
+#define SILO_FRAME_VERSION 1
+
+// Flags
+#define SILO_FLAG_FAN 0x01           // Exhaust fan running
+#define SILO_FLAG_GAS_ALARM 0x02     // Filtered gas above the alarm threshold
+#define SILO_FLAG_DHT_STALE 0x04     // Climate reading missing
+#define SILO_FLAG_ALERT 0x08         // Alert event, sent outside the sample period
+#define SILO_FLAG_BOOT 0x10          // First frame since the node booted
+#define SILO_FLAG_OVERRIDE 0x20      // Fan under remote override (MQTT)
+
+// Little-endian on the wire, like everything the ESP8266 writes
+struct __attribute__((packed)) SiloFrame {
+  uint8_t magic;
+  uint8_t version;
+  uint8_t node;          // Node ID, 1..255
+  uint8_t flags;         // SILO_FLAG_*
+  uint16_t seq;          // Per node, +1 per frame (alerts included)
+  int16_t temp;          // centi-degrees C, HISTORY_TEMP_NONE if missing
+  uint8_t hum;           // half-percent steps, HISTORY_HUM_NONE if missing
+  uint8_t motion;        // PIR events in this sample period
+  uint16_t gas;          // Raw MQ-2 (burst median)
+  uint16_t gasFiltered;
+  uint8_t alert;         // SiloAlert
+  uint8_t reserved;
+};
+static_assert(sizeof(SiloFrame) == 16, "SiloFrame is a 16-byte wire format");
+
+// History sample seq as a frame. Header fields (magic, node, seq) are the sender's.
+inline SiloFrame frameFromHistory(const SampleHistory& history, uint32_t seq, uint8_t flags, SiloAlert alert) {
+  SiloFrame f = {};
+  f.flags = flags;
+  f.temp = history.tempCentiAt(seq);
+  f.hum = history.humHalfAt(seq);
+  f.motion = history.motionAt(seq);
+  f.gas = history.gasAt(seq);
+  f.gasFiltered = history.gasFilteredAt(seq);
+  f.alert = alert;
+  return f;
+}
+
+// snprintf at buf + n, for an entry built from several pieces. Once a
+// piece doesn't fit, n is -1 and stays there.
+inline void appendf(char* buf, size_t cap, int& n, const char* fmt, ...) {
+  if (n < 0) return;
+  va_list args;
+  va_start(args, fmt);
+  int r = vsnprintf(buf + n, cap - n, fmt, args);
+  va_end(args);
+  n = r < 0 || (size_t)r >= cap - n ? -1 : n + r;
+}
+
+// The widest each ThingSpeak piece prints. Every value comes from a
+// saturated fixed-point field (sample_history.h, window_stats.h), so none
+// can print wider: THINGSPEAK_ENTRY_MAX (thingspeak_uploader.h) is sized
+// from these.
+#define THINGSPEAK_TIME_WIDEST "{\"created_at\":\"2106-02-07 06:28:15 +0000\""  // uint32 epoch; delta_t is shorter
+#define THINGSPEAK_FIELDS_WIDEST \
+  ",\"field1\":-327.67,\"field2\":100.0,\"field3\":65535,\"field4\":255,\"field5\":65535,\"field6\":-262140.0"
+#define THINGSPEAK_GRAIN_WIDEST ",\"field7\":-327.67,\"field8\":100.0"
+#define THINGSPEAK_WINDOW_WIDEST \
+  ",\"field1\":-327.67,\"field2\":655.3,\"field3\":6553.5,\"field4\":65535,\"field5\":6553.5,\"field6\":-3276.7" \
+  THINGSPEAK_GRAIN_WIDEST \
+  ",\"status\":\"w1 65535 65535 -327.67 -327.67 655.34 655.3 655.3 655.34 65535 6553.5 100\""
+
+// ThingSpeak fields of one entry: ,"field1":..,"field6":.. (no braces).
+// Missing climate readings are left out, so ThingSpeak stores null; the
+// gas slope (field6) needs the previous sample, so pass hasSlope = false
+// when there is none. Returns the length, or -1 if cap is too small.
+inline int formatThingSpeakFields(char* buf, size_t cap, int16_t tempCenti, uint8_t humHalf,
+                                  uint16_t gas, uint8_t motion, uint16_t gasFiltered,
+                                  bool hasSlope, uint16_t prevGasFiltered) {
+  int n = 0;
+  if (tempCenti != HISTORY_TEMP_NONE) appendf(buf, cap, n, ",\"field1\":%.2f", tempCenti / 100.0f);
+  if (humHalf != HISTORY_HUM_NONE) appendf(buf, cap, n, ",\"field2\":%.1f", humHalf / 2.0f);
+  appendf(buf, cap, n, ",\"field3\":%u,\"field4\":%u,\"field5\":%u", gas, motion, gasFiltered);
+  if (hasSlope) {
+    // Gas slope over this sample period, from the previous filtered value
+    float slope = ((int)gasFiltered - (int)prevGasFiltered) * (60000.0f / SAMPLE_PERIOD_MS);
+    appendf(buf, cap, n, ",\"field6\":%.1f", slope);
+  }
+  return n;
+}
+
+// field7/field8: hottest and wettest grain probe of the sample (probe_set.h).
+// Nothing when the silo has no probes or none measured.
+inline int formatThingSpeakGrainFields(char* buf, size_t cap, int16_t tempCenti, uint8_t humHalf) {
+  int n = 0;
+  if (tempCenti != HISTORY_TEMP_NONE) appendf(buf, cap, n, ",\"field7\":%.2f", tempCenti / 100.0f);
+  if (humHalf != HISTORY_HUM_NONE) appendf(buf, cap, n, ",\"field8\":%.1f", humHalf / 2.0f);
+  return n;
+}
+
+// One window summary (window_stats.h) in the same fields, as window
+// averages: field1/2 mean climate, field3 mean raw gas, field4 PIR events,
+// field5 mean filtered gas, field6 its least-squares slope, field7/8 the
+// hottest and wettest probe. The rest rides in "status", space-separated:
+//   w1 <seconds> <readings> <tmin> <tmax> <tstd> <hmin> <hmax> <hstd> <gmax> <gstd> <fan%>
+// with "-" for climate values of a window without readings, and for the
+// fan of a window folded from journal samples. Returns the length, or -1.
+inline int formatThingSpeakWindow(char* buf, size_t cap, const WindowSummary& s) {
+  int n = 0;
+  if (s.readings) appendf(buf, cap, n, ",\"field1\":%.2f,\"field2\":%.1f", s.tempMean / 100.0f, s.humMean / 100.0f);
+  appendf(buf, cap, n, ",\"field3\":%.1f,\"field4\":%u,\"field5\":%.1f,\"field6\":%.1f",
+          s.gasMean / 10.0f, (unsigned)s.motion, s.gasFilteredMean / 10.0f, s.gasSlope / 10.0f);
+  if (s.grainTempMax != HISTORY_TEMP_NONE) appendf(buf, cap, n, ",\"field7\":%.2f", s.grainTempMax / 100.0f);
+  if (s.grainHumMax != HISTORY_HUM_NONE) appendf(buf, cap, n, ",\"field8\":%.1f", s.grainHumMax / 2.0f);
+  appendf(buf, cap, n, ",\"status\":\"w1 %u %u", (unsigned)s.seconds, (unsigned)s.readings);
+  if (s.readings) {
+    appendf(buf, cap, n, " %.2f %.2f %.2f %.1f %.1f %.2f", s.tempMin / 100.0f, s.tempMax / 100.0f,
+            s.tempStd / 100.0f, s.humMin / 100.0f, s.humMax / 100.0f, s.humStd / 100.0f);
+  } else {
+    appendf(buf, cap, n, " - - - - - -");
+  }
+  appendf(buf, cap, n, " %u %.1f", (unsigned)s.gasMax, s.gasStd / 10.0f);
+  if (s.fanDutyPct <= 100) appendf(buf, cap, n, " %u\"", (unsigned)s.fanDutyPct);
+  else appendf(buf, cap, n, " -\"");
+  return n;
+}
+
+#define TELEGRAM_HOST "api.telegram.org"
+
+// GET /bot<token>/sendMessage?chat_id=..&text=.. with the text percent-encoded
+template <typename Writer>
+void writeTelegramRequest(Writer& w, const char* botToken, const char* chatId, const char* text) {
+  w.textP(PSTR("GET /bot"));
+  w.text(botToken);
+  w.textP(PSTR("/sendMessage?chat_id="));
+  w.text(chatId);
+  w.textP(PSTR("&text="));
+  w.encoded(text);
+  w.textP(PSTR(" HTTP/1.1\r\nHost: " TELEGRAM_HOST "\r\nConnection: keep-alive\r\n\r\n"));
+}
+
+// GET /bot<token>/getUpdates for one message, held up to timeoutS by Telegram.
+// A negative offset only confirms (skips) what is pending.
+template <typename Writer>
+void writeTelegramUpdatesRequest(Writer& w, const char* botToken, int32_t offset, uint8_t timeoutS) {
+  w.textP(PSTR("GET /bot"));
+  w.text(botToken);
+  w.printf("/getUpdates?offset=%ld&limit=1&timeout=%u", (long)offset, (unsigned)timeoutS);
+  w.textP(PSTR("&allowed_updates=%5B%22message%22%5D HTTP/1.1\r\n"
+               "Host: " TELEGRAM_HOST "\r\nConnection: keep-alive\r\n\r\n"));
+}
+
+#define TELEGRAM_CMD_MAX 64
+
+// The fields of a getUpdates answer the command handler needs
+struct TelegramUpdate {
+  int32_t updateId;
+  char chat[24];                 // Chat ID, as text (compared with chatId)
+  char text[TELEGRAM_CMD_MAX];   // Message text, "" if none; JSON escapes undone, non-ASCII as '?'
+};
+
+// First update in a getUpdates body; false if there is none. Not a JSON
+// parser: it looks for the keys Telegram always sends, in its order.
+inline bool parseTelegramUpdate(const char* body, TelegramUpdate& u) {
+  const char* p = strstr(body, "\"update_id\":");
+  if (!p) return false;
+  u.updateId = strtol(p + 12, nullptr, 10);
+  u.chat[0] = '\0';
+  u.text[0] = '\0';
+
+  const char* chat = strstr(p, "\"chat\":{\"id\":");
+  if (chat) {
+    chat += 13;
+    size_t n = 0;
+    while (n < sizeof(u.chat) - 1 && (*chat == '-' || isdigit((uint8_t)*chat))) u.chat[n++] = *chat++;
+    u.chat[n] = '\0';
+  }
+
+  const char* t = strstr(p, "\"text\":\"");
+  if (!t) return true;
+  t += 8;
+  size_t n = 0;
+  while (*t && *t != '"' && n < sizeof(u.text) - 1) {
+    char c = *t++;
+    if (c == '\\' && *t) {
+      c = *t++;
+      if (c == 'n') c = ' ';
+      else if (c == 'u') {
+        // \uXXXX: keep ASCII, mark the rest
+        char hex[5] = {};
+        for (uint8_t i = 0; i < 4 && isxdigit((uint8_t)*t); i++) hex[i] = *t++;
+        long cp = strtol(hex, nullptr, 16);
+        c = cp > 0 && cp < 0x80 ? (char)cp : '?';
+      }
+    } else if ((uint8_t)c >= 0x80) {
+      c = '?';
+    }
+    u.text[n++] = c;
+  }
+  u.text[n] = '\0';
+  return true;
+}
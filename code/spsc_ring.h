@@ -0,0 +1,57 @@
+#pragma once
+
+// ==========================================
+// LOCK-FREE SPSC RING (PORTABLE CORE)
+// ==========================================
+// One producer and one consumer, each on its own core: the producer only
+// writes head_, the consumer only writes tail_. The PIR and ESP-NOW queues
+// get away with volatile indices because the ESP8266 has one core; across
+// the ESP32's two cores the order has to be explicit. The slot is written
+// before head_ is published (release) and read only after head_ is seen
+// (acquire), and the same the other way round for tail_, so neither side
+// ever sees half an entry. No lock, no allocation, no waiting: push() on a
+// full ring returns false and counts the drop.
+
+#include <atomic>
+#include <stdint.h>
+
+template <typename T, uint32_t N>
+class SpscRing {
+  static_assert(N && (N & (N - 1)) == 0, "SpscRing length must be a power of two");
+
+ public:
+  // Producer side
+  bool push(const T& value) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= N) {
+      dropped++;
+      return false;
+    }
+    slots_[head & (N - 1)] = value;
+    head_.store(head + 1, std::memory_order_release);
+    pushed++;
+    return true;
+  }
+
+  bool full() const {
+    return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire) >= N;
+  }
+
+  // Consumer side
+  bool pop(T& out) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    out = slots_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Stats, written by the producer (32-bit, so any core may read them)
+  uint32_t pushed = 0;
+  uint32_t dropped = 0;   // Ring was full
+
+ private:
+  T slots_[N];
+  std::atomic<uint32_t> head_{0};  // Written by the producer
+  std::atomic<uint32_t> tail_{0};  // Written by the consumer
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+// ==========================================
+// PRE-COMPRESSED STATIC ASSETS
+// ==========================================
+// The dashboard page, CSS and script are built by code/web/build_assets.py
+// into gzipped PROGMEM arrays (dashboard_assets.h). They are sent exactly
+// as stored, with Content-Encoding: gzip, so serving them costs a flash
+// read and no formatting.
+//
+// Every asset has an ETag (a hash of its content). A browser that already
+// holds the asset gets 304 Not Modified and no body:
+//   - the page itself is "no-cache": always revalidated, so a firmware
+//     update shows up on the next load;
+//   - the CSS and JS are linked with their hash in the URL, so they are
+//     cached for a year and never revalidated at all.
+// Only /events and /state carry live data.
+//
+// A browser that doesn't accept gzip (practically none) is sent from the
+// page to /lite, the streamed page rendered on the device.
+
+#include "platform.h"
+
+struct StaticAsset {
+  const char* path;
+  const char* type;
+  const uint8_t* gz;  // PROGMEM
+  uint32_t len;
+  const char* etag;   // Quoted, as sent
+  bool versioned;     // Linked with its hash in the URL: cache for a year
+};
+
+// Request headers the handler needs (pass to server.collectHeaders())
+static const char* kStaticAssetHeaders[] = { "If-None-Match", "Accept-Encoding" };
+
+inline void serveStaticAsset(ESP8266WebServer& server, const StaticAsset& a) {
+  server.sendHeader("ETag", a.etag);
+  server.sendHeader("Cache-Control", a.versioned ? "public, max-age=31536000, immutable" : "no-cache");
+  if (server.header("If-None-Match") == a.etag) {
+    server.send(304);
+    return;
+  }
+  if (!a.versioned && server.header("Accept-Encoding").indexOf("gzip") < 0) {
+    server.sendHeader("Location", "/lite");
+    server.send(302);
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, a.type, (PGM_P)a.gz, a.len);
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+// ==========================================
+// ASYNC TELEGRAM NOTIFIER
+// ==========================================
+// Alerts are copied into a small fixed queue and sent from poll(), which
+// moves one step through connect -> send -> read response (status, headers,
+// body) on every loop() pass. The TLS client is kept open between
+// messages (HTTP keep-alive), so the handshake is only paid when Telegram
+// drops the connection. Failed sends are retried with exponential backoff.
+//
+// With a command handler (onCommand), the same connection long-polls
+// getUpdates while no alert is waiting. Telegram holds each request for
+// up to TELEGRAM_POLL_S seconds and answers as soon as a message arrives.
+// poll() only watches for the answer, so nothing blocks. An alert queued
+// during a long poll closes the connection and goes out immediately;
+// because the BearSSL session is cached, the reconnect is an abbreviated
+// handshake. Only messages from chatId are executed. The first request
+// after boot only skips what was sent while the board was off, so an old
+// "/fan on" isn't replayed.
+//
+// Note: BearSSL performs the TLS handshake inside connect(), so the CONNECT
+// step still blocks for the handshake (bounded by TELEGRAM_TIMEOUT_MS). Every
+// other step only touches bytes that are already buffered.
+//
+// TLS profile for api.telegram.org:
+//   - The server is pinned (pin in the constructor): a PEM public key
+//     survives certificate renewals as long as Telegram keeps its key; a
+//     SHA-1 certificate fingerprint ("AB:CD:..") must be updated when the
+//     certificate is. ml/tls_pin.py prints both. An empty pin connects
+//     unverified, as before, and says so at boot.
+//   - The BearSSL session is cached, so a reconnect after Telegram closes
+//     the idle link is an abbreviated handshake: no key exchange and no
+//     certificate check.
+//   - TLS 1.2 with ECDHE + ChaCha20/AES-GCM only.
+//   - 512-byte buffers each way when the server accepts a 512-byte max
+//     fragment length (probed once, before the first connect). Otherwise
+//     the receive side needs room for a full 16 KB record. The default is
+//     16 KB + 16 KB.
+//
+// The ESP32 build (platform.h) uses the core's mbedTLS client instead:
+// TLS 1.2 with its default suites, no session cache, full buffers. Its
+// handshake only blocks the network core. The pin must then be the CA
+// certificate PEM (ml/tls_pin.py --ca); a key or fingerprint pin fails
+// closed there.
+
+#include "platform.h"
+#include <WiFiClientSecure.h>
+#include "http_response.h"
+#include "silo_payload.h"
+
+#define TELEGRAM_QUEUE_LEN 4         // Pending alerts kept in RAM
+#define TELEGRAM_MSG_MAX 160         // Bytes per alert text (UTF-8)
+#define TELEGRAM_TIMEOUT_MS 5000     // Connect / response timeout
+#define TELEGRAM_MAX_ATTEMPTS 5      // Give up on a message after this many tries
+#define TELEGRAM_BACKOFF_MIN_MS 2000
+#define TELEGRAM_BACKOFF_MAX_MS 60000
+#define TELEGRAM_POLL_S 25           // getUpdates long-poll timeout
+#define TELEGRAM_POLL_RETRY_MS 30000 // After a failed poll
+#define TELEGRAM_RX_MAX 768          // getUpdates body kept for parsing (one update)
+#define TELEGRAM_TLS_BUF 512         // TLS buffer each way with max fragment length
+#define TELEGRAM_TLS_RX_FULL 16384   // Receive buffer when the server ignores MFLN
+
+#if SILO_DUAL_CORE
+typedef WiFiClientSecure TelegramTlsClient;
+#else
+typedef BearSSL::WiFiClientSecure TelegramTlsClient;
+
+// ECDHE only; ChaCha20 is the fastest in software on the ESP8266
+static const uint16_t TELEGRAM_CIPHERS[] = {
+  BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+  BR_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+  BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+  BR_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+};
+#endif
+
+// Gets the command text; a reply written to reply (NUL-terminated) is sent back
+typedef void (*TelegramCommandHandler)(const char* text, char* reply, size_t cap);
+
+class TelegramNotifier {
+ public:
+  TelegramNotifier(const char* botToken, const char* chatId, const char* tlsPin)
+    : botToken_(botToken), chatId_(chatId), tlsPin_(tlsPin) {}
+
+  // Queue a message. Never blocks. If the queue is full the oldest pending
+  // message is dropped so the newest alert always gets through.
+  void enqueue(const char* message) {
+    if (count_ == TELEGRAM_QUEUE_LEN) {
+      dropOldestWaiting();
+      dropped++;
+    }
+    Slot& s = queue_[(head_ + count_) % TELEGRAM_QUEUE_LEN];
+    strncpy(s.text, message, TELEGRAM_MSG_MAX - 1);
+    s.text[TELEGRAM_MSG_MAX - 1] = '\0';
+    s.enqueuedAt = millis();
+    s.attempts = 0;
+    count_++;
+  }
+
+  // Long-poll for commands while idle (see above)
+  void onCommand(TelegramCommandHandler handler) { commands_ = handler; }
+
+  // Advance the send state machine by one step.
+  void poll() {
+    uint32_t now = millis();
+
+    switch (state_) {
+      case BACKOFF:
+        if ((int32_t)(now - retryAt_) < 0) return;
+        state_ = IDLE;
+        // fall through
+      case IDLE:
+        if (WiFi.status() != WL_CONNECTED) return;
+        if (count_ == 0) {
+          if (!commands_ || (int32_t)(now - pollAt_) < 0) return;
+          polling_ = true;
+        }
+        state_ = client_.connected() ? SEND : CONNECT;
+        return;
+
+      case CONNECT: {
+        if (!configured_) {
+          configureTls();
+          configured_ = true;
+        }
+        uint32_t started = millis();
+        if (!client_.connect(TELEGRAM_HOST, 443)) {
+          // The probe may have failed for the same reason; try it again
+          if (!mfln && !SILO_DUAL_CORE) configured_ = false;
+          if (polling_) pollFailed("connect");
+          else fail("connect");
+          return;
+        }
+        lastConnectMs = millis() - started;
+        if (lastConnectMs > maxConnectMs) maxConnectMs = lastConnectMs;
+        tlsConnects++;
+        state_ = SEND;
+        return;
+      }
+
+      case SEND:
+        if (polling_) {
+          NetWriter<TelegramTlsClient> w(client_);
+          writeTelegramUpdatesRequest(w, botToken_, synced_ ? offset_ : -1, synced_ ? TELEGRAM_POLL_S : 0);
+          response_.begin(TELEGRAM_POLL_S * 1000UL + TELEGRAM_TIMEOUT_MS, rx_, sizeof(rx_));
+        } else {
+          writeRequest(queue_[head_].text);
+          response_.begin(TELEGRAM_TIMEOUT_MS);
+        }
+        state_ = READ_RESPONSE;
+        return;
+
+      case READ_RESPONSE:
+        if (polling_ && count_ > 0) {
+          // An alert beats the long poll; the offset is unchanged, so nothing is lost
+          client_.stop();
+          polling_ = false;
+          pollAborts++;
+          state_ = IDLE;
+          return;
+        }
+        switch (response_.poll(client_)) {
+          case HttpResponseReader::PENDING: return;
+          case HttpResponseReader::DONE:
+            if (polling_) finishPoll();
+            else finish();
+            return;
+          case HttpResponseReader::FAILED:
+            if (polling_) pollFailed("no updates");
+            else fail("no response");
+            return;
+        }
+        return;
+    }
+  }
+
+  bool busy() const { return count_ > 0; }
+  uint8_t pending() const { return count_; }
+
+  // Stats (latency is measured from enqueue() to HTTP 200)
+  uint32_t sent = 0;
+  uint32_t failed = 0;
+  uint32_t dropped = 0;
+  uint32_t lastLatencyMs = 0;
+  uint32_t maxLatencyMs = 0;
+  uint32_t tlsConnects = 0;    // Handshakes (full or resumed)
+  uint32_t lastConnectMs = 0;  // Connect + handshake time
+  uint32_t maxConnectMs = 0;
+  bool mfln = false;           // Server accepted TELEGRAM_TLS_BUF fragments
+  uint32_t commands = 0;       // Commands executed
+  uint32_t commandsRejected = 0; // From another chat
+  uint32_t pollAborts = 0;     // Long polls cut short by an alert
+
+ private:
+  enum State { IDLE, CONNECT, SEND, READ_RESPONSE, BACKOFF };
+
+  struct Slot {
+    char text[TELEGRAM_MSG_MAX];
+    uint32_t enqueuedAt;
+    uint8_t attempts;
+  };
+
+#if SILO_DUAL_CORE
+  void configureTls() {
+    client_.setTimeout(TELEGRAM_TIMEOUT_MS);
+    client_.setHandshakeTimeout(TELEGRAM_TIMEOUT_MS / 1000);
+    if (!tlsPin_[0]) {
+      Serial.println("Telegram: no TLS pin set, the server is not verified");
+      client_.setInsecure();
+    } else if (strncmp(tlsPin_, "-----BEGIN CERTIFICATE", 22) == 0) {
+      client_.setCACert(tlsPin_);
+    } else {
+      // Nothing to verify against, so every connect fails
+      Serial.println("Telegram: on the ESP32 the TLS pin must be a CA certificate (tls_pin.py --ca)");
+    }
+  }
+#else
+  void configureTls() {
+    client_.setTimeout(TELEGRAM_TIMEOUT_MS);
+    client_.setSSLVersion(BR_TLS12, BR_TLS12);
+    client_.setCiphers(TELEGRAM_CIPHERS, sizeof(TELEGRAM_CIPHERS) / sizeof(TELEGRAM_CIPHERS[0]));
+    client_.setSession(&session_);
+
+    if (!tlsPin_[0]) {
+      Serial.println("Telegram: no TLS pin set, the server is not verified");
+      client_.setInsecure();
+    } else if (strncmp(tlsPin_, "-----BEGIN", 10) == 0) {
+      if (key_.parse(tlsPin_, strlen(tlsPin_))) client_.setKnownKey(&key_);
+      else Serial.println("Telegram: TLS pin is not a valid public key");
+    } else if (!client_.setFingerprint(tlsPin_)) {
+      Serial.println("Telegram: TLS pin is not a valid SHA-1 fingerprint");
+    }
+    // A bad pin leaves nothing to verify against, so every connect fails
+
+    // Blocks for one partial handshake, once
+    mfln = BearSSL::WiFiClientSecure::probeMaxFragmentLength(TELEGRAM_HOST, 443, TELEGRAM_TLS_BUF);
+    client_.setBufferSizes(mfln ? TELEGRAM_TLS_BUF : TELEGRAM_TLS_RX_FULL, TELEGRAM_TLS_BUF);
+    Serial.printf("Telegram: TLS buffers %u/%u bytes (max fragment length %s)\n",
+                  mfln ? TELEGRAM_TLS_BUF : TELEGRAM_TLS_RX_FULL, TELEGRAM_TLS_BUF,
+                  mfln ? "accepted" : "not supported");
+  }
+#endif
+
+  void popFront() {
+    head_ = (head_ + 1) % TELEGRAM_QUEUE_LEN;
+    count_--;
+  }
+
+  // Make room in a full queue. The message currently on the wire is never
+  // dropped; the oldest one behind it goes instead. A getUpdates poll
+  // isn't sending the head, so then the head itself is the oldest waiting.
+  void dropOldestWaiting() {
+    bool sending = !polling_ && state_ != IDLE && state_ != BACKOFF;
+    if (!sending || count_ < 2) {
+      popFront();
+      return;
+    }
+    for (uint8_t i = 1; i + 1 < count_; i++) {
+      queue_[(head_ + i) % TELEGRAM_QUEUE_LEN] = queue_[(head_ + i + 1) % TELEGRAM_QUEUE_LEN];
+    }
+    count_--;
+  }
+
+  // The whole request is assembled in one buffer and usually leaves as a
+  // single TLS record (silo_payload.h)
+  void writeRequest(const char* text) {
+    NetWriter<TelegramTlsClient> w(client_);
+    writeTelegramRequest(w, botToken_, chatId_, text);
+  }
+
+  void finish() {
+    if (!response_.keepAlive()) client_.stop();
+
+    if (response_.code() == 200) {
+      Slot& s = queue_[head_];
+      lastLatencyMs = millis() - s.enqueuedAt;
+      if (lastLatencyMs > maxLatencyMs) maxLatencyMs = lastLatencyMs;
+      sent++;
+      popFront();
+      state_ = IDLE;
+      Serial.printf("✅ Telegram Alert Sent Successfully! (%u ms)\n", (unsigned)lastLatencyMs);
+    } else {
+      Serial.printf("❌ Telegram Error: %d\n", response_.code());
+      retry();
+    }
+  }
+
+  void finishPoll() {
+    polling_ = false;
+    if (!response_.keepAlive()) client_.stop();
+    state_ = IDLE;
+    if (response_.code() != 200) {
+      Serial.printf("❌ Telegram getUpdates Error: %d\n", response_.code());
+      pollAt_ = millis() + TELEGRAM_POLL_RETRY_MS;
+      return;
+    }
+    pollAt_ = millis();  // Next long poll right away
+
+    TelegramUpdate u;
+    bool got = parseTelegramUpdate(rx_, u);
+    if (got) offset_ = u.updateId + 1;
+    if (!synced_) {
+      synced_ = true;  // The backlog from before boot is skipped
+      return;
+    }
+    if (!got || !u.text[0]) return;
+    if (strcmp(u.chat, chatId_) != 0) {
+      commandsRejected++;
+      return;
+    }
+    char reply[TELEGRAM_MSG_MAX];
+    reply[0] = '\0';
+    commands_(u.text, reply, sizeof(reply));
+    commands++;
+    Serial.printf("Telegram command: %s\n", u.text);
+    if (reply[0]) enqueue(reply);
+  }
+
+  void pollFailed(const char* what) {
+    Serial.printf("❌ Telegram getUpdates Error: %s\n", what);
+    client_.stop();
+    polling_ = false;
+    state_ = IDLE;
+    pollAt_ = millis() + TELEGRAM_POLL_RETRY_MS;
+  }
+
+  void fail(const char* what) {
+    Serial.printf("❌ Telegram Error: %s\n", what);
+    client_.stop();
+    retry();
+  }
+
+  void retry() {
+    Slot& s = queue_[head_];
+    if (++s.attempts >= TELEGRAM_MAX_ATTEMPTS) {
+      failed++;
+      popFront();
+      state_ = IDLE;
+      return;
+    }
+    uint32_t backoff = TELEGRAM_BACKOFF_MIN_MS << (s.attempts - 1);
+    if (backoff > TELEGRAM_BACKOFF_MAX_MS) backoff = TELEGRAM_BACKOFF_MAX_MS;
+    retryAt_ = millis() + backoff;
+    state_ = BACKOFF;
+  }
+
+  const char* botToken_;
+  const char* chatId_;
+  const char* tlsPin_;
+  TelegramTlsClient client_;
+#if !SILO_DUAL_CORE
+  BearSSL::Session session_;
+  BearSSL::PublicKey key_;
+#endif
+  bool configured_ = false;
+
+  Slot queue_[TELEGRAM_QUEUE_LEN];
+  uint8_t head_ = 0;
+  uint8_t count_ = 0;
+
+  State state_ = IDLE;
+  uint32_t retryAt_ = 0;
+  HttpResponseReader response_;
+
+  TelegramCommandHandler commands_ = nullptr;
+  bool polling_ = false;     // The request in flight is getUpdates
+  bool synced_ = false;      // Pre-boot backlog skipped
+  int32_t offset_ = 0;       // Next update_id wanted (0 = whatever is pending)
+  uint32_t pollAt_ = 0;
+  char rx_[TELEGRAM_RX_MAX];
+};
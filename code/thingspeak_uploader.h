@@ -0,0 +1,407 @@
+#pragma once
+
+// ==========================================
+// BATCHED THINGSPEAK UPLOADER
+// ==========================================
+// Samples are read from the in-RAM SampleHistory and flushed in one POST to
+// ThingSpeak's bulk_update.json endpoint, over a keep-alive connection. The
+// uploader only keeps a cursor (the next sequence number to send); a failed
+// flush simply leaves the cursor where it was and is retried with backoff,
+// so a dropped connection no longer loses data as long as the history still
+// holds it. Like the Telegram notifier, poll() does one step of work per
+// loop() pass.
+//
+// Each entry carries "delta_t": seconds since the previous sample, which
+// lets ThingSpeak rebuild the original sample spacing.
+//
+// With a SampleJournal attached, the journal decides what is still unsent.
+// Anything the RAM history no longer holds (a long outage, or samples from
+// before a reboot) is replayed from flash first, oldest first, at most
+// UPLOAD_BACKFILL_MAX samples every UPLOAD_BACKFILL_INTERVAL_MS. Those
+// entries carry an absolute "created_at" time instead of delta_t. Live
+// uploads from the history resume once the backlog is gone.
+//
+// Fields: 1 temperature, 2 humidity, 3 raw gas, 4 motion events,
+//         5 filtered gas, 6 gas slope (counts/min)
+//
+// With a WindowLog attached (UPLOAD_WINDOW_S), the uploader sends window
+// summaries instead of samples, the same way: a cursor over their sequence
+// numbers and delta_t between window ends. The journal still holds the
+// samples: each accepted window marks the samples it covers as sent, and
+// what is left (windows the log overwrote, or the ones lost in a reboot)
+// is backfilled by folding the journal samples into windows again, one
+// entry per window length of consecutive samples. Those have no fan duty.
+//
+// Every entry is bounded: THINGSPEAK_ENTRY_MAX is the widest one that can
+// be formatted (silo_payload.h).
+
+#include "platform.h"
+#include "http_response.h"
+#include "net_writer.h"
+#include "sample_history.h"
+#include "sample_journal.h"
+#include "silo_payload.h"
+#include "window_stats.h"
+
+#define THINGSPEAK_HOST "api.thingspeak.com"
+#define UPLOAD_FLUSH_MS 60000        // Flush at least this often...
+#define UPLOAD_BATCH_SIZE 4          // ...or as soon as this many are waiting
+#define UPLOAD_BATCH_MAX 32          // Largest batch sent in one request
+#define UPLOAD_TIMEOUT_MS 5000
+#define UPLOAD_BACKOFF_MIN_MS 15000  // ThingSpeak allows one bulk update per 15 s
+#define UPLOAD_BACKOFF_MAX_MS 300000
+#define UPLOAD_BACKFILL_MAX 40       // Journal samples per backfill request
+#define UPLOAD_BACKFILL_INTERVAL_MS 15000 // Pace of backfill requests
+// One formatted bulk_update entry: the widest is a window with a created_at
+#define THINGSPEAK_ENTRY_MAX sizeof("," THINGSPEAK_TIME_WIDEST THINGSPEAK_WINDOW_WIDEST "}")
+static_assert(THINGSPEAK_ENTRY_MAX >=
+              sizeof("," THINGSPEAK_TIME_WIDEST THINGSPEAK_FIELDS_WIDEST THINGSPEAK_GRAIN_WIDEST "}"),
+              "a sample entry must fit THINGSPEAK_ENTRY_MAX");
+static_assert(THINGSPEAK_ENTRY_MAX <= NET_WRITER_BUF, "an entry is formatted into the writer's buffer");
+
+class ThingSpeakUploader {
+ public:
+  ThingSpeakUploader(const SampleHistory& history, const char* channelId, const char* writeKey)
+    : history_(history), channelId_(channelId), writeKey_(writeKey) {}
+
+  void setBatching(uint8_t batchSize, uint32_t flushIntervalMs) {
+    batchSize_ = batchSize < 1 ? 1 : (batchSize > UPLOAD_BATCH_MAX ? UPLOAD_BATCH_MAX : batchSize);
+    flushIntervalMs_ = flushIntervalMs;
+  }
+
+  // Use the flash journal as the record of what has been sent
+  void useJournal(SampleJournal* journal) { journal_ = journal; }
+
+  // Upload these window summaries instead of the history samples.
+  // windowS: their length, for the windows folded from the journal.
+  void useWindows(const WindowLog* windows, uint32_t windowS) {
+    windows_ = windows;
+    windowS_ = windowS;
+  }
+
+  void poll() {
+    uint32_t now = millis();
+    if (windows_ || !journaled()) skipOverwritten();
+    else if (state_ == IDLE || state_ == BACKOFF) nextSeq_ = journal_->nextUnsentSeq();
+
+    switch (state_) {
+      case BACKOFF:
+        if ((int32_t)(now - retryAt_) < 0) return;
+        state_ = IDLE;
+        // fall through
+      case IDLE:
+        if (WiFi.status() != WL_CONNECTED) return;
+        if (journaled()) {
+          if (!backfillReady(now)) return;
+          if (inFlight_) {
+            fromJournal_ = true;
+            state_ = client_.connected() ? SEND : CONNECT;
+            return;
+          }
+        }
+        if (pending() == 0) return;
+        if (pending() < batchSize_ && now - msAt(nextSeq_) < flushIntervalMs_) return;
+        inFlight_ = pending() < batchSize_ ? pending() : batchSize_;
+        fromJournal_ = false;
+        state_ = client_.connected() ? SEND : CONNECT;
+        return;
+
+      case CONNECT:
+        client_.setTimeout(UPLOAD_TIMEOUT_MS);
+        if (!client_.connect(THINGSPEAK_HOST, 80)) {
+          fail("connect");
+          return;
+        }
+        connects++;
+        state_ = SEND;
+        return;
+
+      case SEND:
+        writeRequest();
+        response_.begin(UPLOAD_TIMEOUT_MS);
+        state_ = READ_RESPONSE;
+        return;
+
+      case READ_RESPONSE:
+        switch (response_.poll(client_)) {
+          case HttpResponseReader::PENDING: return;
+          case HttpResponseReader::DONE: finish(); return;
+          case HttpResponseReader::FAILED: fail("no response"); return;
+        }
+        return;
+    }
+  }
+
+  // Samples (or windows) recorded but not yet accepted by ThingSpeak
+  uint32_t pending() const { return headSeq() - nextSeq_; }
+
+  // A request is in progress (connecting, sending, or awaiting the reply)
+  bool busy() const { return state_ != IDLE && state_ != BACKOFF; }
+
+  // Stats
+  uint32_t uploaded = 0;   // Samples (windows) accepted by ThingSpeak
+  uint32_t posts = 0;      // Successful bulk requests
+  uint32_t failures = 0;   // Failed bulk requests
+  uint32_t dropped = 0;    // Samples (windows) lost: overwritten before upload and not journaled,
+                           // or too wide for an entry (never, with the formats of silo_payload.h)
+  uint32_t connects = 0;   // TCP connections opened
+  uint32_t backfilled = 0; // Samples replayed from the journal
+
+ private:
+  enum State { IDLE, CONNECT, SEND, READ_RESPONSE, BACKOFF };
+
+  bool journaled() const { return journal_ && journal_->ready(); }
+
+  // What is being uploaded: history samples, or window summaries
+  uint32_t headSeq() const { return windows_ ? windows_->nextSeq() : history_.nextSeq(); }
+  uint32_t oldestSeq() const { return windows_ ? windows_->oldestSeq() : history_.oldestSeq(); }
+  uint32_t msAt(uint32_t seq) const { return windows_ ? windows_->at(seq).endMs : history_.msAt(seq); }
+
+  // First history sample the live uploads still send; the journal
+  // backfills what is older
+  uint32_t firstLiveSample() const {
+    if (!windows_) return history_.oldestSeq();
+    return pending() ? windows_->at(nextSeq_).firstSeq : windows_->openSeq();
+  }
+
+  // Decide whether the journal has a backlog to send first. Returns false
+  // while the history has to wait; on true, inFlight_ > 0 means a journal
+  // batch is loaded in backlog_.
+  bool backfillReady(uint32_t now) {
+    inFlight_ = 0;
+    bool gap = !windows_ && nextSeq_ < history_.oldestSeq();
+    if (!backfilling_ && !gap) return true;
+    if ((int32_t)(now - nextBackfillMs_) < 0) return false;
+
+    uint8_t n;
+    switch (journal_->readBacklog(backlog_, UPLOAD_BACKFILL_MAX, firstLiveSample(), n)) {
+      case SampleJournal::BACKLOG_READY:
+        backfilling_ = true;
+        backlogCount_ = n;
+        inFlight_ = windows_ ? groupBacklog() : n;
+        nextBackfillMs_ = now + UPLOAD_BACKFILL_INTERVAL_MS;
+        return true;
+      case SampleJournal::BACKLOG_SCANNING:
+        nextBackfillMs_ = now + 50;
+        return false;
+      case SampleJournal::BACKLOG_NEED_CLOCK:
+        nextBackfillMs_ = now + 1000;
+        return false;
+      case SampleJournal::BACKLOG_NONE:
+        break;
+    }
+    backfilling_ = false;
+    // Not in the journal either (e.g. a flash write error): truly lost
+    if (gap) {
+      dropped += history_.oldestSeq() - nextSeq_;
+      nextSeq_ = history_.oldestSeq();
+      journal_->markSent(nextSeq_ - 1);
+      lastSentMs_ = 0;
+    }
+    return true;
+  }
+
+  // During a long outage the history wraps; move the cursor to the oldest
+  // sample still held. Never while a batch is on the wire.
+  void skipOverwritten() {
+    if (state_ != IDLE && state_ != BACKOFF) return;
+    uint32_t oldest = oldestSeq();
+    if (nextSeq_ < oldest) {
+      // Windows: their samples are still in the journal
+      if (windows_ && journaled()) backfilling_ = true;
+      else dropped += oldest - nextSeq_;
+      nextSeq_ = oldest;
+      lastSentMs_ = 0;
+    }
+  }
+
+  // Consecutive samples of one boot
+  bool continues(uint8_t i) const {
+    return i > 0 && backlog_[i - 1].boot == backlog_[i].boot && backlog_[i - 1].seq + 1 == backlog_[i].seq;
+  }
+
+  // Split the journal batch into windows: a new one at a boot or a gap, or
+  // once windowS has passed. Returns their number.
+  uint8_t groupBacklog() {
+    uint8_t groups = 0;
+    for (uint8_t i = 0; i < backlogCount_; i++) {
+      if (!continues(i) || backlog_[i].timeS - backlog_[groupStart_[groups - 1]].timeS >= windowS_) {
+        groupStart_[groups++] = i;
+      }
+    }
+    groupStart_[groups] = backlogCount_;
+    return groups;
+  }
+
+  // Adds a formatter's piece to the entry length; -1 if either didn't fit
+  static int joined(int n, int piece) { return n < 0 || piece < 0 ? -1 : n + piece; }
+
+  // One {"delta_t":..,"field1":..} entry, after a comma unless it's the
+  // first. Returns its length, or -1 if it doesn't fit in cap.
+  int formatEntry(char* buf, size_t cap, uint8_t i, bool comma) {
+    if (fromJournal_) return formatJournalEntry(buf, cap, i, comma);
+    uint32_t seq = nextSeq_ + i;
+    uint32_t prevMs = i == 0 ? lastSentMs_ : msAt(seq - 1);
+    uint32_t deltaS = prevMs ? (msAt(seq) - prevMs) / 1000 : 0;
+    int n = 0;
+    appendf(buf, cap, n, "%s{\"delta_t\":%u", comma ? "," : "", (unsigned)deltaS);
+    if (n < 0) return -1;
+    if (windows_) {
+      n = joined(n, formatThingSpeakWindow(buf + n, cap - n, windows_->at(seq)));
+    } else {
+      bool hasPrev = history_.contains(seq - 1);
+      n = joined(n, formatThingSpeakFields(buf + n, cap - n, history_.tempCentiAt(seq), history_.humHalfAt(seq),
+                                           history_.gasAt(seq), history_.motionAt(seq),
+                                           history_.gasFilteredAt(seq), hasPrev,
+                                           hasPrev ? history_.gasFilteredAt(seq - 1) : 0));
+      if (n >= 0) {
+        n = joined(n, formatThingSpeakGrainFields(buf + n, cap - n, history_.grainTempCentiMaxAt(seq),
+                                                  history_.grainHumHalfMaxAt(seq)));
+      }
+    }
+    appendf(buf, cap, n, "}");
+    return n;
+  }
+
+  // Same fields from journal records, with an absolute timestamp: record
+  // i, or in window mode the window i folded from its records
+  int formatJournalEntry(char* buf, size_t cap, uint8_t i, bool comma) {
+    uint8_t first = windows_ ? groupStart_[i] : i;
+    uint8_t end = windows_ ? groupStart_[i + 1] : i + 1;
+    const JournalRecord& r = backlog_[end - 1];
+    uint32_t epoch = 0;
+    journal_->epochOf(r.boot, epoch);
+    time_t t = epoch + r.timeS;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    int n = 0;
+    appendf(buf, cap, n, "%s{\"created_at\":\"%04d-%02d-%02d %02d:%02d:%02d +0000\"",
+            comma ? "," : "", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+            tm.tm_hour, tm.tm_min, tm.tm_sec);
+    if (n < 0) return -1;
+    if (windows_) {
+      SampleWindowFolder fold;
+      for (uint8_t j = first; j < end; j++) {
+        const JournalRecord& s = backlog_[j];
+        fold.add(s.timeS, s.temp, s.hum(), s.gas(), s.gasFiltered(), s.motion());
+      }
+      n = joined(n, formatThingSpeakWindow(buf + n, cap - n, fold.summary()));
+    } else {
+      bool hasPrev = continues(i);
+      n = joined(n, formatThingSpeakFields(buf + n, cap - n, r.temp, r.hum(), r.gas(), r.motion(),
+                                           r.gasFiltered(), hasPrev, hasPrev ? backlog_[i - 1].gasFiltered() : 0));
+    }
+    appendf(buf, cap, n, "}");
+    return n;
+  }
+
+  // The body is formatted twice: once to size Content-Length, once to send.
+  // Entries are formatted straight into the writer's buffer, and the
+  // request leaves in a few full-size writes (net_writer.h).
+  void writeRequest() {
+    ByteCounter body;
+    {
+      NetWriter<ByteCounter> sizing(body);
+      dropped += writeBody(sizing);
+    }
+    NetWriter<WiFiClient> w(client_);
+    w.textP(PSTR("POST /channels/"));
+    w.text(channelId_);
+    w.textP(PSTR("/bulk_update.json HTTP/1.1\r\n"
+                 "Host: " THINGSPEAK_HOST "\r\n"
+                 "Connection: keep-alive\r\n"
+                 "Content-Type: application/json\r\n"
+                 "Content-Length: "));
+    w.number(body.bytes);
+    w.textP(PSTR("\r\n\r\n"));
+    writeBody(w);
+  }
+
+  // Returns the entries left out for not fitting THINGSPEAK_ENTRY_MAX
+  template <typename Writer>
+  uint8_t writeBody(Writer& w) {
+    w.textP(PSTR("{\"write_api_key\":\""));
+    w.text(writeKey_);
+    w.textP(PSTR("\",\"updates\":["));
+    uint8_t skipped = 0;
+    for (uint8_t i = 0; i < inFlight_; i++) {
+      char* entry = w.reserve(THINGSPEAK_ENTRY_MAX);
+      int n = formatEntry(entry, THINGSPEAK_ENTRY_MAX, i, i > skipped);
+      if (n < 0) skipped++;
+      else w.commit(n);
+    }
+    w.textP(PSTR("]}"));
+    return skipped;
+  }
+
+  void finish() {
+    if (!response_.keepAlive()) client_.stop();
+
+    // bulk_update answers 202 Accepted
+    int code = response_.code();
+    if (code == 200 || code == 202) {
+      if (fromJournal_) {
+        journal_->consumeBacklog();
+        backfilled += backlogCount_;
+        lastSentMs_ = 0;
+      } else {
+        lastSentMs_ = msAt(nextSeq_ + inFlight_ - 1);
+        nextSeq_ += inFlight_;
+        // Windows: the samples up to the last one's end
+        uint32_t sentEnd = windows_ ? windows_->at(nextSeq_ - 1).endSeq : nextSeq_;
+        if (journaled() && sentEnd) journal_->markSent(sentEnd - 1);
+      }
+      uploaded += inFlight_;
+      posts++;
+      backoffMs_ = 0;
+      state_ = IDLE;
+      Serial.printf("Data sent to ThingSpeak! (%u %s%s)\n", (unsigned)inFlight_,
+                    windows_ ? "windows" : "samples", fromJournal_ ? " from the journal" : "");
+    } else {
+      Serial.printf("ThingSpeak Error: %d\n", code);
+      retry();
+    }
+    inFlight_ = 0;
+  }
+
+  void fail(const char* what) {
+    Serial.printf("ThingSpeak Error: %s\n", what);
+    client_.stop();
+    inFlight_ = 0;
+    retry();
+  }
+
+  void retry() {
+    failures++;
+    backoffMs_ = backoffMs_ ? backoffMs_ * 2 : UPLOAD_BACKOFF_MIN_MS;
+    if (backoffMs_ > UPLOAD_BACKOFF_MAX_MS) backoffMs_ = UPLOAD_BACKOFF_MAX_MS;
+    retryAt_ = millis() + backoffMs_;
+    state_ = BACKOFF;
+  }
+
+  const SampleHistory& history_;
+  const char* channelId_;
+  const char* writeKey_;
+  WiFiClient client_;
+  SampleJournal* journal_ = nullptr;
+  const WindowLog* windows_ = nullptr;
+  uint32_t windowS_ = 0;
+
+  uint32_t nextSeq_ = 0;   // Next history sample (or window) to upload
+  uint8_t inFlight_ = 0;
+  uint8_t batchSize_ = UPLOAD_BATCH_SIZE;
+  uint32_t flushIntervalMs_ = UPLOAD_FLUSH_MS;
+  uint32_t lastSentMs_ = 0;
+
+  JournalRecord backlog_[UPLOAD_BACKFILL_MAX]; // Journal batch being sent
+  uint8_t backlogCount_ = 0;
+  uint8_t groupStart_[UPLOAD_BACKFILL_MAX + 1]; // Window mode: first record of each window
+  bool fromJournal_ = false;
+  bool backfilling_ = true;  // Check the journal first after boot
+  uint32_t nextBackfillMs_ = 0;
+
+  State state_ = IDLE;
+  uint32_t retryAt_ = 0;
+  uint32_t backoffMs_ = 0;
+  HttpResponseReader response_;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+// ==========================================
+// TRACE REPLAY (HARDWARE-IN-THE-LOOP)
+// ==========================================
+// Built with TRACE_REPLAY = 1, the firmware doesn't read its sensors or
+// join WiFi. Recorded frames come in instead, one per line, over Serial or
+// from a LittleFS file (TRACE_REPLAY_FILE):
+//     <ms>,<temp C>,<hum %>,<gas raw>,<motion events>
+// ms is trace time (any origin, increasing). An empty temp or hum is a DHT
+// dropout. Lines starting with '#' are skipped, and "end" finishes the run.
+//
+// Every frame goes through the real pipeline in virtual time (see
+// code.ino). First come all the 50 ms control ticks since the previous
+// frame: gas filter, alarm, and the fan every 500 ms. Then comes the sample
+// work: history and anomaly scoring. Nothing waits for the wall clock, so
+// the run is as fast as the CPU. One line goes back per frame:
+//     D,<ms>,<alert>,<buzzer>,<fan>,<alerts queued>,<frame us>,<worst tick us>
+// before it, if the frame queued a Telegram (the D line has the count):
+//     A,<ms>,<alert>
+// and a summary at the end, after which the board restarts for a clean run:
+//     S,<frames>,<ticks>,<busy ms>,<worst frame us>,<worst tick us>,<frames/s>,<alerts>
+// The times cover the pipeline only, not the serial I/O. The relay and the
+// buzzer stay off, and their states are only reported.
+//
+// ml/replay_trace.py streams a CSV from ml/fetch_data.py. It keeps
+// TRACE_REPLAY_WINDOW frames in flight, so the link stays busy without
+// overrunning the receive buffer.
+
+#include <Arduino.h>
+
+#ifndef TRACE_REPLAY
+#define TRACE_REPLAY 0               // 1 = replay firmware (no sensors, no network)
+#endif
+
+#define TRACE_REPLAY_BAUD 460800
+#define TRACE_REPLAY_RX_BUFFER 1024  // Serial receive buffer (the default is 256)
+#define TRACE_REPLAY_WINDOW 16       // Frames the sender may have in flight
+#define TRACE_REPLAY_FILE "/trace.csv" // Replayed instead of Serial when present
+#define TRACE_REPLAY_MAX_GAP_MS 300000 // Longer trace gaps are shortened to this
+#define TRACE_LINE_MAX 64
+
+struct TraceFrame {
+  uint32_t ms;
+  float temp;     // NaN = missing
+  float hum;
+  uint16_t gas;
+  uint8_t motion;
+};
+
+// Assembles lines from a Stream without blocking and parses them
+class TraceReader {
+ public:
+  // True when a frame is ready in f. Consumes what is available (up to one line).
+  bool poll(Stream& in, TraceFrame& f) {
+    while (in.available()) {
+      char c = in.read();
+      if (c == '\r') continue;
+      if (c != '\n') {
+        if (len_ < TRACE_LINE_MAX - 1) line_[len_++] = c;
+        else overflow_ = true;
+        continue;
+      }
+      line_[len_] = '\0';
+      bool overflow = overflow_;
+      len_ = 0;
+      overflow_ = false;
+      if (overflow) {
+        rejected++;
+        continue;
+      }
+      if (!line_[0] || line_[0] == '#') continue;
+      if (strcmp(line_, "end") == 0) {
+        ended = true;
+        return false;
+      }
+      if (parse(f)) return true;
+      rejected++;
+    }
+    return false;
+  }
+
+  bool ended = false;     // "end" seen
+  uint32_t rejected = 0;  // Malformed or overlong lines
+
+ private:
+  bool parse(TraceFrame& f) {
+    char* p = line_;
+    char* end;
+    f.ms = strtoul(p, &end, 10);
+    if (end == p || *end != ',') return false;
+    f.temp = field(end + 1, p);
+    if (!p) return false;
+    f.hum = field(p, p);
+    if (!p) return false;
+    long gas = strtol(p, &end, 10);
+    if (end == p || *end != ',' || gas < 0 || gas > 1023) return false;
+    long motion = strtol(end + 1, &p, 10);
+    if (p == end + 1 || motion < 0) return false;
+    f.gas = gas;
+    f.motion = motion > 15 ? 15 : motion;
+    return true;
+  }
+
+  // Float up to the next comma, NaN if empty; next is set past the comma (nullptr if none)
+  static float field(char* s, char*& next) {
+    char* comma = strchr(s, ',');
+    next = comma ? comma + 1 : nullptr;
+    if (!comma || comma == s) return NAN;
+    char* end;
+    float v = strtof(s, &end);
+    return end == comma ? v : NAN;
+  }
+
+  char line_[TRACE_LINE_MAX];
+  uint8_t len_ = 0;
+  bool overflow_ = false;
+};
+
+// Run totals for the summary line
+struct TraceStats {
+  uint32_t frames = 0;
+  uint32_t ticks = 0;
+  uint64_t busyUs = 0;
+  uint32_t worstFrameUs = 0;
+  uint32_t worstTickUs = 0;
+  uint32_t alerts = 0;
+
+  void printSummary(Print& out) const {
+    out.printf("S,%u,%u,%u,%u,%u,%.1f,%u\n", (unsigned)frames, (unsigned)ticks,
+               (unsigned)(busyUs / 1000), (unsigned)worstFrameUs, (unsigned)worstTickUs,
+               busyUs ? frames * 1e6 / busyUs : 0.0, (unsigned)alerts);
+  }
+};
@@ -0,0 +1,132 @@
+"""
+Smart Grain Silo - Dashboard Asset Builder
+==========================================
+Minifies and gzips the dashboard sources in this folder into
+code/dashboard_assets.h, which the firmware serves straight from flash
+with Content-Encoding: gzip (see code/static_assets.h).
+
+  dashboard.html  ->  /               revalidated on every load (ETag -> 304)
+  dashboard.css   ->  /dashboard.css  cached for a year
+  dashboard.js    ->  /dashboard.js   cached for a year
+
+The page links the CSS and JS as "/dashboard.css?v=<hash>": every
+{{name}} in the HTML is replaced by the content hash of that file. When a
+file changes, browsers fetch it again, and an unchanged one is never
+requested twice.
+
+Only the standard library is used. The output is reproducible: the gzip
+timestamp is fixed, so the generated header changes only when a source
+changes.
+
+Usage (re-run after editing anything in code/web/, then re-flash):
+    python build_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+WEB_DIR = os.path.dirname(os.path.abspath(__file__))
+HEADER_PATH = os.path.join(WEB_DIR, "..", "dashboard_assets.h")
+
+# (source file, URL path, content type, versioned)
+ASSETS = [
+    ("dashboard.css", "/dashboard.css", "text/css", True),
+    ("dashboard.js", "/dashboard.js", "application/javascript", True),
+    ("dashboard.html", "/", "text/html", False),
+]
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{}:;,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Conservative: whole-line comments and indentation only, so string
+    # literals and automatic semicolon insertion are left alone
+    lines = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line and not line.startswith("//"):
+            lines.append(line)
+    return "\n".join(lines)
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    text = re.sub(r">\s+<", "><", text)
+    text = re.sub(r"\s+", " ", text)
+    return text.strip()
+
+
+MINIFIERS = {"text/css": minify_css, "application/javascript": minify_js, "text/html": minify_html}
+
+
+def content_hash(data):
+    return hashlib.sha1(data).hexdigest()[:8]
+
+
+def c_array(name, data):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("  " + " ".join("0x%02x," % b for b in data[i:i + 16]))
+    return "static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(rows))
+
+
+def main():
+    hashes = {}
+    built = []
+    for source, path, ctype, versioned in ASSETS:
+        with open(os.path.join(WEB_DIR, source), encoding="utf-8") as f:
+            text = f.read()
+        # Versioned assets come first, so the page can carry their hashes
+        text = re.sub(r"\{\{([\w.]+)\}\}", lambda m: hashes[m.group(1)], text)
+        raw = MINIFIERS[ctype](text).encode("utf-8")
+        gz = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = content_hash(raw)
+        hashes[source] = etag
+        built.append((source, path, ctype, versioned, len(text.encode("utf-8")), raw, gz, etag))
+
+    out = [
+        "#pragma once\n",
+        "// ==========================================",
+        "// DASHBOARD ASSETS (GENERATED)",
+        "// ==========================================",
+        "// Written by code/web/build_assets.py from the sources in code/web/.",
+        "// Do not edit; change the sources and re-run the script.",
+        "//",
+        "//   path              source  minified  gzip",
+    ]
+    for source, path, _, _, src_len, raw, gz, _ in built:
+        out.append("//   %-17s %-7d %-9d %d" % (path, src_len, len(raw), len(gz)))
+    out += ["", '#include "static_assets.h"', ""]
+    names = []
+    for source, path, ctype, versioned, _, _, gz, etag in built:
+        name = "kAsset_" + re.sub(r"\W", "_", source)
+        names.append((name, path, ctype, versioned, etag))
+        out.append(c_array(name, gz))
+    out.append("static const StaticAsset kStaticAssets[] = {")
+    for name, path, ctype, versioned, etag in names:
+        out.append('  { "%s", "%s", %s, sizeof(%s), "\\"%s\\"", %s },'
+                   % (path, ctype, name, name, etag, "true" if versioned else "false"))
+    out.append("};")
+    out.append("constexpr uint8_t kStaticAssetCount = sizeof(kStaticAssets) / sizeof(kStaticAssets[0]);")
+
+    with open(HEADER_PATH, "w", encoding="utf-8") as f:
+        f.write("\n".join(out) + "\n")
+
+    total_src = sum(b[4] for b in built)
+    total_gz = sum(len(b[6]) for b in built)
+    print("Wrote %s" % os.path.normpath(HEADER_PATH))
+    for source, path, _, _, src_len, raw, gz, etag in built:
+        print("  %-15s %6d -> %5d bytes gzip  (etag %s)" % (source, src_len, len(gz), etag))
+    print("  total           %6d -> %5d bytes (%.0f%% smaller)"
+          % (total_src, total_gz, 100.0 * (1 - total_gz / total_src)))
+
+
+if __name__ == "__main__":
+    main()
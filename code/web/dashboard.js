@@ -0,0 +1,27 @@
+// Live dashboard: the first event is the full state, later ones only the
+// keys that changed (see taskLive in code.ino).
+const $ = i => document.getElementById(i);
+const es = new EventSource('/events');
+es.onopen = () => document.body.classList.remove('offline');
+es.onerror = () => document.body.classList.add('offline');
+es.onmessage = e => {
+  const d = JSON.parse(e.data);
+  if ('t' in d) $('t').textContent = d.t.toFixed(1);
+  if ('h' in d) $('h').textContent = d.h.toFixed(1);
+  if ('g' in d) $('g').textContent = d.g;
+  if ('gf' in d) $('gf').textContent = d.gf;
+  if ('gs' in d) $('gs').textContent = (d.gs < 0 ? '' : '+') + d.gs.toFixed(1);
+  if ('fan' in d) {
+    $('fc').classList.toggle('on', !!d.fan);
+    $('fv').textContent = d.fan ? '⚙️ PURGING AIR' : 'OFF';
+  }
+  if ('m' in d) {
+    $('mc').classList.toggle('on', !!d.m);
+    $('mv').textContent = d.m ? '🚨 MOVEMENT DETECTED! 🚨' : 'No Motion';
+  }
+  if ('a' in d) {
+    const safe = d.a == 'SAFE';
+    $('st').className = 'status-banner ' + (safe ? 'safe' : 'danger');
+    $('st').textContent = (safe ? '✅' : '🚨') + ' SYSTEM STATUS: ' + d.a;
+  }
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+// ==========================================
+// NON-BLOCKING WIFI CONNECTION MANAGER
+// ==========================================
+// setup() no longer waits for the router: sensing, fan and alarms run from
+// the first millisecond, and this state machine brings the link up (and
+// back up) in the background.
+//
+// After every successful connection the access point's BSSID and channel,
+// plus the IP settings, are cached in RTC memory (survives resets) and in
+// flash (survives power cycles; rewritten only when they change). The next
+// attempt goes straight to that AP on that channel, skipping the scan,
+// which usually reassociates in well under a second. If the fast attempt
+// fails, the manager falls back to a normal scan, then to exponential
+// backoff between attempts.
+//
+// With WIFI_REUSE_IP the cached DHCP lease is reused as a static address
+// on fast reconnects, which also skips DHCP. Only enable it if the router
+// keeps leases stable (or reserves one for the node).
+
+#include <LittleFS.h>
+#include "platform.h"
+#include "rtc_store.h"
+
+#define WIFI_FAST_TIMEOUT_MS 4000     // Attempt with the cached BSSID/channel
+#define WIFI_CONNECT_TIMEOUT_MS 20000 // Attempt with a full scan
+#define WIFI_BACKOFF_MIN_MS 2000
+#define WIFI_BACKOFF_MAX_MS 120000
+#define WIFI_REUSE_IP 0               // 1 = reuse the last lease on fast reconnects
+#define WIFI_CACHE_FILE "/wifi_cache"
+
+struct WifiCache {
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip, gateway, mask, dns;
+};
+
+class WifiManager {
+ public:
+  enum State { OFF, CONNECTING, CONNECTED, BACKOFF };
+
+  void begin(const char* ssid, const char* password) {
+    ssid_ = ssid;
+    password_ = password;
+    WiFi.persistent(false);       // We keep our own cache; no SDK flash writes
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false); // Reconnects are ours, with backoff
+    haveCache_ = rtcLoad(RTC_SLOT_WIFI, cache_) || loadFlashCache();
+    startAttempt(millis());
+  }
+
+  // Fixed address instead of DHCP (call before begin())
+  void setStaticIp(IPAddress ip, IPAddress gateway, IPAddress mask, IPAddress dns) {
+    staticIp_ = ip;
+    staticGateway_ = gateway;
+    staticMask_ = mask;
+    staticDns_ = dns;
+    useStatic_ = true;
+  }
+
+  void poll() {
+    uint32_t now = millis();
+    bool up = WiFi.status() == WL_CONNECTED;
+
+    switch (state_) {
+      case OFF:
+        return;
+
+      case CONNECTING:
+        if (up) {
+          onConnected(now);
+          return;
+        }
+        if (now - attemptStartMs_ < (fast_ ? WIFI_FAST_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS)) return;
+        if (fast_) {
+          // Router moved to another channel, or the AP is gone: scan
+          fastMisses++;
+          haveCache_ = false;
+          startAttempt(now);
+          return;
+        }
+        failures++;
+        WiFi.disconnect();
+        backoffMs_ = backoffMs_ ? backoffMs_ * 2 : WIFI_BACKOFF_MIN_MS;
+        if (backoffMs_ > WIFI_BACKOFF_MAX_MS) backoffMs_ = WIFI_BACKOFF_MAX_MS;
+        retryAt_ = now + backoffMs_;
+        state_ = BACKOFF;
+        Serial.printf("WiFi: connect failed, retry in %u s\n", (unsigned)(backoffMs_ / 1000));
+        return;
+
+      case CONNECTED:
+        if (up) return;
+        disconnects++;
+        Serial.println("WiFi: link lost, reconnecting");
+        haveCache_ = true; // Same AP is the best first guess
+        startAttempt(now);
+        return;
+
+      case BACKOFF:
+        if ((int32_t)(now - retryAt_) < 0) return;
+        haveCache_ = rtcLoad(RTC_SLOT_WIFI, cache_);
+        startAttempt(now);
+        return;
+    }
+  }
+
+  // Modem sleep: switch the radio off until wake() (power_manager.h)
+  void sleep() {
+    if (state_ == OFF) return;
+    WiFi.disconnect();
+    platformRadioOff();
+    state_ = OFF;
+  }
+
+  // Radio back on; the cached AP usually makes this a fast reconnect
+  void wake() {
+    if (state_ != OFF || !ssid_) return;
+    platformRadioOn();
+    delay(1);
+    WiFi.mode(WIFI_STA);
+    backoffMs_ = 0;
+    startAttempt(millis());
+  }
+
+  State state() const { return state_; }
+  bool radioOn() const { return state_ != OFF; }
+  bool connected() const { return state_ == CONNECTED; }
+  int32_t rssi() const { return state_ == CONNECTED ? WiFi.RSSI() : 0; }
+
+  const char* stateName() const {
+    switch (state_) {
+      case CONNECTING: return fast_ ? "fast-connect" : "connecting";
+      case CONNECTED: return "connected";
+      case BACKOFF: return "backoff";
+      default: return "off";
+    }
+  }
+
+  // Stats
+  uint32_t connects = 0;      // Successful associations (first one included)
+  uint32_t fastConnects = 0;  // ...of which used the cached BSSID/channel
+  uint32_t fastMisses = 0;    // Cached attempts that timed out
+  uint32_t failures = 0;      // Full attempts that timed out
+  uint32_t disconnects = 0;   // Established links that dropped
+  uint32_t lastConnectMs = 0; // Duration of the last successful attempt
+
+ private:
+  void startAttempt(uint32_t now) {
+    fast_ = haveCache_;
+    if (useStatic_) {
+      WiFi.config(staticIp_, staticGateway_, staticMask_, staticDns_);
+    } else if (WIFI_REUSE_IP && fast_ && cache_.ip) {
+      WiFi.config(IPAddress(cache_.ip), IPAddress(cache_.gateway), IPAddress(cache_.mask),
+                  IPAddress(cache_.dns));
+    } else {
+      WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0)); // DHCP
+    }
+    if (fast_) WiFi.begin(ssid_, password_, cache_.channel, cache_.bssid, true);
+    else WiFi.begin(ssid_, password_);
+    attemptStartMs_ = now;
+    state_ = CONNECTING;
+  }
+
+  void onConnected(uint32_t now) {
+    lastConnectMs = now - attemptStartMs_;
+    connects++;
+    if (fast_) fastConnects++;
+    backoffMs_ = 0;
+    state_ = CONNECTED;
+    Serial.printf("WiFi Connected in %u ms%s, RSSI %d dBm\n", (unsigned)lastConnectMs,
+                  fast_ ? " (cached AP)" : "", (int)WiFi.RSSI());
+    Serial.print("IP Address for your Webpage: ");
+    Serial.println(WiFi.localIP());
+
+    WifiCache fresh = {};
+    memcpy(fresh.bssid, WiFi.BSSID(), sizeof(fresh.bssid));
+    fresh.channel = WiFi.channel();
+    fresh.ip = (uint32_t)WiFi.localIP();
+    fresh.gateway = (uint32_t)WiFi.gatewayIP();
+    fresh.mask = (uint32_t)WiFi.subnetMask();
+    fresh.dns = (uint32_t)WiFi.dnsIP();
+    bool changed = !haveFlashCache_ || memcmp(&fresh, &flashCache_, sizeof(fresh)) != 0;
+    cache_ = fresh;
+    haveCache_ = true;
+    rtcSave(RTC_SLOT_WIFI, cache_);
+    if (changed) saveFlashCache();
+  }
+
+  bool loadFlashCache() {
+    File f = LittleFS.open(WIFI_CACHE_FILE, "r");
+    if (!f) return false;
+    RtcSlot<WifiCache> slot;
+    bool ok = f.read((uint8_t*)&slot, sizeof(slot)) == sizeof(slot) &&
+              slot.crc == rtcCrc(&slot.value, sizeof(slot.value), sizeof(slot.value));
+    f.close();
+    if (!ok) return false;
+    cache_ = flashCache_ = slot.value;
+    haveFlashCache_ = true;
+    return true;
+  }
+
+  // Same CRC framing as the RTC copy. Needs LittleFS mounted (the journal
+  // does that); otherwise only the RTC copy is kept.
+  void saveFlashCache() {
+    File f = LittleFS.open(WIFI_CACHE_FILE, "w");
+    if (!f) return;
+    RtcSlot<WifiCache> slot = { rtcCrc(&cache_, sizeof(cache_), sizeof(cache_)), cache_ };
+    f.write((const uint8_t*)&slot, sizeof(slot));
+    f.close();
+    flashCache_ = cache_;
+    haveFlashCache_ = true;
+  }
+
+  const char* ssid_ = nullptr;
+  const char* password_ = nullptr;
+  State state_ = OFF;
+  bool fast_ = false;
+  uint32_t attemptStartMs_ = 0;
+  uint32_t retryAt_ = 0;
+  uint32_t backoffMs_ = 0;
+
+  WifiCache cache_ = {};
+  bool haveCache_ = false;
+  WifiCache flashCache_ = {};
+  bool haveFlashCache_ = false;
+
+  bool useStatic_ = false;
+  IPAddress staticIp_, staticGateway_, staticMask_, staticDns_;
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+// ==========================================
+// WINDOWED UPLOAD AGGREGATES (PORTABLE CORE)
+// ==========================================
+// A ThingSpeak channel serves at most 8000 points per request, which at one
+// point per sample is under two days of training data. With UPLOAD_WINDOW_S
+// set, the control side summarises each window instead and ThingSpeak gets
+// one point per window (300 s: 8000 points = 27 days).
+//
+// The window is fed at the sensors' own rate, not the 15 s sample rate:
+// every good DHT reading (1 Hz for a DHT11), the gas channel once a second,
+// and the fan state with the time it held. Nothing is buffered. Each value
+// updates running sums in O(1) time and memory (Welford's method, so a
+// float keeps its precision over an hour of readings):
+//   temperature, humidity   min, max, mean, std
+//   raw gas                 max, mean, std
+//   filtered gas            mean, least-squares slope (counts/min)
+//   motion                  PIR events (from the history samples)
+//   fan                     share of the window the relay was on
+//   grain probes            hottest and wettest reading (GRAIN_PROBES)
+// Windows that close are kept in a WindowLog until ThingSpeak accepts them.
+// Each one notes the history samples it covers, so the samples of windows
+// that never got out (a long outage, a reboot) are still in the flash
+// journal; the uploader folds them into windows again (SampleWindowFolder).
+//
+// A summary is stored in fixed point, like the history, which also bounds
+// how wide its ThingSpeak entry can get (silo_payload.h).
+
+#include <Arduino.h>
+#include <math.h>
+#include "sample_history.h"          // HISTORY_TEMP_NONE, SAMPLE_PERIOD_MS
+
+#define WINDOW_LOG_MAX 64            // Summaries kept for upload (5.3 h at 300 s)
+#define WINDOW_HUM_NONE 0xFFFF
+#define WINDOW_FAN_UNKNOWN 0xFF      // Folded from journal samples: no fan record
+
+// Count, mean, spread and range of one value, in O(1)
+class RunningStats {
+ public:
+  void reset() { *this = RunningStats(); }
+
+  void add(float x) {
+    n_++;
+    float d = x - mean_;
+    mean_ += d / n_;
+    m2_ += d * (x - mean_);
+    if (n_ == 1 || x < min_) min_ = x;
+    if (n_ == 1 || x > max_) max_ = x;
+  }
+
+  uint32_t count() const { return n_; }
+  float mean() const { return n_ ? mean_ : NAN; }
+  float min() const { return n_ ? min_ : NAN; }
+  float max() const { return n_ ? max_ : NAN; }
+  // Sample standard deviation (pandas' std()); 0 for a single value
+  float std() const { return n_ > 1 ? sqrtf(m2_ / (n_ - 1)) : (n_ ? 0.0f : NAN); }
+
+ private:
+  uint32_t n_ = 0;
+  float mean_ = 0;
+  float m2_ = 0;
+  float min_ = 0;
+  float max_ = 0;
+};
+
+// Least-squares line through (t, y), in O(1). Centred like RunningStats, so
+// an hour of seconds squared doesn't swamp the float.
+class RunningSlope {
+ public:
+  void reset() { *this = RunningSlope(); }
+
+  void add(float t, float y) {
+    n_++;
+    float dt = t - meanT_;
+    meanT_ += dt / n_;
+    meanY_ += (y - meanY_) / n_;
+    sxx_ += dt * (t - meanT_);
+    sxy_ += dt * (y - meanY_);
+  }
+
+  // dy per unit of t; 0 until two distinct times are in
+  float slope() const { return sxx_ > 0 ? sxy_ / sxx_ : 0.0f; }
+
+ private:
+  uint32_t n_ = 0;
+  float meanT_ = 0;
+  float meanY_ = 0;
+  float sxx_ = 0;
+  float sxy_ = 0;
+};
+
+struct WindowSummary {
+  uint32_t endMs;                    // millis() when the window closed
+  uint32_t firstSeq;                 // History samples it covers: [firstSeq, endSeq),
+  uint32_t endSeq;                   // set by WindowLog
+  uint16_t seconds;                  // Its length (the first one after boot may be short)
+  uint16_t readings;                 // Climate readings in it; 0 = the DHT was silent
+  int16_t tempMin, tempMax, tempMean; // centi-degrees C, HISTORY_TEMP_NONE without readings
+  uint16_t tempStd;                  // centi-degrees C
+  uint16_t humMin, humMax, humMean;  // centi-percent, WINDOW_HUM_NONE without readings
+  uint16_t humStd;                   // centi-percent
+  uint16_t gasMean, gasStd;          // Raw MQ-2, tenths of a count
+  uint16_t gasMax;
+  uint16_t gasFilteredMean;          // Tenths of a count
+  int16_t gasSlope;                  // Filtered, tenths of a count per minute
+  uint16_t motion;                   // PIR events
+  int16_t grainTempMax;              // Hottest probe, centi-degrees C, HISTORY_TEMP_NONE = none
+  uint8_t grainHumMax;               // Wettest probe, half-percent, HISTORY_HUM_NONE = none
+  uint8_t fanDutyPct;                // WINDOW_FAN_UNKNOWN when folded from samples
+};
+
+// Fixed point, saturating like the history's encoders
+inline int16_t windowCenti(float v) {
+  return isnan(v) ? HISTORY_TEMP_NONE : (int16_t)constrain(lroundf(v * 100.0f), -32767L, 32767L);
+}
+inline uint16_t windowCentiU(float v) {
+  return isnan(v) ? WINDOW_HUM_NONE : (uint16_t)constrain(lroundf(v * 100.0f), 0L, 65534L);
+}
+inline uint16_t windowTenths(float v) {
+  return isnan(v) ? 0 : (uint16_t)constrain(lroundf(v * 10.0f), 0L, 65535L);
+}
+
+// Climate and gas statistics into a summary
+inline void packWindow(WindowSummary& s, const RunningStats& temp, const RunningStats& hum,
+                       const RunningStats& gas, const RunningStats& gasFiltered,
+                       const RunningSlope& gasTrend) {
+  s.readings = temp.count() > 65535 ? 65535 : temp.count();
+  s.tempMin = windowCenti(temp.min());
+  s.tempMax = windowCenti(temp.max());
+  s.tempMean = windowCenti(temp.mean());
+  s.tempStd = windowCentiU(temp.std());
+  s.humMin = windowCentiU(hum.min());
+  s.humMax = windowCentiU(hum.max());
+  s.humMean = windowCentiU(hum.mean());
+  s.humStd = windowCentiU(hum.std());
+  s.gasMean = windowTenths(gas.mean());
+  s.gasStd = windowTenths(gas.std());
+  s.gasMax = gas.count() ? (uint16_t)constrain(lroundf(gas.max()), 0L, 65535L) : 0;
+  s.gasFilteredMean = windowTenths(gasFiltered.mean());
+  s.gasSlope = (int16_t)constrain(lroundf(gasTrend.slope() * 10.0f), -32767L, 32767L);
+}
+
+class WindowAggregator {
+ public:
+  // 0 disables the windows
+  void begin(uint32_t windowMs, uint32_t now) {
+    windowMs_ = windowMs;
+    open(now);
+  }
+
+  bool enabled() const { return windowMs_ != 0; }
+
+  void addClimate(float temp, float hum) {
+    temp_.add(temp);
+    hum_.add(hum);
+  }
+
+  void addMotion(uint8_t events) { motion_ += events; }
+
+  void addGrain(float temp, float hum) {
+    int16_t t = windowCenti(temp);
+    uint8_t h = isnan(hum) ? HISTORY_HUM_NONE : (uint8_t)constrain(lroundf(hum * 2.0f), 0L, 200L);
+    if (t != HISTORY_TEMP_NONE && (grainTemp_ == HISTORY_TEMP_NONE || t > grainTemp_)) grainTemp_ = t;
+    if (h != HISTORY_HUM_NONE && (grainHum_ == HISTORY_HUM_NONE || h > grainHum_)) grainHum_ = h;
+  }
+
+  // Once a second or so: gas and the fan, weighted by the time since the
+  // last tick. Returns true when the window closed into out.
+  bool tick(uint32_t now, int gas, int gasFiltered, bool fanOn, WindowSummary& out) {
+    if (!enabled()) return false;
+    if (fanOn) fanOnMs_ += now - lastTickMs_;
+    lastTickMs_ = now;
+    gas_.add(gas);
+    gasFiltered_.add(gasFiltered);
+    gasTrend_.add((now - startMs_) / 60000.0f, gasFiltered);
+    if (now - startMs_ < windowMs_) return false;
+    close(now, out);
+    open(now);
+    return true;
+  }
+
+ private:
+  void open(uint32_t now) {
+    startMs_ = lastTickMs_ = now;
+    fanOnMs_ = 0;
+    motion_ = 0;
+    grainTemp_ = HISTORY_TEMP_NONE;
+    grainHum_ = HISTORY_HUM_NONE;
+    temp_.reset();
+    hum_.reset();
+    gas_.reset();
+    gasFiltered_.reset();
+    gasTrend_.reset();
+  }
+
+  void close(uint32_t now, WindowSummary& s) {
+    uint32_t ms = now - startMs_;
+    s = WindowSummary();
+    s.endMs = now;
+    s.seconds = ms / 1000 > 65535 ? 65535 : ms / 1000;
+    packWindow(s, temp_, hum_, gas_, gasFiltered_, gasTrend_);
+    s.motion = motion_;
+    s.grainTempMax = grainTemp_;
+    s.grainHumMax = grainHum_;
+    s.fanDutyPct = ms ? (uint64_t)fanOnMs_ * 100 / ms : 0;
+  }
+
+  uint32_t windowMs_ = 0;
+  uint32_t startMs_ = 0;
+  uint32_t lastTickMs_ = 0;
+  uint32_t fanOnMs_ = 0;
+  uint16_t motion_ = 0;
+  int16_t grainTemp_ = HISTORY_TEMP_NONE;
+  uint8_t grainHum_ = HISTORY_HUM_NONE;
+  RunningStats temp_;
+  RunningStats hum_;
+  RunningStats gas_;
+  RunningStats gasFiltered_;
+  RunningSlope gasTrend_;
+};
+
+// Closed windows waiting for ThingSpeak, numbered like the history samples
+class WindowLog {
+ public:
+  // historyNextSeq: the history's nextSeq() when the window arrives. The
+  // window covers the samples since the previous one.
+  void push(const WindowSummary& s, uint32_t historyNextSeq) {
+    WindowSummary& w = log_[nextSeq_++ % WINDOW_LOG_MAX];
+    w = s;
+    w.firstSeq = nextSample_;
+    w.endSeq = nextSample_ = historyNextSeq;
+  }
+
+  // Sequence numbers currently held: [oldestSeq(), nextSeq())
+  uint32_t nextSeq() const { return nextSeq_; }
+  uint32_t oldestSeq() const { return nextSeq_ > WINDOW_LOG_MAX ? nextSeq_ - WINDOW_LOG_MAX : 0; }
+  const WindowSummary& at(uint32_t seq) const { return log_[seq % WINDOW_LOG_MAX]; }
+
+  // First history sample of the window still open
+  uint32_t openSeq() const { return nextSample_; }
+
+ private:
+  WindowSummary log_[WINDOW_LOG_MAX];
+  uint32_t nextSeq_ = 0;
+  uint32_t nextSample_ = 0;
+};
+
+// Journal samples (or any 15 s samples) folded into one window, for the
+// backfill: the same statistics at SAMPLE_PERIOD_MS instead of 1 Hz, no
+// fan duty. temp is centi-degrees and hum half-percent, as the history
+// stores them; times are seconds.
+class SampleWindowFolder {
+ public:
+  void add(uint32_t timeS, int16_t tempCenti, uint8_t humHalf, uint16_t gas, uint16_t gasFiltered,
+           uint8_t motion) {
+    if (!samples_) firstS_ = timeS;
+    lastS_ = timeS;
+    samples_++;
+    if (tempCenti != HISTORY_TEMP_NONE && humHalf != HISTORY_HUM_NONE) {
+      temp_.add(tempCenti / 100.0f);
+      hum_.add(humHalf / 2.0f);
+    }
+    gas_.add(gas);
+    gasFiltered_.add(gasFiltered);
+    gasTrend_.add((timeS - firstS_) / 60.0f, gasFiltered);
+    motion_ += motion;
+  }
+
+  WindowSummary summary() const {
+    WindowSummary s = WindowSummary();
+    uint32_t seconds = lastS_ - firstS_ + SAMPLE_PERIOD_MS / 1000;
+    s.seconds = seconds > 65535 ? 65535 : seconds;
+    packWindow(s, temp_, hum_, gas_, gasFiltered_, gasTrend_);
+    s.motion = motion_;
+    s.grainTempMax = HISTORY_TEMP_NONE;
+    s.grainHumMax = HISTORY_HUM_NONE;
+    s.fanDutyPct = WINDOW_FAN_UNKNOWN;
+    return s;
+  }
+
+ private:
+  uint32_t samples_ = 0;
+  uint32_t firstS_ = 0;
+  uint32_t lastS_ = 0;
+  uint16_t motion_ = 0;
+  RunningStats temp_;
+  RunningStats hum_;
+  RunningStats gas_;
+  RunningStats gasFiltered_;
+  RunningSlope gasTrend_;
+};
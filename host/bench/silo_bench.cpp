@@ -0,0 +1,364 @@
+// ==========================================
+// SILO PIPELINE BENCHMARK (HOST)
+// ==========================================
+// Replays a recorded trace through the same code the firmware runs: gas
+// filtering, fan policy, alarm decision, history, anomaly scoring, the
+// humidity forecast, upload payloads and the /lite page. Time and the ADC
+// are simulated (host/shims), so a day of data replays in well under a
+// second and the decisions come out the same on every machine.
+//
+// Per sample period (one trace row) the firmware's 50 ms control ticks
+// are run in full, then the once-per-sample work. Each stage reports:
+//   - latency per call (mean, p50, p99, max) in host nanoseconds. These
+//     are for comparing builds, not a prediction of ESP8266 timings;
+//   - heap allocations per call (operator new is counted). The firmware
+//     paths are meant to be allocation-free, so the benchmark fails
+//     (exit code 1) if any stage allocates once warmed up;
+//   - bytes produced, for the payload and rendering stages.
+// A digest of every tick's decision (alert, buzzer, fan) is printed too:
+// if it changes between two builds, behaviour changed, not just speed.
+//
+// Usage: silo_bench [trace.csv] [--repeat N]
+// The trace is ml/data/silo_data_latest.csv (from ml/fetch_data.py) by
+// default. Without it, a synthetic day with a humidity spike, a gas event
+// and a few intrusions is replayed instead.
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#include "alert_digest.h"
+#include "anomaly_scorer.h"
+#include "dashboard_render.h"
+#include "fan_controller.h"
+#include "gas_channel.h"
+#include "mold_forecaster.h"
+#include "sample_history.h"
+#include "silo_logic.h"
+#include "silo_payload.h"
+
+#ifndef SILO_DEFAULT_TRACE
+#define SILO_DEFAULT_TRACE "ml/data/silo_data_latest.csv"
+#endif
+
+// Firmware constants that live in code.ino
+#define HUM_ALARM_PCT 60.0f
+#define CONTROL_TICK_MS 50           // gas and alarm task period
+#define FAN_TICK_DIVIDER 10          // fan task runs every 500 ms
+#define MAX_GAP_MS 300000            // Longer trace gaps are shortened to this
+
+// ---> ALLOCATION COUNTER <---
+static uint64_t allocations = 0;
+
+void* operator new(size_t n) {
+  allocations++;
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ---> TRACE <---
+struct TraceRow {
+  uint32_t dtMs;   // Since the previous row
+  float temp;      // NaN = missing
+  float hum;
+  uint16_t gas;
+  uint8_t motion;  // PIR events in the period
+};
+
+static bool parseTime(const std::string& s, int64_t& epochS) {
+  int y, mo, d, h, mi, sec;
+  if (sscanf(s.c_str(), "%d-%d-%d%*c%d:%d:%d", &y, &mo, &d, &h, &mi, &sec) != 6) return false;
+  // Days from civil (proleptic Gregorian), good for any year we'll see
+  y -= mo <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  epochS = (era * 146097 + doe - 719468) * 86400 + h * 3600 + mi * 60 + sec;
+  return true;
+}
+
+static float parseFloat(const std::string& s) {
+  if (s.empty()) return NAN;
+  char* end;
+  float v = strtof(s.c_str(), &end);
+  return end == s.c_str() ? NAN : v;
+}
+
+// Columns as written by ml/fetch_data.py; others are ignored
+static bool loadTrace(const char* path, std::vector<TraceRow>& rows) {
+  std::ifstream in(path);
+  std::string line;
+  if (!in || !std::getline(in, line)) return false;
+  std::vector<std::string> names;
+  std::stringstream header(line);
+  for (std::string cell; std::getline(header, cell, ',');) names.push_back(cell);
+  auto column = [&](const char* name) {
+    auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? -1 : (int)(it - names.begin());
+  };
+  int cTime = column("timestamp"), cTemp = column("temperature"), cHum = column("humidity");
+  int cGas = column("gas_value"), cMotion = column("motion");
+  if (cTemp < 0 || cHum < 0 || cGas < 0) {
+    fprintf(stderr, "%s: needs temperature, humidity and gas_value columns\n", path);
+    return false;
+  }
+
+  int64_t prevS = 0;
+  bool havePrev = false;
+  std::vector<std::string> cells;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) continue;
+    cells.clear();
+    std::stringstream ss(line);
+    for (std::string cell; std::getline(ss, cell, ',');) cells.push_back(cell);
+    cells.resize(names.size());
+
+    TraceRow r;
+    r.dtMs = SAMPLE_PERIOD_MS;
+    int64_t s;
+    if (cTime >= 0 && parseTime(cells[cTime], s)) {
+      if (havePrev && s > prevS) r.dtMs = (uint32_t)std::min<int64_t>((s - prevS) * 1000, MAX_GAP_MS);
+      prevS = s;
+      havePrev = true;
+    }
+    r.temp = parseFloat(cells[cTemp]);
+    r.hum = parseFloat(cells[cHum]);
+    float gas = parseFloat(cells[cGas]);
+    r.gas = isnan(gas) ? 0 : (uint16_t)constrain(lroundf(gas), 0L, 1023L);
+    float motion = cMotion >= 0 ? parseFloat(cells[cMotion]) : NAN;
+    r.motion = isnan(motion) ? 0 : (uint8_t)constrain(lroundf(motion), 0L, 15L);
+    rows.push_back(r);
+  }
+  return !rows.empty();
+}
+
+// 24 h at SAMPLE_PERIOD_MS: daily temperature/humidity swing, a humidity
+// spike in the afternoon, a gas event in the evening, motion at night
+static void synthTrace(std::vector<TraceRow>& rows) {
+  const uint32_t n = 86400000UL / SAMPLE_PERIOD_MS;
+  for (uint32_t i = 0; i < n; i++) {
+    float hour = i * (SAMPLE_PERIOD_MS / 3600000.0f);
+    float day = sinf((hour - 9) * (float)M_PI / 12);
+    TraceRow r;
+    r.dtMs = SAMPLE_PERIOD_MS;
+    r.temp = 27 + 4 * day;
+    r.hum = 52 - 6 * day + (hour >= 14 && hour < 16 ? 14 : 0);
+    r.gas = 60 + (uint16_t)(5 * day + 5) + (hour >= 20 && hour < 20.2f ? 90 : 0);
+    r.motion = (hour >= 2 && hour < 2.05f) || (hour >= 23 && hour < 23.02f) ? 2 : 0;
+    if (hour >= 6 && hour < 6.1f) r.temp = r.hum = NAN;  // DHT dropout
+    rows.push_back(r);
+  }
+}
+
+// ---> MEASUREMENT <---
+using Clock = std::chrono::steady_clock;
+
+struct Stage {
+  Stage(const char* name, const char* unit) : name(name), unit(unit) {}
+
+  const char* name;
+  const char* unit;
+  std::vector<uint32_t> ns;
+  uint64_t allocs = 0;       // After the first call
+  uint64_t bytes = 0;
+
+  Clock::time_point start;
+  uint64_t allocsAtStart = 0;
+
+  void begin() {
+    allocsAtStart = allocations;
+    start = Clock::now();
+  }
+  void end(size_t produced = 0) {
+    auto t = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    if (!ns.empty()) allocs += allocations - allocsAtStart;
+    ns.push_back((uint32_t)std::min<int64_t>(t, UINT32_MAX));
+    bytes += produced;
+  }
+
+  void report() {
+    std::vector<uint32_t> sorted(ns);
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t sum = 0;
+    for (uint32_t v : sorted) sum += v;
+    size_t n = sorted.size();
+    printf("%-9s %-7s %8zu %9.0f %9u %9u %9u %8.2f %9.1f\n", name, unit, n, (double)sum / n,
+           sorted[n / 2], sorted[std::min(n - 1, n * 99 / 100)], sorted[n - 1],
+           n > 1 ? (double)allocs / (n - 1) : 0.0, (double)bytes / n);
+  }
+};
+
+// FNV-1a over every tick's decision
+struct Digest {
+  uint32_t h = 2166136261u;
+  void add(uint8_t b) { h = (h ^ b) * 16777619u; }
+};
+
+int main(int argc, char** argv) {
+  const char* path = SILO_DEFAULT_TRACE;
+  bool explicitPath = false;
+  unsigned repeat = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = std::max(1, atoi(argv[++i]));
+    else {
+      path = argv[i];
+      explicitPath = true;
+    }
+  }
+
+  std::vector<TraceRow> rows;
+  const char* source = path;
+  if (!loadTrace(path, rows)) {
+    if (explicitPath) {
+      fprintf(stderr, "Can't read trace %s\n", path);
+      return 2;
+    }
+    synthTrace(rows);
+    source = "synthetic day (no ml/data/silo_data_latest.csv; run ml/fetch_data.py)";
+  }
+  uint64_t traceMs = 0;
+  for (const TraceRow& r : rows) traceMs += r.dtMs;
+  printf("Trace: %s\n", source);
+  printf("       %zu samples, %.1f h, replayed %u time(s)\n\n", rows.size(), traceMs / 3600000.0, repeat);
+
+  // The pipeline, wired as in code.ino
+  static SampleHistory history;
+  GasChannel gas(A0);
+  FanController fan;
+  AnomalyScorer anomaly(history);
+  MoldForecaster forecast;
+  ESP8266WebServer server;
+  server.body.reserve(4096);
+
+  SiloReadings r = {};
+  r.climateOk = false;
+  r.grainTemp = r.grainHum = NAN;  // No grain probes in the trace
+  bool fanOn = false;
+  AlarmEngine alarms(ALARM_RULES, ALARM_RULE_COUNT);
+  AlertDigest alertDigest;
+  AlarmDecision d = alarms.evaluate(r, { HUM_ALARM_PCT }, millis());
+  LiveView shown = liveView(r, fanOn, d.status);
+  uint32_t seed = 1;
+
+  Stage control("control", "period"), record("record", "sample");
+  Stage payload("payload", "sample"), render("render", "sample");
+  size_t calls = rows.size() * repeat;
+  for (Stage* s : { &control, &record, &payload, &render }) s->ns.reserve(calls);
+
+  uint32_t alerts[SILO_ALERT_COUNT] = {};
+  uint64_t ticks = 0, fanTicks = 0, telegrams = 0;
+  Digest digest;
+
+  for (unsigned pass = 0; pass < repeat; pass++) {
+    for (const TraceRow& row : rows) {
+      if (!isnan(row.temp) && !isnan(row.hum)) {
+        r.temp = row.temp;
+        r.hum = row.hum;
+        r.climateOk = true;
+      } else {
+        r.climateOk = false;  // Last good values stay, like a stale DHT
+      }
+      r.motion = row.motion > 0;
+
+      // Every control tick of the period: gas burst + filter, alarm, fan every 500 ms
+      uint32_t n = std::max<uint32_t>(1, row.dtMs / CONTROL_TICK_MS);
+      control.begin();
+      for (uint32_t t = 0; t < n; t++) {
+        hostAdvanceMs(CONTROL_TICK_MS);
+        seed = seed * 1103515245u + 12345u;
+        hostSetAnalog(A0, (uint16_t)std::max(0, row.gas + (int)((seed >> 16) % 7) - 3));  // ADC noise
+        gas.sample();
+        r.gas = gas.raw();
+        r.gasFiltered = gas.filtered();
+        r.gasSlope = gas.slopePerMin();
+        r.gasAlarm = gas.alarm();
+        if (t % FAN_TICK_DIVIDER == 0) fanOn = fan.update(millis(), r.temp, r.hum, r.climateOk, r.gasFiltered, r.gasAlarm);
+        SiloAlert before = d.code;
+        d = alarms.evaluate(r, { HUM_ALARM_PCT }, millis());
+        if (d.code != before) alerts[d.code]++;
+        for (uint8_t i = 0; i < alarms.eventCount(); i++) telegrams += alertDigest.add(alarms.event(i), r, millis());
+        char msg[160];  // TELEGRAM_MSG_MAX
+        telegrams += alertDigest.poll(millis(), d.status, msg, sizeof(msg)) > 0;
+        fanTicks += fanOn;
+        digest.add(d.code);
+        digest.add(d.buzzer);
+        digest.add(fanOn);
+      }
+      control.end();
+      ticks += n;
+
+      // The once-per-sample work (taskHistory)
+      record.begin();
+      history.push(millis(), r.climateOk ? r.temp : NAN, r.climateOk ? r.hum : NAN, r.gas, r.gasFiltered, row.motion);
+      r.fermentationRisk = anomaly.update() && anomaly.confirmed();
+      if (forecast.add(millis(), r.climateOk ? r.hum : NAN)) r.moldForecast = forecast.riskAhead(r.temp);
+      else if (!forecast.ready()) r.moldForecast = false;
+      fan.setPreempt(r.moldForecast);
+      record.end();
+
+      // What leaves the device: ThingSpeak entry, SiloFrame, /events delta and full state, Telegram request
+      char buf[200];  // LIVE_EVENT_MAX (live_events.h)
+      payload.begin();
+      uint32_t seq = history.nextSeq() - 1;
+      bool hasPrev = history.contains(seq - 1);
+      size_t produced = formatThingSpeakFields(buf, sizeof(buf), history.tempCentiAt(seq), history.humHalfAt(seq),
+                                               history.gasAt(seq), history.motionAt(seq), history.gasFilteredAt(seq),
+                                               hasPrev, hasPrev ? history.gasFilteredAt(seq - 1) : 0);
+      SiloFrame frame = frameFromHistory(history, seq, fanOn ? SILO_FLAG_FAN : 0, d.code);
+      produced += sizeof(frame);
+      LiveView v = liveView(r, fanOn, d.status);
+      produced += formatLive(buf, sizeof(buf), v, &shown);
+      produced += formatLive(buf, sizeof(buf), v, nullptr);
+      {
+        // The longest alert, percent-encoded into a Telegram request
+        ByteCounter request;
+        NetWriter<ByteCounter> w(request);
+        writeTelegramRequest(w, "0000000000:AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA", "0000000000",
+                             ALERT_TEXT[SILO_ALERT_FERMENTATION]);
+        w.flush();
+        produced += request.bytes;
+      }
+      payload.end(produced);
+
+      // The /lite page
+      server.reset();
+      render.begin();
+      renderLite(server, r, fanOn, d.status);
+      render.end(server.body.size());
+    }
+  }
+
+  printf("%-9s %-7s %8s %9s %9s %9s %9s %8s %9s\n", "stage", "per", "calls", "mean ns", "p50 ns",
+         "p99 ns", "max ns", "allocs", "bytes");
+  control.report();
+  record.report();
+  payload.report();
+  render.report();
+  printf("(control: %.0f ticks of %u ms per period)\n\n", (double)ticks / calls, CONTROL_TICK_MS);
+
+  printf("Decisions: fan on %.1f%% of ticks, %llu Telegram(s) sent\n", 100.0 * fanTicks / ticks,
+         (unsigned long long)telegrams);
+  printf("Notifications: %u raised, %u held back by cooldowns, %u reminders, %u escalations, %u cleared; "
+         "%u folded into %u digest(s)\n",
+         (unsigned)alarms.raised, (unsigned)alarms.suppressed, (unsigned)alarms.reminders,
+         (unsigned)alarms.escalated, (unsigned)alarms.cleared, (unsigned)alertDigest.folded, (unsigned)alertDigest.digests);
+  printf("Alerts raised:");
+  for (uint8_t i = 1; i < SILO_ALERT_COUNT; i++) printf(" %s=%u", ALERT_NAME[i], (unsigned)alerts[i]);
+  printf("\nDecision digest: %08x\n", (unsigned)digest.h);
+
+  uint64_t steady = control.allocs + record.allocs + payload.allocs + render.allocs;
+  if (steady) {
+    printf("\nFAIL: %llu heap allocation(s) on the firmware paths after warm-up\n", (unsigned long long)steady);
+    return 1;
+  }
+  return 0;
+}
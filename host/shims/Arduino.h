@@ -0,0 +1,97 @@
+#pragma once
+
+// ==========================================
+// HOST SHIM: ARDUINO CORE
+// ==========================================
+// Just enough of the ESP8266 Arduino core to compile the portable headers
+// in code/ on a PC (see host/CMakeLists.txt). Time and pins are simulated:
+//   - millis()/micros() return a clock that only moves when the host
+//     program calls hostAdvanceMs() (or delay()),
+//   - analogRead() returns whatever hostSetAnalog() last set for the pin,
+//   - digitalWrite() values can be read back with digitalRead().
+// PROGMEM is ordinary memory here, so the *_P functions and pgm_read_*
+// macros are plain reads.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using std::isnan;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define A0 17
+#define HOST_PINS 18
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+#define snprintf_P snprintf
+#define sprintf_P sprintf
+#define strcmp_P strcmp
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_float(p) (*(const float*)(p))
+
+// Simulated clock and pins
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+inline void yield() {}
+void hostAdvanceMs(uint32_t ms);
+void hostSetAnalog(uint8_t pin, uint16_t value);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+// The handful of String members the firmware uses, over std::string
+class String {
+ public:
+  String(const char* s = "") : s_(s ? s : "") {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(unsigned v) : s_(std::to_string(v)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned length() const { return s_.size(); }
+  int indexOf(const char* s) const {
+    size_t i = s_.find(s);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  int indexOf(const String& s) const { return indexOf(s.c_str()); }
+  void replace(const char* from, const char* to) {
+    size_t n = strlen(from), m = strlen(to);
+    if (!n) return;
+    for (size_t i = s_.find(from); i != std::string::npos; i = s_.find(from, i + m)) s_.replace(i, n, to);
+  }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  friend String operator+(String a, const String& b) { return a += b; }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return s_ == o; }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+
+ private:
+  std::string s_;
+};
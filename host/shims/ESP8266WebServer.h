@@ -0,0 +1,50 @@
+#pragma once
+
+// ==========================================
+// HOST SHIM: ESP8266WebServer
+// ==========================================
+// Captures what a handler sends instead of writing to a socket. The body
+// keeps its capacity across reset(), so after the first page the capture
+// itself doesn't allocate: whatever the allocation counter sees then is
+// the handler's own.
+
+#include "Arduino.h"
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+class ESP8266WebServer {
+ public:
+  explicit ESP8266WebServer(int port = 80) { (void)port; }
+
+  void reset() {
+    body.clear();
+    chunks = 0;
+    code = 0;
+  }
+
+  void setContentLength(size_t len) { (void)len; }
+  void sendHeader(const char* name, const char* value, bool first = false) { (void)name; (void)value; (void)first; }
+  void send(int status, const char* type, const char* content) {
+    (void)type;
+    code = status;
+    body += content;
+  }
+  void send(int status) { code = status; }
+  void send_P(int status, const char* type, PGM_P content, size_t len) {
+    (void)type;
+    code = status;
+    body.append(content, len);
+  }
+  void sendContent(const char* s) { sendContent(s, strlen(s)); }
+  void sendContent(const char* s, size_t len) {
+    body.append(s, len);
+    chunks++;
+  }
+  void sendContent(const String& s) { sendContent(s.c_str(), s.length()); }
+  void sendContent_P(PGM_P s) { sendContent(s); }
+  void sendContent_P(PGM_P s, size_t len) { sendContent(s, len); }
+
+  int code = 0;
+  std::string body;
+  uint32_t chunks = 0;  // Without the terminator
+};
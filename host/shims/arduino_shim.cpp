@@ -0,0 +1,28 @@
+// Simulated clock and pins behind host/shims/Arduino.h
+
+#include "Arduino.h"
+
+static uint64_t nowUs = 0;
+static uint16_t analogPins[HOST_PINS];
+static uint8_t digitalPins[HOST_PINS];
+
+uint32_t millis() { return (uint32_t)(nowUs / 1000); }
+uint32_t micros() { return (uint32_t)nowUs; }
+void delay(uint32_t ms) { hostAdvanceMs(ms); }
+void hostAdvanceMs(uint32_t ms) { nowUs += (uint64_t)ms * 1000; }
+
+void hostSetAnalog(uint8_t pin, uint16_t value) {
+  if (pin < HOST_PINS) analogPins[pin] = value;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < HOST_PINS) digitalPins[pin] = value;
+}
+
+int digitalRead(uint8_t pin) { return pin < HOST_PINS ? digitalPins[pin] : LOW; }
+int analogRead(uint8_t pin) { return pin < HOST_PINS ? analogPins[pin] : 0; }
@@ -33,8 +33,9 @@ from sklearn.preprocessing import StandardScaler
 from config import (
     DATA_DIR, MODEL_DIR, PLOT_DIR,
     ISOLATION_FOREST_CONTAMINATION,
-    ANOMALY_FEATURES,
+    ANOMALY_FEATURES, ANOMALY_MODEL_FEATURES,
     GAS_ALERT, HUMIDITY_ALERT,
+    SAMPLE_INTERVAL_S, UPLOAD_WINDOW_S,
 )
 
 
@@ -60,23 +61,49 @@ def load_data(path: str = None) -> pd.DataFrame:
     return df
 
 
+def is_windowed(df: pd.DataFrame) -> bool:
+    """True for rows that are upload windows (UPLOAD_WINDOW_S), not samples."""
+    return "window_s" in df.columns and df["window_s"].notna().any()
+
+
+def rolling_window(df: pd.DataFrame) -> int:
+    """Rolling window length (device samples) used for a dataset."""
+    if is_windowed(df):
+        # The window's own statistics stand in for the rolling ones
+        return max(3, min(30, int(df["window_s"].median() // SAMPLE_INTERVAL_S)))
+    # ~7.5 minutes at 15s intervals = 30 readings, smaller for tiny datasets
+    return max(3, min(30, len(df) // 4))
+
+
 def engineer_features(df: pd.DataFrame) -> pd.DataFrame:
     """
     Create derivative features that help Isolation Forest detect
     slow-developing anomalies that raw values miss.
+    
+    Keep in sync with code/anomaly_scorer.h, which computes the same
+    features on the ESP8266.
     """
     df = df.copy()
-    
-    # Rolling statistics (window = ~10 minutes at 20s intervals = 30 readings)
-    window = min(30, len(df) // 4)  # Adaptive window
-    if window < 3:
-        window = 3
-    
-    for col in ["temperature", "humidity", "gas_value"]:
-        df[f"{col}_rolling_mean"] = df[col].rolling(window, min_periods=1).mean()
-        df[f"{col}_rolling_std"] = df[col].rolling(window, min_periods=1).std().fillna(0)
-        # Rate of change (derivative)
-        df[f"{col}_rate"] = df[col].diff().fillna(0)
+    n_columns = len(df.columns)
+    
+    if is_windowed(df):
+        # One row per upload window: its mean and std are what the device's
+        # rolling mean and std see over a window of that length, and the
+        # rate is the change between windows spread over their samples.
+        steps = df["window_s"].fillna(UPLOAD_WINDOW_S).clip(lower=SAMPLE_INTERVAL_S) / SAMPLE_INTERVAL_S
+        for col, std in [("temperature", "temp_std"), ("humidity", "hum_std"), ("gas_value", "gas_std")]:
+            df[f"{col}_rolling_mean"] = df[col]
+            df[f"{col}_rolling_std"] = df[std].fillna(0)
+            df[f"{col}_rate"] = (df[col].diff() / steps).fillna(0)
+    else:
+        # Rolling statistics
+        window = rolling_window(df)
+        
+        for col in ["temperature", "humidity", "gas_value"]:
+            df[f"{col}_rolling_mean"] = df[col].rolling(window, min_periods=1).mean()
+            df[f"{col}_rolling_std"] = df[col].rolling(window, min_periods=1).std().fillna(0)
+            # Rate of change (derivative)
+            df[f"{col}_rate"] = df[col].diff().fillna(0)
     
     # Cross-sensor correlation features
     # High gas + rising temp + dropping humidity = fermentation signature
@@ -84,7 +111,7 @@ def engineer_features(df: pd.DataFrame) -> pd.DataFrame:
     df["temp_hum_diff"] = df["temperature"] - df["humidity"]
     
     df = df.fillna(0)
-    print(f"  [+] Engineered {len(df.columns) - 5} additional features")
+    print(f"  [+] Engineered {len(df.columns) - n_columns} additional features")
     return df
 
 
@@ -108,8 +135,8 @@ def train_isolation_forest(df: pd.DataFrame, contamination: float = None):
     print(f"  ISOLATION FOREST ANOMALY DETECTION")
     print(f"{'='*60}")
     
-    # Select all numeric feature columns (excluding timestamp/motion)
-    feature_cols = [c for c in df.columns if c not in ["timestamp", "motion", "anomaly", "anomaly_score"]]
+    # Fixed, ordered feature list: the exported on-device model depends on it
+    feature_cols = list(ANOMALY_MODEL_FEATURES)
     print(f"  Features: {len(feature_cols)}")
     print(f"  Contamination: {contamination:.1%}")
     
@@ -14,17 +14,37 @@ THINGSPEAK_READ_API_KEY = os.getenv("THINGSPEAK_READ_API_KEY", "YOUR_READ_API_KE
 THINGSPEAK_BASE_URL = "https://api.thingspeak.com"
 
 # ── Field Mapping (must match your ESP8266 code) ───────────────
+# With upload windows these are window values: means, PIR events in the
+# window, the gas slope fitted over it, the hottest and wettest probe
 FIELD_MAP = {
     "field1": "temperature",
     "field2": "humidity",
     "field3": "gas_value",
-    "field4": "motion",
+    "field4": "motion",       # PIR events per sample period (count)
+    "field5": "gas_filtered", # Median + EMA filtered MQ-2 value
+    "field6": "gas_slope",    # Filtered gas change (counts/min)
+    "field7": "grain_temp_max", # Hottest grain probe (GRAIN_PROBES firmware only)
+    "field8": "grain_hum_max",  # Wettest grain probe
 }
 
+# ── Sampling (must match SAMPLE_PERIOD_MS in code/sample_history.h) ──
+SAMPLE_INTERVAL_S = 15       # One reading every 15 s, uploaded in batches
+UPLOAD_WINDOW_S = 300        # UPLOAD_WINDOW_S in code.ino: one point per window; 0 = per sample
+
+# The rest of a window rides in the ThingSpeak status field, after "w1"
+# (formatThingSpeakWindow() in code/silo_payload.h); "-" = no reading
+WINDOW_STATUS_TAG = "w1"
+WINDOW_STATUS_COLUMNS = [
+    "window_s", "readings",
+    "temp_min", "temp_max", "temp_std",
+    "hum_min", "hum_max", "hum_std",
+    "gas_max", "gas_std", "fan_duty",
+]
+
 # ── Thresholds (must match your ESP8266 code) ──────────────────
 HUMIDITY_FAN_ON = 50.0       # Fan activates above this
 HUMIDITY_ALERT = 60.0        # Telegram alert threshold
-GAS_ALERT = 90               # Gas alarm threshold
+GAS_ALERT = 90               # Gas alarm threshold (filtered value, clears below 80)
 MOLD_GROWTH_TEMP_MIN = 20.0  # Mold risk zone (°C)
 MOLD_GROWTH_TEMP_MAX = 40.0
 MOLD_GROWTH_HUM_MIN = 65.0   # Mold risk zone (%)
@@ -39,15 +59,36 @@ for d in [DATA_DIR, MODEL_DIR, PLOT_DIR]:
     os.makedirs(d, exist_ok=True)
 
 # ── LSTM Forecasting Params ─────────────────────────────────────
-FORECAST_LOOKBACK = 72       # Use last 72 readings (~24 min at 20s interval)
-FORECAST_HORIZON = 8640      # Predict next 8640 readings (~48 hours ahead)
+FORECAST_LOOKBACK = 72       # Use last 72 readings (~18 min at 15s interval)
+FORECAST_HORIZON = 8640      # Predict next 8640 readings (~36 hours ahead)
 LSTM_EPOCHS = 50
 LSTM_BATCH_SIZE = 32
 
 # ── Anomaly Detection Params ────────────────────────────────────
 ISOLATION_FOREST_CONTAMINATION = 0.05  # Expected 5% anomaly rate
 ANOMALY_FEATURES = ["gas_value", "temperature", "humidity"]
+# Model inputs, in order (see engineer_features() and code/anomaly_scorer.h)
+ANOMALY_MODEL_FEATURES = [
+    "temperature", "humidity", "gas_value",
+    "temperature_rolling_mean", "temperature_rolling_std", "temperature_rate",
+    "humidity_rolling_mean", "humidity_rolling_std", "humidity_rate",
+    "gas_value_rolling_mean", "gas_value_rolling_std", "gas_value_rate",
+    "gas_temp_ratio", "temp_hum_diff",
+]
+ANOMALY_EXPORT_TREES = 32          # Trees in the on-device forest
+ANOMALY_EXPORT_MAX_SAMPLES = 64    # Samples per tree (limits depth to ~6)
 
 # ── Fan Optimization (RL) Params ────────────────────────────────
 RL_TOTAL_TIMESTEPS = 50_000
 RL_HUMIDITY_TARGET = 45.0    # Target humidity after fan purge
+
+# ── Fan Policy Export (export_fan_policy.py → code/fan_policy.h) ──
+FAN_POLICY_TEMP_POINTS = [20, 25, 30, 35]  # Bin centres (°C)
+FAN_POLICY_GAS_POINTS = [50, 80]           # Bin centres (filtered gas)
+FAN_MIN_SWITCH_S = 60        # Never switch the relay faster than this
+FAN_DUTY_WINDOW_S = 3600     # Must match FAN_DUTY_WINDOW_MS in fan_controller.h
+
+# ── Humidity Forecast Export (export_forecaster.py → code/forecast_model.h) ──
+FORECAST_EXPORT_ORDER = (5, 1, 2)  # ARIMA order; the firmware kernel assumes d = 1
+FORECAST_EXPORT_STEP_MIN = 20      # Resample step, as in forecasting.py
+FORECAST_EXPORT_HORIZON = 18       # Steps forecast on the device (6 h)
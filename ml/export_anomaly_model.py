@@ -0,0 +1,213 @@
+"""
+Smart Grain Silo - Isolation Forest Export for the ESP8266
+===========================================================
+Trains a compact Isolation Forest on the same features as
+anomaly_detection.py and writes it to code/anomaly_model.h as flat
+PROGMEM node arrays, so the silo can score every sample itself and
+raise "EARLY FERMENTATION" without waiting for the offline job.
+
+How the forest is flattened:
+  - Nodes are laid out in pre-order, so a node's left child is always the
+    next node and only the right child index needs storing.
+  - The StandardScaler is folded into the split thresholds
+    (x_scaled <= t  <=>  x <= t * scale + mean), so the firmware feeds raw
+    sensor units straight into the trees.
+  - A leaf stores its full path length: depth + c(n_samples_in_leaf),
+    the same quantity sklearn sums in score_samples().
+  - The score offset (contamination threshold) is exported as is, so
+    the on-device decision value matches decision_function().
+
+The full 200-tree model from anomaly_detection.py would not fit in flash
+comfortably; this one uses ANOMALY_EXPORT_TREES trees of
+ANOMALY_EXPORT_MAX_SAMPLES samples each (a few KB).
+
+Usage:
+    python export_anomaly_model.py                        # Latest data
+    python export_anomaly_model.py --data path/to/data.csv
+    python export_anomaly_model.py --trees 48 --max-samples 128
+"""
+
+import argparse
+import os
+import numpy as np
+
+from sklearn.ensemble import IsolationForest
+from sklearn.preprocessing import StandardScaler
+
+from config import (
+    ISOLATION_FOREST_CONTAMINATION,
+    ANOMALY_MODEL_FEATURES,
+    ANOMALY_EXPORT_TREES, ANOMALY_EXPORT_MAX_SAMPLES,
+)
+from anomaly_detection import load_data, engineer_features, rolling_window
+
+HEADER_PATH = os.path.join(os.path.dirname(__file__), "..", "code", "anomaly_model.h")
+EULER_GAMMA = 0.5772156649015329
+
+
+# ════════════════════════════════════════════════════════════════
+#  FOREST FLATTENING
+# ════════════════════════════════════════════════════════════════
+
+def average_path_length(n: int) -> float:
+    """c(n): expected path length of an unsuccessful BST search (sklearn's definition)."""
+    if n <= 1:
+        return 0.0
+    if n == 2:
+        return 1.0
+    return 2.0 * (np.log(n - 1.0) + EULER_GAMMA) - 2.0 * (n - 1.0) / n
+
+
+def flatten_tree(tree, feature_map, scaler, features, values, rights, node=0, depth=0):
+    """Lay out one tree in pre-order; returns the flat index of `node`."""
+    index = len(features)
+    left, right = tree.children_left[node], tree.children_right[node]
+    if left == -1:
+        features.append(-1)
+        values.append(depth + average_path_length(int(tree.n_node_samples[node])))
+        rights.append(0)
+        return index
+
+    f = int(feature_map[tree.feature[node]])
+    features.append(f)
+    values.append(tree.threshold[node] * scaler.scale_[f] + scaler.mean_[f])
+    rights.append(0)
+    flatten_tree(tree, feature_map, scaler, features, values, rights, left, depth + 1)
+    rights[index] = flatten_tree(tree, feature_map, scaler, features, values, rights,
+                                 right, depth + 1)
+    return index
+
+
+def flatten_forest(model: IsolationForest, scaler: StandardScaler, n_features: int):
+    """Flatten all trees into shared (feature, value, right) arrays plus root offsets."""
+    features, values, rights, roots = [], [], [], []
+    # Trees only see a feature subset when max_features < n_features
+    subsample = getattr(model, "_max_features", n_features) != n_features
+    for est, est_features in zip(model.estimators_, model.estimators_features_):
+        feature_map = est_features if subsample else np.arange(n_features)
+        roots.append(flatten_tree(est.tree_, feature_map, scaler, features, values, rights))
+
+    if len(features) > 0xFFFF:
+        raise ValueError(f"{len(features)} nodes do not fit 16-bit indices; use fewer trees")
+    return features, values, rights, roots
+
+
+def flat_decision(x: np.ndarray, flat, n_trees: int, path_norm: float, offset: float) -> float:
+    """Score one raw feature row exactly like code/anomaly_scorer.h does."""
+    features, values, rights, roots = flat
+    depth = 0.0
+    for root in roots:
+        i = root
+        while features[i] >= 0:
+            i = i + 1 if x[features[i]] <= values[i] else rights[i]
+        depth += values[i]
+    return -(2.0 ** (-(depth / n_trees) / path_norm)) - offset
+
+
+# ════════════════════════════════════════════════════════════════
+#  HEADER GENERATION
+# ════════════════════════════════════════════════════════════════
+
+def c_float(v: float) -> str:
+    text = f"{v:.9g}"
+    if not any(ch in text for ch in ".en"):
+        text += ".0"
+    return text + "f"
+
+
+def c_array(ctype: str, name: str, items, per_line: int = 12) -> str:
+    lines = []
+    for i in range(0, len(items), per_line):
+        lines.append("  " + ", ".join(items[i:i + per_line]) + ",")
+    return f"constexpr {ctype} {name}[] PROGMEM = {{\n" + "\n".join(lines) + "\n};\n"
+
+
+def write_header(path: str, flat, window: int, path_norm: float, offset: float,
+                 n_rows: int, max_samples: int):
+    features, values, rights, roots = flat
+    n_bytes = len(features) * 7 + len(roots) * 2
+    text = f"""#pragma once
+
+// ==========================================
+// ISOLATION FOREST MODEL (GENERATED)
+// ==========================================
+// Generated by ml/export_anomaly_model.py - do not edit by hand.
+// {len(roots)} trees, {len(features)} nodes (~{n_bytes} bytes of flash),
+// trained on {n_rows} rows with {max_samples} samples per tree.
+// Nodes are in pre-order: the left child of node i is i + 1, the right
+// child is kIForestRight[i]. kIForestFeature[i] < 0 marks a leaf, whose
+// kIForestValue[i] is its path length; otherwise kIForestValue[i] is the
+// split threshold in raw sensor units (x <= threshold goes left).
+
+#include <Arduino.h>
+
+constexpr uint16_t kIForestTrees = {len(roots)};
+constexpr uint8_t kIForestFeatures = {len(ANOMALY_MODEL_FEATURES)};
+constexpr uint16_t kIForestWindow = {window};  // Rolling window (samples)
+constexpr float kIForestPathNorm = {c_float(path_norm)};  // c(max_samples)
+constexpr float kIForestOffset = {c_float(offset)};  // sklearn offset_
+
+{c_array("uint16_t", "kIForestRoot", [str(r) for r in roots])}
+{c_array("int8_t", "kIForestFeature", [str(f) for f in features], 24)}
+{c_array("float", "kIForestValue", [c_float(v) for v in values], 8)}
+{c_array("uint16_t", "kIForestRight", [str(r) for r in rights], 16)}"""
+    with open(path, "w") as fh:
+        fh.write(text)
+
+
+# ════════════════════════════════════════════════════════════════
+#  MAIN
+# ════════════════════════════════════════════════════════════════
+
+def main():
+    parser = argparse.ArgumentParser(description="Export the anomaly model for the ESP8266")
+    parser.add_argument("--data", type=str, default=None, help="Path to CSV data file")
+    parser.add_argument("--contamination", type=float, default=ISOLATION_FOREST_CONTAMINATION,
+                        help=f"Expected anomaly rate (default: {ISOLATION_FOREST_CONTAMINATION})")
+    parser.add_argument("--trees", type=int, default=ANOMALY_EXPORT_TREES,
+                        help=f"Trees in the exported forest (default: {ANOMALY_EXPORT_TREES})")
+    parser.add_argument("--max-samples", type=int, default=ANOMALY_EXPORT_MAX_SAMPLES,
+                        help=f"Samples per tree (default: {ANOMALY_EXPORT_MAX_SAMPLES})")
+    parser.add_argument("--out", type=str, default=HEADER_PATH, help="Header to write")
+    args = parser.parse_args()
+
+    df = engineer_features(load_data(args.data))
+    window = rolling_window(df)
+    X = df[ANOMALY_MODEL_FEATURES].values
+
+    print(f"\n{'='*60}")
+    print(f"  EXPORTING ISOLATION FOREST → {os.path.normpath(args.out)}")
+    print(f"{'='*60}")
+
+    scaler = StandardScaler()
+    X_scaled = scaler.fit_transform(X)
+    model = IsolationForest(
+        n_estimators=args.trees,
+        contamination=args.contamination,
+        max_samples=min(args.max_samples, len(X)),
+        random_state=42,
+    )
+    model.fit(X_scaled)
+
+    flat = flatten_forest(model, scaler, X.shape[1])
+    path_norm = average_path_length(model.max_samples_)
+    offset = float(model.offset_)
+
+    # The flattened forest on raw units must agree with sklearn on scaled units
+    reference = model.decision_function(X_scaled)
+    ours = np.array([flat_decision(x, flat, args.trees, path_norm, offset) for x in X])
+    max_err = np.abs(ours - reference).max()
+    agree = np.mean((ours < 0) == (reference < 0))
+    print(f"  Trees / nodes    : {args.trees} / {len(flat[0])}")
+    print(f"  Rolling window   : {window} samples")
+    print(f"  Max score error  : {max_err:.2e}")
+    print(f"  Label agreement  : {agree:.2%}")
+    print(f"  Flagged (train)  : {np.mean(reference < 0):.1%}")
+
+    write_header(args.out, flat, window, path_norm, offset, len(X), model.max_samples_)
+    print(f"  [+] Header written: {os.path.normpath(args.out)}")
+    print("      Re-flash the ESP8266 to use the new model.")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+"""
+Smart Grain Silo - Fan Policy Export for the ESP8266
+=====================================================
+Turns the PPO agent trained by fan_optimization.py into the lookup table
+in code/fan_policy.h, which code/fan_controller.h evaluates on the device.
+No more hand-copying thresholds into code.ino.
+
+What gets exported:
+  - ON/OFF humidity thresholds per temperature × gas bin, found by
+    sweeping the agent (extract_policy_table()). The gap between them is
+    the hysteresis band.
+  - Minimum ON and OFF times: the 10th percentile of the agent's run
+    lengths in simulation, never below FAN_MIN_SWITCH_S.
+  - Maximum duty: the agent's highest ON share over any FAN_DUTY_WINDOW_S
+    window, plus a 5% margin.
+
+Usage:
+    python export_fan_policy.py                     # Saved model, latest data
+    python export_fan_policy.py --data path/to/data.csv
+"""
+
+import argparse
+import math
+import os
+import sys
+import numpy as np
+
+from stable_baselines3 import PPO
+
+from config import (
+    MODEL_DIR, SAMPLE_INTERVAL_S,
+    FAN_POLICY_TEMP_POINTS, FAN_POLICY_GAS_POINTS,
+    FAN_MIN_SWITCH_S, FAN_DUTY_WINDOW_S,
+)
+from fan_optimization import (
+    GrainSiloEnv, load_env_data,
+    extract_policy_table, run_lengths, run_rl_agent, run_threshold_baseline,
+)
+
+HEADER_PATH = os.path.join(os.path.dirname(__file__), "..", "code", "fan_policy.h")
+
+
+# ════════════════════════════════════════════════════════════════
+#  TIMING LIMITS FROM SIMULATION
+# ════════════════════════════════════════════════════════════════
+
+def min_run_seconds(runs) -> int:
+    """Shortest run worth enforcing, in seconds (10th percentile of the agent's runs)."""
+    if not runs:
+        return FAN_MIN_SWITCH_S
+    return int(max(FAN_MIN_SWITCH_S, np.percentile(runs, 10) * SAMPLE_INTERVAL_S))
+
+
+def max_duty_percent(fan_log) -> int:
+    """Highest ON share over any duty window, rounded up to 5% plus a 5% margin."""
+    window = max(1, FAN_DUTY_WINDOW_S // SAMPLE_INTERVAL_S)
+    states = np.asarray(fan_log, dtype=float)
+    if len(states) < window:
+        return 100
+    rolling = np.convolve(states, np.ones(window) / window, mode="valid")
+    duty = math.ceil(rolling.max() * 100 / 5) * 5 + 5
+    return int(min(100, max(10, duty)))
+
+
+# ════════════════════════════════════════════════════════════════
+#  HEADER GENERATION
+# ════════════════════════════════════════════════════════════════
+
+def bin_edges(points):
+    """Upper edges between adjacent bin centres."""
+    return [(a + b) / 2 for a, b in zip(points, points[1:])]
+
+
+def write_header(path, on_table, off_table, min_on_s, min_off_s, max_duty):
+    temp_edges = bin_edges(FAN_POLICY_TEMP_POINTS)
+    gas_edges = [int(round(e)) for e in bin_edges(FAN_POLICY_GAS_POINTS)]
+    labels = [f"temp < {e:g}" for e in temp_edges] + [f"temp >= {temp_edges[-1]:g}"]
+
+    def table(rows, comments):
+        lines = []
+        for row, comment in zip(rows, comments):
+            cells = "{ " + ", ".join(str(v) for v in row) + " },"
+            lines.append(f"  {cells}" + (f"  // {comment}" if comment else ""))
+        return "\n".join(lines)
+
+    text = f"""#pragma once
+
+// ==========================================
+// FAN POLICY TABLE (GENERATED)
+// ==========================================
+// Generated by ml/export_fan_policy.py from the PPO agent - do not edit by hand.
+// Bins are chosen by temperature and filtered gas; kFanTempEdges /
+// kFanGasEdges are the upper (exclusive) edges of every bin but the last.
+// Humidity thresholds are whole percent: the fan starts above kFanOnHum
+// and stops at or below kFanOffHum. 101 means "never on" in that bin.
+
+#include <Arduino.h>
+
+constexpr uint8_t kFanTempBins = {len(FAN_POLICY_TEMP_POINTS)};
+constexpr uint8_t kFanGasBins = {len(FAN_POLICY_GAS_POINTS)};
+constexpr float kFanTempEdges[kFanTempBins - 1] = {{ {", ".join(f"{e:.1f}f" for e in temp_edges)} }};
+constexpr uint16_t kFanGasEdges[kFanGasBins - 1] = {{ {", ".join(str(e) for e in gas_edges)} }};
+
+constexpr uint8_t kFanOnHum[kFanTempBins][kFanGasBins] = {{
+{table(on_table, labels)}
+}};
+constexpr uint8_t kFanOffHum[kFanTempBins][kFanGasBins] = {{
+{table(off_table, [None] * len(off_table))}
+}};
+
+constexpr uint32_t kFanMinOnMs = {min_on_s * 1000};  // Shortest humidity-driven run
+constexpr uint32_t kFanMinOffMs = {min_off_s * 1000};  // Shortest rest between runs
+constexpr uint8_t kFanMaxDutyPct = {max_duty};  // Max ON share of the last hour
+"""
+    with open(path, "w") as fh:
+        fh.write(text)
+
+
+# ════════════════════════════════════════════════════════════════
+#  MAIN
+# ════════════════════════════════════════════════════════════════
+
+def main():
+    parser = argparse.ArgumentParser(description="Export the RL fan policy for the ESP8266")
+    parser.add_argument("--data", type=str, default=None, help="Path to CSV data file")
+    parser.add_argument("--out", type=str, default=HEADER_PATH, help="Header to write")
+    args = parser.parse_args()
+
+    if len(FAN_POLICY_TEMP_POINTS) < 2 or len(FAN_POLICY_GAS_POINTS) < 2:
+        print("[!] FAN_POLICY_TEMP_POINTS and FAN_POLICY_GAS_POINTS need at least 2 bins each")
+        sys.exit(1)
+
+    model_path = os.path.join(MODEL_DIR, "ppo_fan_controller")
+    if not os.path.exists(model_path + ".zip"):
+        print(f"[!] No saved model at {model_path}.zip — run fan_optimization.py first!")
+        sys.exit(1)
+
+    df = load_env_data(args.data)
+    model = PPO.load(model_path, env=GrainSiloEnv(data=df))
+
+    print(f"\n{'='*60}")
+    print(f"  EXPORTING FAN POLICY → {os.path.normpath(args.out)}")
+    print(f"{'='*60}")
+
+    on_table, off_table = extract_policy_table(model, FAN_POLICY_TEMP_POINTS, FAN_POLICY_GAS_POINTS)
+
+    _, _, rl_fan, rl_metrics = run_rl_agent(GrainSiloEnv(data=df), model)
+    _, _, _, b_metrics = run_threshold_baseline(GrainSiloEnv(data=df))
+    on_runs, off_runs = run_lengths(rl_fan)
+    min_on_s = min_run_seconds(on_runs)
+    min_off_s = min_run_seconds(off_runs)
+    max_duty = max_duty_percent(rl_fan)
+
+    for temp_point, on_row, off_row in zip(FAN_POLICY_TEMP_POINTS, on_table, off_table):
+        cells = "  ".join(f"gas≈{g}: ON>{on} OFF≤{off}"
+                          for g, on, off in zip(FAN_POLICY_GAS_POINTS, on_row, off_row))
+        print(f"  Temp≈{temp_point}°C  {cells}")
+    print(f"  Min ON / OFF time : {min_on_s} s / {min_off_s} s")
+    print(f"  Max duty (1 h)    : {max_duty}%")
+    print(f"  Fan duty          : {rl_metrics['fan_duty_cycle']:.1%} "
+          f"(threshold policy: {b_metrics['fan_duty_cycle']:.1%})")
+    print(f"  Toggles           : {rl_metrics['total_toggles']} "
+          f"(threshold policy: {b_metrics['total_toggles']})")
+
+    write_header(args.out, on_table, off_table, min_on_s, min_off_s, max_duty)
+    print(f"  [+] Header written: {os.path.normpath(args.out)}")
+    print("      Re-flash the ESP8266 to use the new policy.")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,219 @@
+"""
+Smart Grain Silo - Humidity Forecast Export for the ESP8266
+============================================================
+Fits the ARIMA(5,1,2) humidity model from forecasting.py and writes it to
+code/forecast_model.h, so the silo forecasts humidity itself and warns (and
+starts the fan) before it reaches MOLD_GROWTH_HUM_MIN, while the grain can
+still be dried.
+
+What the device runs (code/mold_forecaster.h):
+  - humidity averaged into 20-minute steps, in centi-percent (integers),
+  - the next change predicted from the last p changes and the last q
+    one-step errors, with the coefficients in fixed point (int16, value =
+    coef / 2^shift) and a 64-bit accumulator,
+  - that prediction fed back in to reach FORECAST_EXPORT_HORIZON steps.
+With d = 1 and no trend term, statsmodels fits no constant, so nothing else
+is needed. The shift is the largest one (up to 14) at which every
+coefficient still fits an int16.
+
+The integer kernel is replayed here over the training series. Its forecast
+from the last step is compared with statsmodels', and its h-step error is
+measured at every origin. The device filters errors with zeros from boot
+instead of a Kalman filter, so the first steps differ and the two converge
+after a few steps.
+
+Usage:
+    python export_forecaster.py                        # Latest data
+    python export_forecaster.py --data path/to/data.csv
+    python export_forecaster.py --horizon 24           # 8 h ahead
+"""
+
+import argparse
+import os
+import warnings
+import numpy as np
+
+from statsmodels.tsa.arima.model import ARIMA
+
+from config import (
+    MOLD_GROWTH_TEMP_MIN, MOLD_GROWTH_TEMP_MAX, MOLD_GROWTH_HUM_MIN,
+    FORECAST_EXPORT_ORDER, FORECAST_EXPORT_STEP_MIN, FORECAST_EXPORT_HORIZON,
+)
+from forecasting import load_data
+
+warnings.filterwarnings("ignore")
+
+HEADER_PATH = os.path.join(os.path.dirname(__file__), "..", "code", "forecast_model.h")
+DIFF_MAX = 2000       # FORECAST_DIFF_MAX in mold_forecaster.h (centi-%)
+MAX_SHIFT = 14
+
+
+# ════════════════════════════════════════════════════════════════
+#  QUANTIZATION
+# ════════════════════════════════════════════════════════════════
+
+def choose_shift(coefs: np.ndarray) -> int:
+    """Largest shift <= MAX_SHIFT at which every coefficient fits an int16."""
+    biggest = float(np.abs(coefs).max()) if len(coefs) else 0.0
+    for shift in range(MAX_SHIFT, 0, -1):
+        if round(biggest * (1 << shift)) <= 32767:
+            return shift
+    raise ValueError(f"coefficient {biggest:.1f} is too large for int16 fixed point")
+
+
+def quantize(coefs: np.ndarray, shift: int) -> list:
+    return [int(round(c * (1 << shift))) for c in coefs]
+
+
+# ════════════════════════════════════════════════════════════════
+#  INTEGER KERNEL (mirrors code/mold_forecaster.h)
+# ════════════════════════════════════════════════════════════════
+
+class Kernel:
+    def __init__(self, ar: list, ma: list, shift: int, horizon: int):
+        self.ar, self.ma, self.shift, self.horizon = ar, ma, shift, horizon
+        self.diff = [0] * len(ar)
+        self.err = [0] * len(ma)
+        self.diffs = 0
+        self.last = None
+        self.pred_next = 0
+
+    def ready(self) -> bool:
+        return self.diffs == len(self.ar)
+
+    def step(self, d: list, e: list) -> int:
+        acc = 1 << (self.shift - 1)
+        acc += sum(a * x for a, x in zip(self.ar, d))
+        acc += sum(m * x for m, x in zip(self.ma, e))
+        return acc >> self.shift  # Arithmetic shift, as in C on int64
+
+    def observe(self, level: int):
+        """One step mean (centi-%). Returns the forecast levels once ready."""
+        if self.last is None:
+            self.last = level
+            return None
+        d = max(-DIFF_MAX, min(DIFF_MAX, level - self.last))
+        self.last = level
+        e = d - self.pred_next if self.ready() else 0
+        self.diff = [d] + self.diff[:-1]
+        self.err = [e] + self.err[:-1]
+        self.diffs = min(self.diffs + 1, len(self.ar))
+        if not self.ready():
+            return None
+        d, e = list(self.diff), list(self.err)
+        level, out = self.last, []
+        for h in range(self.horizon):
+            nxt = self.step(d, e)
+            if h == 0:
+                self.pred_next = nxt
+            d = [nxt] + d[:-1]
+            e = [0] + e[:-1]
+            level += nxt
+            out.append(level)
+        return out
+
+
+# ════════════════════════════════════════════════════════════════
+#  HEADER GENERATION
+# ════════════════════════════════════════════════════════════════
+
+def write_header(path: str, order, ar: list, ma: list, shift: int, horizon: int,
+                 n_steps: int, aic: float):
+    p, _, q = order
+    text = f"""#pragma once
+
+// ==========================================
+// HUMIDITY FORECAST MODEL (GENERATED)
+// ==========================================
+// Generated by ml/export_forecaster.py - do not edit by hand.
+// ARIMA{tuple(order)} on {n_steps} steps of {FORECAST_EXPORT_STEP_MIN}-minute mean humidity (AIC {aic:.1f}).
+// The model runs on 20-minute mean humidity in centi-percent. Each step
+// predicts the next change from the last kForecastP changes and the last
+// kForecastQ one-step errors, with coefficients in fixed point
+// (value = coef / 2^kForecastShift).
+
+#include <Arduino.h>
+
+constexpr bool kForecastTrained = true;
+constexpr uint8_t kForecastP = {p};                 // AR order (on differences)
+constexpr uint8_t kForecastQ = {q};                 // MA order
+constexpr uint8_t kForecastShift = {shift};            // Coefficient fixed point
+constexpr uint32_t kForecastStepMs = {FORECAST_EXPORT_STEP_MIN * 60000};     // {FORECAST_EXPORT_STEP_MIN} min, as forecasting.py resamples
+constexpr uint8_t kForecastHorizon = {horizon};          // Steps ahead ({horizon * FORECAST_EXPORT_STEP_MIN / 60:g} h)
+constexpr int32_t kForecastRiskHum = {int(round(MOLD_GROWTH_HUM_MIN * 100))};        // MOLD_GROWTH_HUM_MIN, centi-%
+constexpr float kForecastTempMin = {MOLD_GROWTH_TEMP_MIN:.1f}f;         // MOLD_GROWTH_TEMP_MIN/MAX
+constexpr float kForecastTempMax = {MOLD_GROWTH_TEMP_MAX:.1f}f;
+
+constexpr int16_t kForecastAr[kForecastP] = {{ {", ".join(str(c) for c in ar)} }};
+constexpr int16_t kForecastMa[kForecastQ] = {{ {", ".join(str(c) for c in ma)} }};
+"""
+    with open(path, "w") as fh:
+        fh.write(text)
+
+
+# ════════════════════════════════════════════════════════════════
+#  MAIN
+# ════════════════════════════════════════════════════════════════
+
+def main():
+    parser = argparse.ArgumentParser(description="Export the humidity forecast for the ESP8266")
+    parser.add_argument("--data", type=str, default=None, help="Path to CSV data file")
+    parser.add_argument("--horizon", type=int, default=FORECAST_EXPORT_HORIZON,
+                        help=f"Steps forecast on the device (default: {FORECAST_EXPORT_HORIZON})")
+    parser.add_argument("--out", type=str, default=HEADER_PATH, help="Header to write")
+    args = parser.parse_args()
+
+    order = FORECAST_EXPORT_ORDER
+    if order[1] != 1:
+        parser.error("the firmware kernel forecasts differences: FORECAST_EXPORT_ORDER needs d = 1")
+    if not 1 <= args.horizon <= 255:
+        parser.error("--horizon must be 1..255 steps")
+
+    df = load_data(args.data)
+    ts = df.set_index("timestamp")["humidity"].resample(f"{FORECAST_EXPORT_STEP_MIN}min").mean().interpolate()
+
+    print(f"\n{'='*60}")
+    print(f"  EXPORTING HUMIDITY FORECAST → {os.path.normpath(args.out)}")
+    print(f"{'='*60}")
+    print(f"  Fitting ARIMA{tuple(order)} on {len(ts)} steps...")
+    fitted = ARIMA(ts, order=order).fit()
+    params = dict(zip(fitted.model.param_names, fitted.params))
+    ar = np.array([params[f"ar.L{i}"] for i in range(1, order[0] + 1)])
+    ma = np.array([params[f"ma.L{i}"] for i in range(1, order[2] + 1)])
+
+    shift = choose_shift(np.concatenate([ar, ma]))
+    ar_q, ma_q = quantize(ar, shift), quantize(ma, shift)
+    quant_err = max(np.abs(np.array(ar_q + ma_q) / (1 << shift) - np.concatenate([ar, ma])))
+
+    # Replay the integer kernel over the series
+    kernel = Kernel(ar_q, ma_q, shift, args.horizon)
+    levels = np.round(ts.values * 100).astype(int)
+    errors, last = [], None
+    for i, level in enumerate(levels):
+        out = kernel.observe(int(level))
+        if out is not None:
+            last = out
+            if i + args.horizon < len(levels):
+                errors.append(abs(out[-1] - levels[i + args.horizon]) / 100)
+    if last is None:
+        raise SystemExit(f"[!] {len(ts)} steps are too few to forecast (need {order[0] + 2})")
+    reference = fitted.forecast(steps=args.horizon).values
+    vs_statsmodels = np.abs(np.array(last) / 100 - reference).max()
+
+    macs = args.horizon * (order[0] + order[2])
+    hours = args.horizon * FORECAST_EXPORT_STEP_MIN / 60
+    print(f"  AIC              : {fitted.aic:.2f}")
+    print(f"  Fixed point      : Q{shift}, max coefficient error {quant_err:.1e}")
+    print(f"  Horizon          : {args.horizon} steps ({hours:g} h), {macs} multiply-adds per update")
+    print(f"  Kernel vs statsmodels (last origin): max {vs_statsmodels:.2f} %RH")
+    if errors:
+        print(f"  Kernel {hours:g} h error (all origins): mean {np.mean(errors):.2f}, "
+              f"p95 {np.percentile(errors, 95):.2f} %RH")
+
+    write_header(args.out, order, ar_q, ma_q, shift, args.horizon, len(ts), fitted.aic)
+    print(f"  [+] Header written: {os.path.normpath(args.out)}")
+    print("      Re-flash the ESP8266 to use the new model.")
+
+
+if __name__ == "__main__":
+    main()
@@ -193,6 +193,18 @@ class GrainSiloEnv(gym.Env):
         }
 
 
+def load_env_data(path: str = None):
+    """Load historical data for the simulator, or None to use synthetic data."""
+    data_path = path or os.path.join(DATA_DIR, "silo_data_latest.csv")
+    if os.path.exists(data_path):
+        df = pd.read_csv(data_path, parse_dates=["timestamp"])
+        df = df.dropna(subset=["humidity", "temperature"]).reset_index(drop=True)
+        print(f"[+] Loaded {len(df)} rows for environment simulation")
+        return df
+    print("[!] No data file found. Using synthetic environment data.")
+    return None
+
+
 # ════════════════════════════════════════════════════════════════
 #  THRESHOLD BASELINE (for comparison)
 # ════════════════════════════════════════════════════════════════
@@ -313,6 +325,10 @@ def extract_policy_rules(env: GrainSiloEnv, model):
     """
     Run the RL agent across many scenarios and extract simple rules
     that can be hard-coded back into the ESP8266.
+    
+    Returns:
+        dict with the (temp, humidity) ON/OFF points and their averages
+        (None when the agent never switched in the sweep).
     """
     print(f"\n{'='*60}")
     print("  EXTRACTED POLICY RULES")
@@ -357,6 +373,67 @@ def extract_policy_rules(env: GrainSiloEnv, model):
         print(f"    Hysteresis band:   {hysteresis:.0f}%")
         print(f"\n  (This means: turn fan ON at {avg_on:.0f}%, keep running until")
         print(f"   humidity drops to {avg_off:.0f}%, then turn OFF)")
+    else:
+        avg_on = avg_off = None
+    
+    return {
+        "on": fan_on_thresholds,
+        "off": fan_off_thresholds,
+        "avg_on": avg_on,
+        "avg_off": avg_off,
+    }
+
+
+def extract_policy_table(model, temp_points, gas_points, time_since_toggle=50):
+    """
+    Sweep the agent over a temperature × gas grid and find, per cell, the
+    humidity where it turns the fan ON (fan currently OFF) and OFF (fan
+    currently ON). Used by export_fan_policy.py to build the firmware table.
+    
+    Returns:
+        (on_table, off_table): lists [temp][gas] of whole-percent humidity.
+        101 in on_table means the agent never turned the fan on there.
+    """
+    on_table, off_table = [], []
+    for temp_test in temp_points:
+        on_row, off_row = [], []
+        for gas_test in gas_points:
+            on_hum = 101
+            for hum_test in range(0, 101):
+                obs = np.array([hum_test, temp_test, gas_test, 0, time_since_toggle], dtype=np.float32)
+                action, _ = model.predict(obs, deterministic=True)
+                if action == 1:
+                    on_hum = hum_test
+                    break
+            off_hum = 0
+            for hum_test in range(100, -1, -1):
+                obs = np.array([hum_test, temp_test, gas_test, 1, time_since_toggle], dtype=np.float32)
+                action, _ = model.predict(obs, deterministic=True)
+                if action == 0:
+                    off_hum = hum_test
+                    break
+            # The firmware starts above ON and stops at or below OFF;
+            # keep at least a 1% band so the two can never overlap
+            on_row.append(on_hum)
+            off_row.append(min(off_hum, max(on_hum - 1, 0)))
+        on_table.append(on_row)
+        off_table.append(off_row)
+    return on_table, off_table
+
+
+def run_lengths(fan_log):
+    """Lengths (in steps) of finished ON runs and OFF runs in a fan log."""
+    on_runs, off_runs = [], []
+    if not fan_log:
+        return on_runs, off_runs
+    current, length = fan_log[0], 0
+    for state in fan_log:
+        if state == current:
+            length += 1
+            continue
+        (on_runs if current else off_runs).append(length)
+        current, length = state, 1
+    return on_runs, off_runs
 
 
 # ════════════════════════════════════════════════════════════════
@@ -373,14 +450,7 @@ def main():
     args = parser.parse_args()
     
     # Load data
-    data_path = args.data or os.path.join(DATA_DIR, "silo_data_latest.csv")
-    if os.path.exists(data_path):
-        df = pd.read_csv(data_path, parse_dates=["timestamp"])
-        df = df.dropna(subset=["humidity", "temperature"]).reset_index(drop=True)
-        print(f"[+] Loaded {len(df)} rows for environment simulation")
-    else:
-        print("[!] No data file found. Using synthetic environment data.")
-        df = None
+    df = load_env_data(args.data)
     
     # Create environment
     env = GrainSiloEnv(data=df)
@@ -443,6 +513,7 @@ def main():
     
     # Extract interpretable rules
     extract_policy_rules(eval_env, model)
+    print("\n  Run `python export_fan_policy.py` to compile these rules into the firmware.")
     
     print(f"\n{'='*60}")
     print("  FAN OPTIMIZATION COMPLETE")
@@ -4,6 +4,12 @@ Smart Grain Silo - ThingSpeak Data Fetcher
 Pulls all historical time-series data from your ThingSpeak channel
 and saves it as a clean CSV for downstream ML pipelines.
 
+ThingSpeak returns at most 8000 points per request. Silos with
+UPLOAD_WINDOW_S upload one summary per window, so that is 27 days at 300 s
+instead of 33 hours of 15 s samples. Those rows also get the window's
+spread from the status field: min/max/std of temperature and humidity,
+peak and std of the raw gas, and the fan duty (WINDOW_STATUS_COLUMNS).
+
 Usage:
     python fetch_data.py                     # Fetch all data
     python fetch_data.py --results 1000      # Fetch last 1000 points
@@ -22,10 +28,20 @@ from config import (
     THINGSPEAK_READ_API_KEY,
     THINGSPEAK_BASE_URL,
     FIELD_MAP,
+    WINDOW_STATUS_TAG,
+    WINDOW_STATUS_COLUMNS,
     DATA_DIR,
 )
 
 
+def parse_window_status(status) -> dict:
+    """Window statistics from a feed entry's status; empty for a plain sample."""
+    parts = (status or "").split()
+    if len(parts) != len(WINDOW_STATUS_COLUMNS) + 1 or parts[0] != WINDOW_STATUS_TAG:
+        return {}
+    return {col: None if v == "-" else float(v) for col, v in zip(WINDOW_STATUS_COLUMNS, parts[1:])}
+
+
 def fetch_thingspeak(results: int = 8000, days: int = None) -> pd.DataFrame:
     """
     Fetch data from ThingSpeak channel feeds API.
@@ -35,13 +51,15 @@ def fetch_thingspeak(results: int = 8000, days: int = None) -> pd.DataFrame:
         days:    If set, only fetch data from the last N days.
     
     Returns:
-        pd.DataFrame with columns: timestamp, temperature, humidity, gas_value, motion
+        pd.DataFrame with columns: timestamp, the FIELD_MAP columns and, for
+        window uploads, the WINDOW_STATUS_COLUMNS (empty on plain samples)
     """
     url = f"{THINGSPEAK_BASE_URL}/channels/{THINGSPEAK_CHANNEL_ID}/feeds.json"
     
     params = {
         "api_key": THINGSPEAK_READ_API_KEY,
         "results": min(results, 8000),  # ThingSpeak hard limit
+        "status": "true",               # Window statistics
     }
     
     if days is not None:
@@ -74,13 +92,18 @@ def fetch_thingspeak(results: int = 8000, days: int = None) -> pd.DataFrame:
         for field_key, col_name in FIELD_MAP.items():
             raw = entry.get(field_key)
             row[col_name] = float(raw) if raw is not None else None
+        row.update(parse_window_status(entry.get("status")))
         rows.append(row)
     
     df = pd.DataFrame(rows)
     df["timestamp"] = pd.to_datetime(df["timestamp"])
     df = df.sort_values("timestamp").reset_index(drop=True)
     
-    # Convert motion to int (0/1)
+    windows = df["window_s"].notna().sum() if "window_s" in df.columns else 0
+    if windows:
+        print(f"[+] {windows} of them are {df['window_s'].median():.0f} s upload windows.")
+    
+    # Convert motion to int (event count per sample period or window)
     if "motion" in df.columns:
         df["motion"] = df["motion"].fillna(0).astype(int)
     
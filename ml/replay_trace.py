@@ -0,0 +1,178 @@
+"""
+Smart Grain Silo - Hardware-in-the-Loop Trace Replay
+=====================================================
+Streams a recorded trace (a CSV from fetch_data.py) to a board running the
+TRACE_REPLAY firmware (code/trace_replay.h) and collects its decisions:
+alert, buzzer pattern, fan relay and queued Telegrams per frame, plus the
+on-target time per frame and the worst 50 ms control tick.
+
+Usage:
+    python replay_trace.py /dev/ttyUSB0                         # data/silo_data_latest.csv
+    python replay_trace.py COM5 data/monsoon_2024.csv --out data/monsoon_replay.csv
+    python replay_trace.py --frames-only data/trace.csv [in.csv] # write the frame file only
+
+For the fastest run, put the frame file on the board's LittleFS as
+/trace.csv: the firmware then replays it without waiting for the serial
+link, and this script is only needed to convert the CSV.
+
+Wire format (one line per frame):
+    <ms>,<temp C>,<hum %>,<gas raw>,<motion events>
+"""
+
+import argparse
+import csv
+import math
+import os
+import sys
+import time
+from datetime import datetime, timezone
+
+DATA_DIR = os.path.join(os.path.dirname(__file__), "data")  # As in config.py
+
+READY = "# trace replay ready"
+DEFAULT_BAUD = 460800       # TRACE_REPLAY_BAUD
+DEFAULT_WINDOW = 16         # TRACE_REPLAY_WINDOW
+
+
+def parse_time(text: str) -> float:
+    """Seconds since the epoch from a pandas/ThingSpeak timestamp."""
+    t = datetime.fromisoformat(text.strip().replace("Z", "+00:00"))
+    if t.tzinfo is None:
+        t = t.replace(tzinfo=timezone.utc)
+    return t.timestamp()
+
+
+def num(text: str, fmt: str) -> str:
+    """Reformat a numeric cell, or '' if it is empty or NaN."""
+    try:
+        v = float(text)
+    except (TypeError, ValueError):
+        return ""
+    return "" if math.isnan(v) else fmt % v
+
+
+def load_frames(path: str) -> list:
+    """Convert a fetch_data.py CSV into replay frame lines."""
+    with open(path, newline="") as f:
+        rows = list(csv.DictReader(f))
+    if not rows:
+        sys.exit(f"[!] {path} is empty")
+    for col in ("temperature", "humidity", "gas_value"):
+        if col not in rows[0]:
+            sys.exit(f"[!] {path} has no '{col}' column")
+
+    frames = []
+    start = None
+    for i, row in enumerate(rows):
+        if row.get("timestamp"):
+            t = parse_time(row["timestamp"])
+            start = t if start is None else start
+            ms = round((t - start) * 1000)
+        else:
+            ms = i * 15000  # SAMPLE_PERIOD_MS
+        gas = num(row["gas_value"], "%.0f")
+        motion = num(row.get("motion"), "%.0f")
+        frames.append("%d,%s,%s,%d,%d" % (
+            ms,
+            num(row["temperature"], "%.2f"),
+            num(row["humidity"], "%.1f"),
+            min(max(int(gas or 0), 0), 1023),
+            min(max(int(motion or 0), 0), 15),
+        ))
+    return frames
+
+
+def replay(port: str, baud: int, window: int, frames: list) -> tuple:
+    """Send frames with up to `window` in flight; return (decisions, alerts, summary)."""
+    import serial  # pyserial (pip install pyserial)
+
+    link = serial.Serial(port, baud, timeout=0.1)
+    # Opening the port resets a NodeMCU; wait for the firmware's banner
+    deadline = time.time() + 10
+    while True:
+        line = link.readline().decode("utf-8", "replace").strip()
+        if line.startswith(READY):
+            break
+        if time.time() > deadline:
+            sys.exit("[!] No replay banner. Is the TRACE_REPLAY firmware flashed?")
+
+    decisions, alerts, summary = [], [], None
+    sent = 0
+    started = time.time()
+    while summary is None:
+        while sent < len(frames) and sent - len(decisions) < window:
+            link.write((frames[sent] + "\n").encode())
+            sent += 1
+        if sent == len(frames) and len(decisions) == len(frames):
+            link.write(b"end\n")
+            sent += 1
+        line = link.readline().decode("utf-8", "replace").strip()
+        if line.startswith("D,"):
+            decisions.append(line[2:].split(","))
+            if len(decisions) % 500 == 0:
+                print(f"    {len(decisions)}/{len(frames)} frames")
+        elif line.startswith("A,"):
+            alerts.append(line[2:].split(","))
+        elif line.startswith("S,"):
+            summary = [float(x) for x in line[2:].split(",")]
+        elif line.startswith("#"):
+            print(f"    device: {line[1:].strip()}")
+    link.close()
+    print(f"[+] Replayed {len(frames)} frames in {time.time() - started:.1f} s wall time")
+    return decisions, alerts, summary
+
+
+def print_summary(summary: list, decisions: list):
+    frames, ticks, busy_ms, worst_frame, worst_tick, fps, alerts = summary
+    print("\n" + "=" * 60)
+    print("  ON-TARGET REPLAY")
+    print("=" * 60)
+    print(f"  Frames           : {int(frames)} ({int(ticks)} control ticks)")
+    print(f"  Pipeline busy    : {busy_ms:.0f} ms  ->  {fps:.1f} frames/s, "
+          f"{1000.0 * ticks / max(busy_ms, 1):.0f} ticks/s")
+    print(f"  Worst frame      : {worst_frame / 1000:.2f} ms")
+    print(f"  Worst decision   : {worst_tick:.0f} us (one 50 ms control tick)")
+    print(f"  Telegrams queued : {int(alerts)}")
+    if decisions:
+        fan_on = sum(1 for d in decisions if d[3] == "1")
+        print(f"  Fan on           : {100.0 * fan_on / len(decisions):.1f}% of frames")
+    print("=" * 60)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay a silo trace through the firmware on a board")
+    parser.add_argument("port", nargs="?", help="Serial port of the TRACE_REPLAY board")
+    parser.add_argument("csv", nargs="?", default=os.path.join(DATA_DIR, "silo_data_latest.csv"),
+                        help="Trace CSV (fetch_data.py format)")
+    parser.add_argument("--baud", type=int, default=DEFAULT_BAUD)
+    parser.add_argument("--window", type=int, default=DEFAULT_WINDOW, help="Frames in flight")
+    parser.add_argument("--out", type=str, default=os.path.join(DATA_DIR, "replay_results.csv"),
+                        help="Per-frame decisions CSV")
+    parser.add_argument("--frames-only", metavar="PATH", help="Write the frame file for LittleFS and exit")
+    args = parser.parse_args()
+
+    if args.frames_only:
+        # With --frames-only, the single positional argument is the CSV
+        source = args.port if args.port and os.path.exists(args.port) else args.csv
+        frames = load_frames(source)
+        with open(args.frames_only, "w") as f:
+            f.write("\n".join(frames) + "\nend\n")
+        print(f"[+] {len(frames)} frames written to {args.frames_only} (upload as /trace.csv)")
+        return
+    if not args.port:
+        parser.error("a serial port is required (or use --frames-only)")
+
+    frames = load_frames(args.csv)
+    print(f"[+] {len(frames)} frames from {args.csv}")
+    decisions, alerts, summary = replay(args.port, args.baud, args.window, frames)
+
+    with open(args.out, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["ms", "alert", "buzzer", "fan", "queued", "frame_us", "worst_tick_us"])
+        writer.writerows(decisions)
+    print(f"[+] Decisions saved to: {args.out} ({len(alerts)} frames queued a Telegram)")
+    print_summary(summary, decisions)
+
+
+if __name__ == "__main__":
+    main()
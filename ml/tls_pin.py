@@ -0,0 +1,73 @@
+"""
+Smart Grain Silo - Telegram TLS Pin
+===================================
+Connects to api.telegram.org and prints the values that `telegramPin` in
+code/code.ino accepts:
+  - the server's public key as PEM (preferred: it stays valid across
+    certificate renewals as long as Telegram keeps its key), and
+  - the SHA-1 fingerprint of the certificate ("AB:CD:..."), which must be
+    updated whenever the certificate is renewed.
+With --ca it prints the top certificate of the chain the server sends
+instead: the ESP32 build (mbedTLS) takes only a CA certificate as the pin.
+
+The public key and --ca need the `openssl` command; the fingerprint does not.
+
+Usage:
+    python tls_pin.py
+    python tls_pin.py --host api.telegram.org --port 443
+    python tls_pin.py --ca
+"""
+
+import argparse
+import hashlib
+import re
+import shutil
+import ssl
+import subprocess
+
+
+def print_ca_pin(host, port):
+    # The last certificate sent is the one closest to the root; it stays
+    # valid across renewals of the server's own certificate
+    out = subprocess.run(["openssl", "s_client", "-connect", f"{host}:{port}", "-servername", host, "-showcerts"],
+                         input="", capture_output=True, text=True).stdout
+    chain = re.findall(r"-----BEGIN CERTIFICATE-----.+?-----END CERTIFICATE-----", out, re.S)
+    if not chain:
+        raise SystemExit(f"[!] No certificate chain from {host}:{port}")
+    print(f"[+] CA pin for the ESP32 build ({len(chain)} certificates sent, using the last one):")
+    print('const char* telegramPin = R"PIN(' + chain[-1] + ')PIN";')
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Print the TLS pin for the firmware's Telegram client")
+    parser.add_argument("--host", default="api.telegram.org")
+    parser.add_argument("--port", type=int, default=443)
+    parser.add_argument("--ca", action="store_true", help="Print a CA certificate pin (ESP32 build)")
+    args = parser.parse_args()
+
+    if args.ca:
+        if not shutil.which("openssl"):
+            raise SystemExit("[!] --ca needs the openssl command")
+        print_ca_pin(args.host, args.port)
+        return
+
+    pem = ssl.get_server_certificate((args.host, args.port))
+    der = ssl.PEM_cert_to_DER_cert(pem)
+    fingerprint = ":".join("%02X" % b for b in hashlib.sha1(der).digest())
+    print(f"[+] Certificate of {args.host}:{args.port}")
+    print(f"    SHA-1 fingerprint: {fingerprint}")
+
+    if not shutil.which("openssl"):
+        print("[!] openssl not found; use the fingerprint:")
+        print(f'    const char* telegramPin = "{fingerprint}";')
+        return
+
+    key = subprocess.run(["openssl", "x509", "-pubkey", "-noout"], input=pem,
+                         capture_output=True, text=True, check=True).stdout.strip()
+    print("[+] Public key pin (paste into code.ino):")
+    # The pin must start with "-----BEGIN", right after the opening quote
+    print('const char* telegramPin = R"PIN(' + key + ')PIN";')
+
+
+if __name__ == "__main__":
+    main()